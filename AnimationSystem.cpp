@@ -0,0 +1,232 @@
+///////////////////////////////////////////////////////////////////////////////
+// animationsystem.cpp
+// ============
+// play keyframe tracks that move, turn, scale and tint the dynamic scene
+// objects, evaluating every track of a frame together
+///////////////////////////////////////////////////////////////////////////////
+
+#include "AnimationSystem.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+#include <xmmintrin.h>
+#endif
+
+// declaration of global variables
+namespace
+{
+	// number of tracks evaluated by each job
+	const size_t g_AnimationGrainSize = 1024;
+
+	// blend from one key value to the next, all four floats at once
+	// where SSE is available
+	inline void BlendKeys(const float* pFrom, const float* pTo, float weight, float* pResult)
+	{
+#if defined(__SSE__) || defined(_M_X64) || defined(_M_AMD64)
+		__m128 from = _mm_loadu_ps(pFrom);
+		__m128 to = _mm_loadu_ps(pTo);
+		_mm_storeu_ps(pResult, _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(to, from), _mm_set1_ps(weight))));
+#else
+		for (int i = 0; i < 4; i++)
+		{
+			pResult[i] = pFrom[i] + ((pTo[i] - pFrom[i]) * weight);
+		}
+#endif
+	}
+}
+
+/***********************************************************
+ *  AnimationSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+AnimationSystem::AnimationSystem()
+{
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing every track, e.g. when
+ *  the scene objects they animate are defined again.
+ ***********************************************************/
+void AnimationSystem::Clear()
+{
+	m_tracks.clear();
+	m_keyTimes.clear();
+	m_keyValues.clear();
+	m_poses.clear();
+	m_objectPoses.clear();
+}
+
+/***********************************************************
+ *  AddTrack()
+ *
+ *  This method is used for adding the keys of a track to the
+ *  shared arrays and linking it to the pose of its object,
+ *  which is created by the object's first track.  An object
+ *  has at most one track per channel.
+ ***********************************************************/
+int AnimationSystem::AddTrack(
+	uint32_t objectIndex,
+	AnimationChannel channel,
+	const KEYFRAME* pKeys,
+	size_t keyCount,
+	bool bLoop)
+{
+	int channelIndex = (int)channel;
+
+	if ((NULL == pKeys) || (keyCount == 0))
+	{
+		std::cerr << "ERROR: Animation track of object " << objectIndex << " has no keys" << std::endl;
+		return(-1);
+	}
+	for (size_t i = 1; i < keyCount; i++)
+	{
+		if (pKeys[i].time < pKeys[i - 1].time)
+		{
+			std::cerr << "ERROR: Animation track of object " << objectIndex << " has keys out of time order" << std::endl;
+			return(-1);
+		}
+	}
+
+	if (objectIndex >= m_objectPoses.size())
+	{
+		m_objectPoses.resize(objectIndex + 1, -1);
+	}
+	if (m_objectPoses[objectIndex] < 0)
+	{
+		OBJECT_POSE pose;
+		pose.objectIndex = objectIndex;
+		for (int i = 0; i < CHANNEL_COUNT; i++)
+		{
+			pose.bChannels[i] = false;
+			pose.values[i] = glm::vec4(0.0f);
+		}
+		m_objectPoses[objectIndex] = (int)m_poses.size();
+		m_poses.push_back(pose);
+	}
+
+	OBJECT_POSE& pose = m_poses[m_objectPoses[objectIndex]];
+	if (pose.bChannels[channelIndex])
+	{
+		std::cerr << "ERROR: Object " << objectIndex << " already has a track for this channel" << std::endl;
+		return(-1);
+	}
+	pose.bChannels[channelIndex] = true;
+	pose.values[channelIndex] = pKeys[0].value;
+
+	TRACK track;
+	track.firstKey = (uint32_t)m_keyTimes.size();
+	track.keyCount = (uint32_t)keyCount;
+	track.cursor = 0;
+	track.pose = (uint32_t)m_objectPoses[objectIndex];
+	track.channel = (uint32_t)channelIndex;
+	track.duration = pKeys[keyCount - 1].time;
+	track.bLoop = bLoop && (track.duration > 0.0f);
+
+	for (size_t i = 0; i < keyCount; i++)
+	{
+		m_keyTimes.push_back(pKeys[i].time);
+		m_keyValues.push_back(pKeys[i].value);
+	}
+	m_tracks.push_back(track);
+
+	return((int)m_tracks.size() - 1);
+}
+
+/***********************************************************
+ *  GetTrackCount()
+ *
+ *  This method is used for getting the number of tracks.
+ ***********************************************************/
+size_t AnimationSystem::GetTrackCount() const
+{
+	return(m_tracks.size());
+}
+
+/***********************************************************
+ *  GetPoses()
+ *
+ *  This method is used for getting the evaluated values of
+ *  the animated objects.
+ ***********************************************************/
+const std::vector<AnimationSystem::OBJECT_POSE>& AnimationSystem::GetPoses() const
+{
+	return(m_poses);
+}
+
+/***********************************************************
+ *  EvaluateRange()
+ *
+ *  This method is used for evaluating a range of tracks.
+ *  Playback moves forward, so each track starts looking for
+ *  its segment from the one it was in last frame, and only
+ *  goes back to its first key when the time wrapped around.
+ ***********************************************************/
+void AnimationSystem::EvaluateRange(double seconds, size_t begin, size_t end)
+{
+	for (size_t index = begin; index < end; index++)
+	{
+		TRACK& track = m_tracks[index];
+		const float* pTimes = m_keyTimes.data() + track.firstKey;
+		const glm::vec4* pValues = m_keyValues.data() + track.firstKey;
+		glm::vec4& result = m_poses[track.pose].values[track.channel];
+
+		float time = track.bLoop ?
+			(float)std::fmod(seconds, (double)track.duration) :
+			(float)std::min(seconds, (double)track.duration);
+		if (track.bLoop && (time < 0.0f))
+		{
+			time += track.duration;
+		}
+
+		if ((track.keyCount == 1) || (time <= pTimes[0]))
+		{
+			result = pValues[0];
+			continue;
+		}
+
+		uint32_t key = track.cursor;
+		if (time < pTimes[key])
+		{
+			key = 0;
+		}
+		while ((key + 2 < track.keyCount) && (time >= pTimes[key + 1]))
+		{
+			key++;
+		}
+		track.cursor = key;
+
+		float span = pTimes[key + 1] - pTimes[key];
+		float weight = (span > 0.0f) ? std::min((time - pTimes[key]) / span, 1.0f) : 1.0f;
+		BlendKeys(&pValues[key].x, &pValues[key + 1].x, weight, &result.x);
+	}
+}
+
+/***********************************************************
+ *  Evaluate()
+ *
+ *  This method is used for evaluating every track at a time
+ *  in seconds.  Each job evaluates a contiguous range of
+ *  tracks, whose keys sit next to each other in memory.
+ ***********************************************************/
+void AnimationSystem::Evaluate(double seconds, JobSystem* pJobSystem)
+{
+	auto evaluateRange = [&](size_t begin, size_t end)
+	{
+		EvaluateRange(seconds, begin, end);
+	};
+
+	if (NULL != pJobSystem)
+	{
+		pJobSystem->ParallelFor(m_tracks.size(), g_AnimationGrainSize, evaluateRange);
+	}
+	else
+	{
+		evaluateRange(0, m_tracks.size());
+	}
+}
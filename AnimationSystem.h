@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+// animationsystem.h
+// ============
+// play keyframe tracks that move, turn, scale and tint the dynamic scene
+// objects, evaluating every track of a frame together
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "JobSystem.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+enum class AnimationChannel { //enum declaration for the object value a track animates
+	Translation,
+	Rotation,
+	Scale,
+	Color
+};
+
+/***********************************************************
+ *  AnimationSystem
+ *
+ *  This class contains the keyframe tracks of the animated
+ *  objects.  The tracks and their keys are kept in flat
+ *  arrays, each key value being four floats, so evaluating a
+ *  track is a search for its segment, which usually is the
+ *  one it was in last frame, and one four wide multiply-add
+ *  between the two keys.  The tracks are evaluated in ranges
+ *  spread over the job system, and the results are gathered
+ *  into one pose per animated object for the scene to apply.
+ ***********************************************************/
+class AnimationSystem
+{
+public:
+	// constructor
+	AnimationSystem();
+
+	static const int CHANNEL_COUNT = 4;
+
+	// one key of a track - translation and scale in x, y and z,
+	// rotation in degrees about X, Y and Z, and color in RGBA
+	struct KEYFRAME
+	{
+		float time;
+		glm::vec4 value;
+	};
+
+	// evaluated values of one animated object
+	struct OBJECT_POSE
+	{
+		uint32_t objectIndex;
+		// true for each channel that has a track
+		bool bChannels[CHANNEL_COUNT];
+		glm::vec4 values[CHANNEL_COUNT];
+	};
+
+	// remove every track
+	void Clear();
+	// add a track animating one channel of an object, with its keys
+	// in time order - a looping track repeats every last key time and
+	// the others hold their last key, returns the track index or -1
+	int AddTrack(
+		uint32_t objectIndex,
+		AnimationChannel channel,
+		const KEYFRAME* pKeys,
+		size_t keyCount,
+		bool bLoop);
+
+	size_t GetTrackCount() const;
+	// evaluate every track at a time in seconds, spread over the job
+	// system when there is one
+	void Evaluate(double seconds, JobSystem* pJobSystem);
+	// the animated objects and their values from the last Evaluate()
+	const std::vector<OBJECT_POSE>& GetPoses() const;
+
+private:
+	// what each evaluation reads and updates of a track
+	struct TRACK
+	{
+		uint32_t firstKey;
+		uint32_t keyCount;
+		// key of the segment found last frame
+		uint32_t cursor;
+		// pose and channel the result is written to
+		uint32_t pose;
+		uint32_t channel;
+		float duration;
+		bool bLoop;
+	};
+
+	std::vector<TRACK> m_tracks;
+	// keys of all tracks, each track's keys together
+	std::vector<float> m_keyTimes;
+	std::vector<glm::vec4> m_keyValues;
+	std::vector<OBJECT_POSE> m_poses;
+	// pose of each object index, or -1
+	std::vector<int> m_objectPoses;
+
+	// evaluate a range of tracks
+	void EvaluateRange(double seconds, size_t begin, size_t end);
+};
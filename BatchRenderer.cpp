@@ -0,0 +1,508 @@
+///////////////////////////////////////////////////////////////////////////////
+// batchrenderer.cpp
+// ============
+// render the scene from a list of camera poses into offscreen images and
+// save them as PNG files, overlapping the readback and encoding of each
+// image with the rendering of the next ones
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BatchRenderer.h"
+#include "PngEncoder.h"
+#include "ResourceTracker.h"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtx/transform.hpp>
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of global variables
+namespace
+{
+	const size_t g_BatchArenaCapacity = 256 * 1024;
+	// images queued per encoder thread before the GL thread waits
+	const size_t g_QueuedJobsPerEncoder = 2;
+	// Update() calls a view may wait for its texture levels to load
+	const int g_MaxStreamingUpdates = 1000;
+	// same clipping planes as the interactive view
+	const float g_NearPlane = 0.1f;
+	const float g_FarPlane = 100.0f;
+
+	// seconds since a start time
+	double GetSecondsSince(std::chrono::steady_clock::time_point start)
+	{
+		return(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+}
+
+/***********************************************************
+ *  BatchRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BatchRenderer::BatchRenderer(SceneManager* pSceneManager, ViewManager* pViewManager)
+	: m_frameArena(g_BatchArenaCapacity)
+{
+	m_pSceneManager = pSceneManager;
+	m_pViewManager = pViewManager;
+	m_width = 0;
+	m_height = 0;
+	m_framebufferID = 0;
+	m_colorBufferID = 0;
+	m_depthBufferID = 0;
+	for (int i = 0; i < READBACK_COUNT; i++)
+	{
+		m_readbacks[i].pixelBufferID = 0;
+		m_readbacks[i].fence = 0;
+	}
+	m_drawList.pCommands = NULL;
+	m_drawList.count = 0;
+	m_maxQueuedJobs = 0;
+	m_activeJobs = 0;
+	m_bStopRequested = false;
+	m_failedImages = 0;
+	m_encodeSeconds = 0.0;
+}
+
+/***********************************************************
+ *  ~BatchRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+BatchRenderer::~BatchRenderer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  LoadPoses()
+ *
+ *  This method is used for reading camera poses from a text
+ *  file, one view per line as its name followed by the
+ *  camera position and the point it looks at.
+ ***********************************************************/
+bool BatchRenderer::LoadPoses(const char* filename, std::vector<CAMERA_POSE>& poses)
+{
+	std::ifstream file(filename);
+	std::string line;
+	int lineNumber = 0;
+
+	if (!file)
+	{
+		std::cerr << "ERROR: Could not open the camera poses:" << filename << std::endl;
+		return(false);
+	}
+
+	while (std::getline(file, line))
+	{
+		lineNumber++;
+		std::istringstream stream(line);
+		CAMERA_POSE pose;
+
+		size_t first = line.find_first_not_of(" \t\r");
+		if ((first == std::string::npos) || (line[first] == '#'))
+		{
+			continue;
+		}
+		if (!(stream >> pose.name
+			>> pose.position.x >> pose.position.y >> pose.position.z
+			>> pose.target.x >> pose.target.y >> pose.target.z))
+		{
+			std::cerr << "ERROR: Bad camera pose at " << filename << ":" << lineNumber << std::endl;
+			return(false);
+		}
+		poses.push_back(pose);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  BuildOrbit()
+ *
+ *  This method is used for making a turntable: viewCount
+ *  cameras evenly spaced on a circle of the given radius,
+ *  height above the target, all looking at the target.
+ ***********************************************************/
+void BatchRenderer::BuildOrbit(
+	int viewCount,
+	float radius,
+	float height,
+	const glm::vec3& target,
+	std::vector<CAMERA_POSE>& poses)
+{
+	for (int i = 0; i < viewCount; i++)
+	{
+		CAMERA_POSE pose;
+		char name[32];
+		float angle = glm::two_pi<float>() * i / viewCount;
+
+		snprintf(name, sizeof(name), "orbit_%03d", i);
+		pose.name = name;
+		pose.position = target + glm::vec3(sin(angle) * radius, height, cos(angle) * radius);
+		pose.target = target;
+		poses.push_back(pose);
+	}
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the offscreen target,
+ *  the pixel buffers the images are read back through, and
+ *  the encoder threads.
+ ***********************************************************/
+bool BatchRenderer::Create(int width, int height, unsigned int encoderCount)
+{
+	size_t imageBytes = (size_t)width * height * 4;
+
+	Destroy();
+
+	m_width = width;
+	m_height = height;
+
+	glGenFramebuffers(1, &m_framebufferID);
+	glGenRenderbuffers(1, &m_colorBufferID);
+	glGenRenderbuffers(1, &m_depthBufferID);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	ResourceTracker::Allocate(ResourceCategory::Framebuffer, m_framebufferID, 0, "Batch renderer");
+	ResourceTracker::Allocate(ResourceCategory::Renderbuffer, m_colorBufferID, imageBytes, "Batch renderer");
+	ResourceTracker::Allocate(ResourceCategory::Renderbuffer, m_depthBufferID, imageBytes, "Batch renderer");
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBufferID);
+	bool bComplete = (glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	if (bComplete == false)
+	{
+		std::cerr << "ERROR: Batch render framebuffer is incomplete" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	for (int i = 0; i < READBACK_COUNT; i++)
+	{
+		glGenBuffers(1, &m_readbacks[i].pixelBufferID);
+		glBindBuffer(GL_PIXEL_PACK_BUFFER, m_readbacks[i].pixelBufferID);
+		glBufferData(GL_PIXEL_PACK_BUFFER, imageBytes, NULL, GL_STREAM_READ);
+		ResourceTracker::Allocate(ResourceCategory::Buffer, m_readbacks[i].pixelBufferID, imageBytes, "Batch renderer");
+		m_readbacks[i].fence = 0;
+		m_readbacks[i].filename.clear();
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	if (encoderCount == 0)
+	{
+		encoderCount = 1;
+	}
+	m_bStopRequested = false;
+	m_maxQueuedJobs = encoderCount * g_QueuedJobsPerEncoder;
+	for (unsigned int i = 0; i < encoderCount; i++)
+	{
+		m_encoderThreads.push_back(std::thread(&BatchRenderer::EncoderThreadMain, this));
+	}
+
+	std::cout << "INFO: Batch renderer, " << width << "x" << height << ", "
+		<< READBACK_COUNT << " readbacks in flight, " << encoderCount << " encoder threads" << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for letting the encoder threads write
+ *  the queued images, then freeing the OpenGL objects.
+ ***********************************************************/
+void BatchRenderer::Destroy()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopRequested = true;
+	}
+	m_condition.notify_all();
+	for (std::thread& thread : m_encoderThreads)
+	{
+		thread.join();
+	}
+	m_encoderThreads.clear();
+
+	for (int i = 0; i < READBACK_COUNT; i++)
+	{
+		READBACK& readback = m_readbacks[i];
+		if (readback.fence != 0)
+		{
+			glDeleteSync(readback.fence);
+			readback.fence = 0;
+		}
+		if (readback.pixelBufferID != 0)
+		{
+			glDeleteBuffers(1, &readback.pixelBufferID);
+			ResourceTracker::Release(ResourceCategory::Buffer, readback.pixelBufferID);
+			readback.pixelBufferID = 0;
+		}
+		readback.filename.clear();
+	}
+
+	if (m_framebufferID != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		glDeleteRenderbuffers(1, &m_colorBufferID);
+		glDeleteRenderbuffers(1, &m_depthBufferID);
+		ResourceTracker::Release(ResourceCategory::Framebuffer, m_framebufferID);
+		ResourceTracker::Release(ResourceCategory::Renderbuffer, m_colorBufferID);
+		ResourceTracker::Release(ResourceCategory::Renderbuffer, m_depthBufferID);
+	}
+	m_framebufferID = 0;
+	m_colorBufferID = 0;
+	m_depthBufferID = 0;
+}
+
+/***********************************************************
+ *  RenderViews()
+ *
+ *  This method is used for rendering every pose.  A view's
+ *  readback is finished when its pixel buffer is needed for
+ *  a later view, or after the last view, and the images per
+ *  second are reported once every file is written.
+ ***********************************************************/
+bool BatchRenderer::RenderViews(const std::vector<CAMERA_POSE>& poses, const char* outputDirectory, float fieldOfViewDegrees)
+{
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	double renderSeconds = 0.0;
+	double readbackSeconds = 0.0;
+
+	if (m_framebufferID == 0)
+	{
+		return(false);
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_failedImages = 0;
+		m_encodeSeconds = 0.0;
+	}
+
+	for (size_t i = 0; i < poses.size(); i++)
+	{
+		READBACK& readback = m_readbacks[i % READBACK_COUNT];
+
+		std::chrono::steady_clock::time_point readbackStart = std::chrono::steady_clock::now();
+		FinishReadback(readback);
+		readbackSeconds += GetSecondsSince(readbackStart);
+
+		std::chrono::steady_clock::time_point renderStart = std::chrono::steady_clock::now();
+		readback.filename = std::string(outputDirectory) + "/" + poses[i].name + ".png";
+		RenderView(poses[i], fieldOfViewDegrees, readback);
+		renderSeconds += GetSecondsSince(renderStart);
+	}
+
+	// finish the last readbacks in the order they were started
+	std::chrono::steady_clock::time_point readbackStart = std::chrono::steady_clock::now();
+	for (size_t i = poses.size(); i < poses.size() + READBACK_COUNT; i++)
+	{
+		FinishReadback(m_readbacks[i % READBACK_COUNT]);
+	}
+	readbackSeconds += GetSecondsSince(readbackStart);
+
+	WaitForEncoders();
+	double totalSeconds = GetSecondsSince(start);
+
+	size_t failedImages = 0;
+	double encodeSeconds = 0.0;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		failedImages = m_failedImages;
+		encodeSeconds = m_encodeSeconds;
+	}
+
+	std::cout << "INFO: Batch rendered " << poses.size() << " views in " << totalSeconds << " s, "
+		<< (poses.size() / totalSeconds) << " images per second" << std::endl;
+	if (poses.size() > 0)
+	{
+		std::cout << "INFO:   per view, render ms:" << (renderSeconds * 1000.0 / poses.size())
+			<< ", readback ms:" << (readbackSeconds * 1000.0 / poses.size())
+			<< ", encode ms:" << (encodeSeconds * 1000.0 / poses.size()) << std::endl;
+	}
+
+	return(failedImages == 0);
+}
+
+/***********************************************************
+ *  RenderView()
+ *
+ *  This method is used for drawing one pose into the
+ *  offscreen target and starting the copy of its pixels into
+ *  a pixel buffer.  The draw list is rebuilt until the
+ *  texture levels it asks for have been streamed in, so every
+ *  image shows the textures at full detail.
+ ***********************************************************/
+void BatchRenderer::RenderView(const CAMERA_POSE& pose, float fieldOfViewDegrees, READBACK& readback)
+{
+	VIEW_STATE viewState;
+
+	viewState.cameraPosition = pose.position;
+	viewState.cameraFront = glm::normalize(pose.target - pose.position);
+	viewState.view = glm::lookAt(pose.position, pose.target, glm::vec3(0.0f, 1.0f, 0.0f));
+	viewState.projection = glm::perspective(
+		glm::radians(fieldOfViewDegrees), (float)m_width / (float)m_height, g_NearPlane, g_FarPlane);
+	viewState.inputTime = 0.0;
+	viewState.viewportHeight = m_height;
+
+	for (int update = 0; update < g_MaxStreamingUpdates; update++)
+	{
+		m_frameArena.Reset();
+		m_pSceneManager->BuildDrawList(viewState, m_frameArena, m_drawList);
+		m_pSceneManager->UpdateTextureStreaming();
+		if (m_pSceneManager->IsStreamingTextures() == false)
+		{
+			break;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glViewport(0, 0, m_width, m_height);
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	m_pViewManager->ApplyViewState(viewState);
+	m_pSceneManager->RenderScene(m_drawList);
+
+	// the copy runs on the GPU, the fence tells when it is done
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixelBufferID);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	glReadPixels(0, 0, m_width, m_height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  FinishReadback()
+ *
+ *  This method is used for waiting until the copy into a
+ *  pixel buffer is done, then mapping it and handing the
+ *  pixels to the encoder threads.  When the encoders are
+ *  behind, it waits for room in their queue first.
+ ***********************************************************/
+void BatchRenderer::FinishReadback(READBACK& readback)
+{
+	ENCODE_JOB job;
+
+	if (readback.filename.empty())
+	{
+		return;
+	}
+
+	if (readback.fence != 0)
+	{
+		glClientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(readback.fence);
+		readback.fence = 0;
+	}
+
+	job.filename.swap(readback.filename);
+	job.pixels.resize((size_t)m_width * m_height * 4);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pixelBufferID);
+	const uint8_t* pMapped = (const uint8_t*)glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, job.pixels.size(), GL_MAP_READ_BIT);
+	if (NULL != pMapped)
+	{
+		memcpy(job.pixels.data(), pMapped, job.pixels.size());
+		glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+	}
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	if (NULL == pMapped)
+	{
+		std::cerr << "ERROR: Could not map the pixels of:" << job.filename << std::endl;
+		m_failedImages++;
+		return;
+	}
+	m_condition.wait(lock, [this]() { return(m_encodeJobs.size() < m_maxQueuedJobs); });
+	m_encodeJobs.push_back(std::move(job));
+	lock.unlock();
+	m_condition.notify_all();
+}
+
+/***********************************************************
+ *  WaitForEncoders()
+ *
+ *  This method is used for blocking until the queue is empty
+ *  and no encoder thread is still writing an image.
+ ***********************************************************/
+void BatchRenderer::WaitForEncoders()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_condition.wait(lock, [this]() { return(m_encodeJobs.empty() && (m_activeJobs == 0)); });
+}
+
+/***********************************************************
+ *  EncoderThreadMain()
+ *
+ *  This method is used for taking queued images, turning the
+ *  bottom up RGBA rows OpenGL reads into top down RGB rows,
+ *  and writing them as PNG files, until Destroy() is called
+ *  and the queue is empty.
+ ***********************************************************/
+void BatchRenderer::EncoderThreadMain()
+{
+	std::vector<uint8_t> rgb;
+
+	while (true)
+	{
+		ENCODE_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]() { return(m_bStopRequested || !m_encodeJobs.empty()); });
+			if (m_encodeJobs.empty())
+			{
+				return;
+			}
+			job = std::move(m_encodeJobs.front());
+			m_encodeJobs.pop_front();
+			m_activeJobs++;
+		}
+		// the queue has room for the GL thread again
+		m_condition.notify_all();
+
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		rgb.resize((size_t)m_width * m_height * 3);
+		for (int y = 0; y < m_height; y++)
+		{
+			const uint8_t* pSource = job.pixels.data() + (size_t)(m_height - 1 - y) * m_width * 4;
+			uint8_t* pDestination = rgb.data() + (size_t)y * m_width * 3;
+			for (int x = 0; x < m_width; x++)
+			{
+				pDestination[x * 3 + 0] = pSource[x * 4 + 0];
+				pDestination[x * 3 + 1] = pSource[x * 4 + 1];
+				pDestination[x * 3 + 2] = pSource[x * 4 + 2];
+			}
+		}
+		bool bWritten = PngEncoder::WritePng(job.filename.c_str(), rgb.data(), m_width, m_height, 3);
+		double seconds = GetSecondsSince(start);
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_activeJobs--;
+			m_encodeSeconds += seconds;
+			if (bWritten == false)
+			{
+				m_failedImages++;
+			}
+		}
+		m_condition.notify_all();
+	}
+}
@@ -0,0 +1,131 @@
+///////////////////////////////////////////////////////////////////////////////
+// batchrenderer.h
+// ============
+// render the scene from a list of camera poses into offscreen images and
+// save them as PNG files, overlapping the readback and encoding of each
+// image with the rendering of the next ones
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "FrameArena.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  BatchRenderer
+ *
+ *  This class contains an offscreen framebuffer, a ring of
+ *  pixel buffers and a pool of encoder threads.  Each view
+ *  is drawn into the framebuffer and copied into the next
+ *  pixel buffer, which the GPU does in the background, and
+ *  is only mapped when its pixel buffer comes around again,
+ *  by which time the next views have been submitted.  The
+ *  mapped pixels go to the encoder threads, which flip and
+ *  compress them into PNG files while the GL thread keeps
+ *  rendering.
+ ***********************************************************/
+class BatchRenderer
+{
+public:
+	// one camera to render from
+	struct CAMERA_POSE
+	{
+		std::string name;
+		glm::vec3 position;
+		glm::vec3 target;
+	};
+
+	// constructor
+	BatchRenderer(SceneManager* pSceneManager, ViewManager* pViewManager);
+	// destructor
+	~BatchRenderer();
+
+	// pixel buffers in flight, so a readback is mapped two views
+	// after it was started
+	static const int READBACK_COUNT = 3;
+
+	// read poses from a text file with one "name px py pz tx ty tz"
+	// line per view, where lines starting with # are comments
+	static bool LoadPoses(const char* filename, std::vector<CAMERA_POSE>& poses);
+	// make viewCount poses evenly spaced on a circle around target
+	static void BuildOrbit(
+		int viewCount,
+		float radius,
+		float height,
+		const glm::vec3& target,
+		std::vector<CAMERA_POSE>& poses);
+
+	// create the framebuffer and pixel buffers for images of the
+	// given size and start the encoder threads
+	bool Create(int width, int height, unsigned int encoderCount);
+	// wait for the encoder threads and free everything
+	void Destroy();
+
+	// render every pose into outputDirectory/<name>.png, returns
+	// false when an image could not be written
+	bool RenderViews(const std::vector<CAMERA_POSE>& poses, const char* outputDirectory, float fieldOfViewDegrees);
+
+private:
+	// a readback started into a pixel buffer
+	struct READBACK
+	{
+		GLuint pixelBufferID;
+		GLsync fence;
+		// image file it belongs to, empty while the buffer is free
+		std::string filename;
+	};
+
+	// an image waiting for an encoder thread
+	struct ENCODE_JOB
+	{
+		std::string filename;
+		std::vector<uint8_t> pixels;
+	};
+
+	SceneManager* m_pSceneManager;
+	ViewManager* m_pViewManager;
+	int m_width;
+	int m_height;
+
+	GLuint m_framebufferID;
+	GLuint m_colorBufferID;
+	GLuint m_depthBufferID;
+	READBACK m_readbacks[READBACK_COUNT];
+
+	// draw list of the view being rendered
+	FrameArena m_frameArena;
+	SceneManager::DRAW_LIST m_drawList;
+
+	// encoder threads and the queue guarded by the mutex
+	std::vector<std::thread> m_encoderThreads;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::deque<ENCODE_JOB> m_encodeJobs;
+	size_t m_maxQueuedJobs;
+	size_t m_activeJobs;
+	bool m_bStopRequested;
+	// results of the encoder threads, guarded by the mutex
+	size_t m_failedImages;
+	double m_encodeSeconds;
+
+	// body of each encoder thread
+	void EncoderThreadMain();
+	// draw one view into the framebuffer and start its readback
+	void RenderView(const CAMERA_POSE& pose, float fieldOfViewDegrees, READBACK& readback);
+	// wait for a readback and queue its pixels for encoding
+	void FinishReadback(READBACK& readback);
+	// block until every queued image has been written
+	void WaitForEncoders();
+};
@@ -0,0 +1,681 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmarkmain.cpp
+// ============
+// entry point of the benchmark executable, which times the hot functions of
+// the scene and view managers and saves the results for comparing builds,
+// and reports how the scene systems scale on generated scenes
+///////////////////////////////////////////////////////////////////////////////
+
+#include <iostream>         // error handling and output
+#include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <chrono>           // timing the generated scenes
+#include <thread>           // hardware thread count
+#include <random>           // generated scenes
+#include <vector>
+
+#include <GL/glew.h>        // GLEW library
+
+// GLM Math Header inclusions
+#include <glm/glm.hpp>
+#include <glm/gtx/transform.hpp>
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "JobSystem.h"
+#include "FrameArena.h"
+#include "LooseOctree.h"
+#include "AnimationSystem.h"
+#include "MicroBenchmark.h"
+#include "HeadlessContext.h"
+#include "ShaderManager.h"
+
+// Namespace for declaring global variables
+namespace
+{
+	// size of the surface behind the OpenGL context, the same as the
+	// application window
+	const int SURFACE_WIDTH = 1000;
+	const int SURFACE_HEIGHT = 800;
+	// the same GLSL files as the application
+	const char* const VERTEX_SHADER_PATH = "../../Utilities/shaders/vertexShader.glsl";
+	const char* const FRAGMENT_SHADER_PATH = "../../Utilities/shaders/fragmentShader.glsl";
+	// file the results are saved to unless another one is given
+	const char* const DEFAULT_RESULTS_PATH = "benchmark.json";
+	// generated scenes are scattered over a world of this half size,
+	// with the same seed each run so the builds can be compared
+	const float WORLD_HALF_SIZE = 100.0f;
+	const unsigned int RANDOM_SEED = 1234;
+}
+
+/***********************************************************
+ *  GENERATED_SCENE
+ *
+ *  Layout of the scene objects generated for a benchmark.
+ ***********************************************************/
+struct GENERATED_SCENE
+{
+	size_t objectCount;
+	// a square grid in front of the camera, each object turned one
+	// degree more about Y, instead of scattered over the world
+	bool bGrid;
+	// every basic shape in turn instead of only boxes
+	bool bMixedShapes;
+	// sizes of 0.1 to 2 units on each axis instead of 0.5
+	bool bRandomSizes;
+	// turned a random amount about every axis
+	bool bRandomRotations;
+};
+
+// Function declarations - all functions that are called manually
+// need to be pre-declared at the beginning of the source code.
+void GenerateSceneObjects(
+	const GENERATED_SCENE& layout,
+	std::mt19937& random,
+	SceneManager* pScene,
+	std::vector<SceneManager::SCENE_OBJECT>& objects);
+double GetMillisecondsSince(std::chrono::steady_clock::time_point start);
+unsigned int GetHardwareThreadCount();
+void RunJobScalingReport(size_t objectCount);
+void RunOctreeBenchmark(size_t objectCount);
+void RunPickBenchmark(size_t objectCount);
+void RunAnimationBenchmark(size_t trackCount);
+bool InitializeGLEW();
+bool RunMicroBenchmarks(const char* filename);
+
+
+/***********************************************************
+ *  main(int, char*)
+ *
+ *  This function gets called after the benchmarks have been
+ *  launched.  Without options it runs the micro benchmarks
+ *  and saves them to the file given as the only argument, or
+ *  to benchmark.json.  The other reports are run with:
+ *    --job-scaling [objects]   draw list building per thread count
+ *    --octree [objects]        spatial index with 1% moving
+ *    --pick [objects]          mouse picking latency
+ *    --animation [tracks]      keyframe tracks, 10k and 100k
+ ***********************************************************/
+int main(int argc, char* argv[])
+{
+	size_t count = (argc > 2) ? (size_t)atol(argv[2]) : 0;
+
+	if ((argc > 1) && (strcmp(argv[1], "--job-scaling") == 0))
+	{
+		RunJobScalingReport((count > 0) ? count : 100000);
+		return(EXIT_SUCCESS);
+	}
+	if ((argc > 1) && (strcmp(argv[1], "--octree") == 0))
+	{
+		RunOctreeBenchmark((count > 0) ? count : 100000);
+		return(EXIT_SUCCESS);
+	}
+	if ((argc > 1) && (strcmp(argv[1], "--pick") == 0))
+	{
+		RunPickBenchmark((count > 0) ? count : 50000);
+		return(EXIT_SUCCESS);
+	}
+	if ((argc > 1) && (strcmp(argv[1], "--animation") == 0))
+	{
+		if (count > 0)
+		{
+			RunAnimationBenchmark(count);
+		}
+		else
+		{
+			RunAnimationBenchmark(10000);
+			RunAnimationBenchmark(100000);
+		}
+		return(EXIT_SUCCESS);
+	}
+
+	return(RunMicroBenchmarks((argc > 1) ? argv[1] : DEFAULT_RESULTS_PATH) ? EXIT_SUCCESS : EXIT_FAILURE);
+}
+
+/***********************************************************
+ *	GenerateSceneObjects()
+ *
+ *  This function is used to make up the objects of a
+ *  benchmark scene, drawing from random for the scattered
+ *  positions, the sizes and the rotations.  The objects are
+ *  dynamic, and are added to the scene when there is one.
+ ***********************************************************/
+void GenerateSceneObjects(
+	const GENERATED_SCENE& layout,
+	std::mt19937& random,
+	SceneManager* pScene,
+	std::vector<SceneManager::SCENE_OBJECT>& objects)
+{
+	const ShapeType SHAPES[] = { ShapeType::Box, ShapeType::Plane, ShapeType::Sphere, ShapeType::Cylinder };
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+	size_t side = 1;
+	while (side * side < layout.objectCount)
+	{
+		side++;
+	}
+
+	objects.resize(layout.objectCount);
+	for (size_t i = 0; i < layout.objectCount; i++)
+	{
+		SceneManager::SCENE_OBJECT& object = objects[i];
+		object.shape = layout.bMixedShapes ? SHAPES[i % 4] : ShapeType::Box;
+		object.color = glm::vec4(1.0f);
+		object.UVscale = glm::vec2(1.0f);
+		object.bStatic = false;
+		object.XrotationDegrees = 0.0f;
+		object.YrotationDegrees = 0.0f;
+		object.ZrotationDegrees = 0.0f;
+
+		if (layout.bGrid)
+		{
+			object.YrotationDegrees = (float)(i % 360);
+			object.positionXYZ = glm::vec3((float)(i % side) - side / 2.0f, 0.0f, -(float)(i / side));
+		}
+		else
+		{
+			object.positionXYZ = glm::vec3(
+				(unit(random) * 2.0f - 1.0f) * WORLD_HALF_SIZE,
+				unit(random) * 10.0f,
+				(unit(random) * 2.0f - 1.0f) * WORLD_HALF_SIZE);
+		}
+
+		object.scaleXYZ = glm::vec3(0.5f);
+		if (layout.bRandomSizes)
+		{
+			object.scaleXYZ = glm::vec3(0.1f) + glm::vec3(unit(random), unit(random), unit(random)) * 1.9f;
+		}
+		if (layout.bRandomRotations)
+		{
+			object.XrotationDegrees = unit(random) * 360.0f;
+			object.YrotationDegrees = unit(random) * 360.0f;
+			object.ZrotationDegrees = unit(random) * 360.0f;
+		}
+
+		if (NULL != pScene)
+		{
+			pScene->AddSceneObject(object);
+		}
+	}
+}
+
+/***********************************************************
+ *	GetMillisecondsSince()
+ *
+ *  This function is used to get the milliseconds passed
+ *  since a time taken from the steady clock.
+ ***********************************************************/
+double GetMillisecondsSince(std::chrono::steady_clock::time_point start)
+{
+	return(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+}
+
+/***********************************************************
+ *	GetHardwareThreadCount()
+ *
+ *  This function is used to get the number of hardware
+ *  threads, at least 1.
+ ***********************************************************/
+unsigned int GetHardwareThreadCount()
+{
+	unsigned int threads = std::thread::hardware_concurrency();
+
+	return((threads > 0) ? threads : 1);
+}
+
+/***********************************************************
+ *	RunJobScalingReport()
+ *
+ *  This function is used to time the draw list building for
+ *  a generated scene with 1 to N job threads and print the
+ *  speedup over a single thread, then compare building four
+ *  views one by one with building them together.
+ ***********************************************************/
+void RunJobScalingReport(size_t objectCount)
+{
+	const int TIMED_BUILDS = 20;
+	std::mt19937 random(RANDOM_SEED);
+	SceneManager scene(NULL);
+	std::vector<SceneManager::SCENE_OBJECT> objects;
+	FrameArena frameArena(0);
+	SceneManager::DRAW_LIST drawList;
+	VIEW_STATE viewState;
+
+	// a square grid of small boxes in front of the camera
+	GENERATED_SCENE layout = { objectCount, true, false, false, false };
+	GenerateSceneObjects(layout, random, &scene, objects);
+
+	viewState.cameraPosition = glm::vec3(0.0f, 20.0f, 10.0f);
+	viewState.cameraFront = glm::normalize(glm::vec3(0.0f, -0.5f, -1.0f));
+	viewState.view = glm::lookAt(viewState.cameraPosition, viewState.cameraPosition + viewState.cameraFront, glm::vec3(0.0f, 1.0f, 0.0f));
+	viewState.projection = glm::perspective(glm::radians(60.0f), 1000.0f / 800.0f, 0.1f, 100.0f);
+	viewState.viewportHeight = 800;
+
+	unsigned int maxThreads = GetHardwareThreadCount();
+
+	std::cout << "INFO: Draw list build scaling, " << objectCount << " objects" << std::endl;
+	double singleThreadMilliseconds = 0.0;
+	double allThreadsMilliseconds = 0.0;
+	for (unsigned int threads = 1; threads <= maxThreads; threads++)
+	{
+		JobSystem jobs(threads - 1);
+		scene.SetJobSystem(&jobs);
+
+		// warm up the caches and grow the arena to fit a frame
+		frameArena.Reset();
+		scene.BuildDrawList(viewState, frameArena, drawList);
+		frameArena.Reset();
+
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < TIMED_BUILDS; i++)
+		{
+			frameArena.Reset();
+			scene.BuildDrawList(viewState, frameArena, drawList);
+		}
+		double milliseconds = GetMillisecondsSince(start) / TIMED_BUILDS;
+
+		if (threads == 1)
+		{
+			singleThreadMilliseconds = milliseconds;
+		}
+		std::cout << "INFO:   threads:" << threads
+			<< ", build ms:" << milliseconds
+			<< ", visible:" << drawList.count
+			<< ", speedup:" << (singleThreadMilliseconds / milliseconds) << std::endl;
+		allThreadsMilliseconds = milliseconds;
+	}
+
+	// four cameras a little apart, as in the quad view layout
+	VIEW_STATE views[VIEW_SET::MAX_VIEWS];
+	SceneManager::DRAW_LIST drawLists[VIEW_SET::MAX_VIEWS];
+	for (int view = 0; view < VIEW_SET::MAX_VIEWS; view++)
+	{
+		views[view] = viewState;
+		views[view].cameraFront = glm::vec3(glm::rotate(glm::radians(10.0f * view), glm::vec3(0.0f, 1.0f, 0.0f)) *
+			glm::vec4(viewState.cameraFront, 0.0f));
+		views[view].view = glm::lookAt(views[view].cameraPosition, views[view].cameraPosition + views[view].cameraFront, glm::vec3(0.0f, 1.0f, 0.0f));
+	}
+
+	JobSystem jobs(maxThreads - 1);
+	scene.SetJobSystem(&jobs);
+	frameArena.Reset();
+	scene.BuildDrawLists(views, VIEW_SET::MAX_VIEWS, frameArena, drawLists);
+
+	auto start = std::chrono::steady_clock::now();
+	for (int i = 0; i < TIMED_BUILDS; i++)
+	{
+		frameArena.Reset();
+		for (int view = 0; view < VIEW_SET::MAX_VIEWS; view++)
+		{
+			scene.BuildDrawList(views[view], frameArena, drawLists[view]);
+		}
+	}
+	double separateMilliseconds = GetMillisecondsSince(start) / TIMED_BUILDS;
+
+	start = std::chrono::steady_clock::now();
+	for (int i = 0; i < TIMED_BUILDS; i++)
+	{
+		frameArena.Reset();
+		scene.BuildDrawLists(views, VIEW_SET::MAX_VIEWS, frameArena, drawLists);
+	}
+	double sharedMilliseconds = GetMillisecondsSince(start) / TIMED_BUILDS;
+
+	std::cout << "INFO:   " << VIEW_SET::MAX_VIEWS << " views, one by one ms:" << separateMilliseconds
+		<< ", together ms:" << sharedMilliseconds
+		<< ", cost over one view:" << (sharedMilliseconds / allThreadsMilliseconds) << std::endl;
+	scene.SetJobSystem(NULL);
+}
+
+/***********************************************************
+ *	RunOctreeBenchmark()
+ *
+ *  This function is used to time the spatial index on a
+ *  generated scene: inserting every object, then for each
+ *  frame moving 1% of them and running a frustum, a sphere
+ *  and a ray query.  The frustum query is checked against
+ *  testing every object.
+ ***********************************************************/
+void RunOctreeBenchmark(size_t objectCount)
+{
+	const int FRAMES = 100;
+	std::mt19937 random(RANDOM_SEED);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	std::vector<SceneManager::SCENE_OBJECT> objects;
+	std::vector<BOUNDING_BOX> bounds(objectCount);
+	std::vector<glm::vec3> velocities(objectCount);
+	std::vector<uint32_t> results(objectCount);
+
+	// boxes of 0.1 to 2 units scattered over a flat world, upright so
+	// their bounds are their sizes
+	GENERATED_SCENE layout = { objectCount, false, false, true, false };
+	GenerateSceneObjects(layout, random, NULL, objects);
+	for (size_t i = 0; i < objectCount; i++)
+	{
+		bounds[i].minXYZ = objects[i].positionXYZ - objects[i].scaleXYZ * 0.5f;
+		bounds[i].maxXYZ = objects[i].positionXYZ + objects[i].scaleXYZ * 0.5f;
+		velocities[i] = glm::vec3(unit(random) - 0.5f, 0.0f, unit(random) - 0.5f);
+	}
+
+	// smallest cells of 4 units hold a few dozen objects each here
+	LooseOctree octree(glm::vec3(0.0f), 16.0f, 2.0f);
+	auto start = std::chrono::steady_clock::now();
+	for (size_t i = 0; i < objectCount; i++)
+	{
+		octree.Insert((uint32_t)i, bounds[i]);
+	}
+	double insertMilliseconds = GetMillisecondsSince(start);
+
+	std::cout << "INFO: Octree benchmark, " << objectCount << " objects, "
+		<< octree.GetNodeCount() << " nodes" << std::endl;
+	std::cout << "INFO:   insert ms:" << insertMilliseconds
+		<< ", inserts per second:" << (objectCount / (insertMilliseconds / 1000.0)) << std::endl;
+
+	VIEW_STATE viewState;
+	viewState.projection = glm::perspective(glm::radians(60.0f), 1000.0f / 800.0f, 0.1f, 100.0f);
+
+	size_t movingCount = (objectCount + 99) / 100;
+	double updateMilliseconds = 0.0;
+	double frustumMilliseconds = 0.0;
+	double bruteForceMilliseconds = 0.0;
+	double sphereMilliseconds = 0.0;
+	double rayMilliseconds = 0.0;
+	size_t frustumHits = 0;
+	size_t sphereHits = 0;
+	size_t rayHits = 0;
+	size_t mismatches = 0;
+
+	for (int frame = 0; frame < FRAMES; frame++)
+	{
+		// move a different 1% of the objects each frame
+		start = std::chrono::steady_clock::now();
+		for (size_t m = 0; m < movingCount; m++)
+		{
+			size_t i = (frame * movingCount + m) % objectCount;
+			bounds[i].minXYZ += velocities[i];
+			bounds[i].maxXYZ += velocities[i];
+			octree.Update((uint32_t)i, bounds[i]);
+		}
+		updateMilliseconds += GetMillisecondsSince(start);
+
+		// a camera circling the world, looking across it
+		float angle = frame * 0.0628f;
+		glm::vec3 eye(std::cos(angle) * WORLD_HALF_SIZE * 0.5f, 5.0f, std::sin(angle) * WORLD_HALF_SIZE * 0.5f);
+		viewState.view = glm::lookAt(eye, glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+		FRUSTUM frustum = ExtractFrustum(viewState.projection * viewState.view);
+
+		start = std::chrono::steady_clock::now();
+		size_t visible = octree.QueryFrustum(frustum, results.data());
+		frustumMilliseconds += GetMillisecondsSince(start);
+		frustumHits += visible;
+
+		start = std::chrono::steady_clock::now();
+		size_t bruteForceVisible = 0;
+		for (size_t i = 0; i < objectCount; i++)
+		{
+			bruteForceVisible += IsBoxInFrustum(frustum, bounds[i]) ? 1 : 0;
+		}
+		bruteForceMilliseconds += GetMillisecondsSince(start);
+		mismatches += (visible != bruteForceVisible) ? 1 : 0;
+
+		start = std::chrono::steady_clock::now();
+		sphereHits += octree.QuerySphere(eye, 10.0f, results.data());
+		sphereMilliseconds += GetMillisecondsSince(start);
+
+		start = std::chrono::steady_clock::now();
+		rayHits += octree.QueryRay(eye, glm::normalize(glm::vec3(0.0f, 2.0f, 0.0f) - eye), 1000.0f, results.data());
+		rayMilliseconds += GetMillisecondsSince(start);
+	}
+
+	std::cout << "INFO:   update ms per frame:" << (updateMilliseconds / FRAMES)
+		<< " for " << movingCount << " objects, updates per second:"
+		<< (movingCount * FRAMES / (updateMilliseconds / 1000.0)) << std::endl;
+	std::cout << "INFO:   frustum query ms:" << (frustumMilliseconds / FRAMES)
+		<< ", visible:" << (frustumHits / FRAMES)
+		<< ", testing every object ms:" << (bruteForceMilliseconds / FRAMES)
+		<< ", mismatched frames:" << mismatches << std::endl;
+	std::cout << "INFO:   sphere query ms:" << (sphereMilliseconds / FRAMES)
+		<< ", found:" << (sphereHits / FRAMES) << std::endl;
+	std::cout << "INFO:   ray query ms:" << (rayMilliseconds / FRAMES)
+		<< ", found:" << (rayHits / FRAMES) << std::endl;
+	std::cout << "INFO:   nodes after moving:" << octree.GetNodeCount() << std::endl;
+}
+
+/***********************************************************
+ *	RunPickBenchmark()
+ *
+ *  This function is used to time picking on a generated
+ *  scene of every basic shape: the first pick, which builds
+ *  the bounding volume hierarchy, then picks at random points
+ *  of the view, and picks after 1% of the objects moved.
+ ***********************************************************/
+void RunPickBenchmark(size_t objectCount)
+{
+	const int PICKS = 10000;
+	std::mt19937 random(RANDOM_SEED);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	SceneManager scene(NULL);
+	std::vector<SceneManager::SCENE_OBJECT> objects;
+	SceneManager::PICK_RESULT pick;
+	VIEW_STATE viewState;
+
+	// shapes of 0.1 to 2 units, turned every way, over a flat world
+	GENERATED_SCENE layout = { objectCount, false, true, true, true };
+	GenerateSceneObjects(layout, random, &scene, objects);
+
+	viewState.cameraPosition = glm::vec3(0.0f, 20.0f, WORLD_HALF_SIZE);
+	viewState.cameraFront = glm::normalize(glm::vec3(0.0f, -0.3f, -1.0f));
+	viewState.view = glm::lookAt(viewState.cameraPosition, viewState.cameraPosition + viewState.cameraFront, glm::vec3(0.0f, 1.0f, 0.0f));
+	viewState.projection = glm::perspective(glm::radians(60.0f), 1000.0f / 800.0f, 0.1f, 300.0f);
+	viewState.viewportHeight = 800;
+
+	std::cout << "INFO: Pick benchmark, " << objectCount << " objects" << std::endl;
+	scene.PickObject(viewState, 0.0f, 0.0f, pick);
+	std::cout << "INFO:   first pick us, building the hierarchy:" << pick.microseconds << std::endl;
+
+	// time picks at random points of the view
+	auto timePicks = [&](const char* label)
+	{
+		double totalMicroseconds = 0.0;
+		double maxMicroseconds = 0.0;
+		size_t hits = 0;
+		for (int i = 0; i < PICKS; i++)
+		{
+			hits += scene.PickObject(viewState, unit(random) * 2.0f - 1.0f, unit(random) * 2.0f - 1.0f, pick) ? 1 : 0;
+			totalMicroseconds += pick.microseconds;
+			maxMicroseconds = (pick.microseconds > maxMicroseconds) ? pick.microseconds : maxMicroseconds;
+		}
+		std::cout << "INFO:   " << label
+			<< ", average us:" << (totalMicroseconds / PICKS)
+			<< ", max us:" << maxMicroseconds
+			<< ", hits:" << hits << " of " << PICKS << std::endl;
+	};
+	timePicks("picks");
+
+	// move 1% of the objects, so the next pick refits the hierarchy
+	for (size_t i = 0; i < objectCount; i += 100)
+	{
+		SceneManager::SCENE_OBJECT& moved = objects[i];
+		moved.YrotationDegrees += 45.0f;
+		moved.positionXYZ += glm::vec3(unit(random) - 0.5f, 0.0f, unit(random) - 0.5f);
+		scene.MoveSceneObject(i, moved.scaleXYZ, moved.XrotationDegrees, moved.YrotationDegrees,
+			moved.ZrotationDegrees, moved.positionXYZ);
+	}
+	scene.PickObject(viewState, 0.0f, 0.0f, pick);
+	std::cout << "INFO:   first pick us after moving, refitting the hierarchy:" << pick.microseconds << std::endl;
+	timePicks("picks after moving");
+}
+
+/***********************************************************
+ *	RunAnimationBenchmark()
+ *
+ *  This function is used to time the keyframe animation of a
+ *  generated scene where each object spins, bobs and pulses
+ *  its color, every track with its own length.  The tracks
+ *  are evaluated on one thread and on every core, then the
+ *  whole update that also moves the objects is timed.
+ ***********************************************************/
+void RunAnimationBenchmark(size_t trackCount)
+{
+	const int FRAMES = 100;
+	const double FRAME_SECONDS = 1.0 / 60.0;
+	const AnimationChannel CHANNELS[] = { AnimationChannel::Rotation, AnimationChannel::Translation, AnimationChannel::Color };
+	std::mt19937 random(RANDOM_SEED);
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	size_t objectCount = (trackCount + 2) / 3;
+	SceneManager scene(NULL);
+	std::vector<SceneManager::SCENE_OBJECT> objects;
+	AnimationSystem animation;
+
+	// small boxes scattered over a flat world
+	GENERATED_SCENE layout = { objectCount, false, false, false, false };
+	GenerateSceneObjects(layout, random, &scene, objects);
+
+	// the same tracks go to the scene and to a bare animation system,
+	// so the evaluation can be timed on its own
+	for (size_t track = 0; track < trackCount; track++)
+	{
+		size_t index = track / 3;
+		const glm::vec3& position = objects[index].positionXYZ;
+		AnimationChannel channel = CHANNELS[track % 3];
+		float duration = 1.0f + unit(random) * 9.0f;
+		AnimationSystem::KEYFRAME keys[4];
+		size_t keyCount = 0;
+
+		if (channel == AnimationChannel::Rotation)
+		{
+			keys[keyCount++] = { 0.0f, glm::vec4(0.0f) };
+			keys[keyCount++] = { duration, glm::vec4(0.0f, 360.0f, 0.0f, 0.0f) };
+		}
+		else if (channel == AnimationChannel::Translation)
+		{
+			keys[keyCount++] = { 0.0f, glm::vec4(position, 0.0f) };
+			keys[keyCount++] = { duration * 0.25f, glm::vec4(position + glm::vec3(0.0f, 0.5f, 0.0f), 0.0f) };
+			keys[keyCount++] = { duration * 0.75f, glm::vec4(position - glm::vec3(0.0f, 0.5f, 0.0f), 0.0f) };
+			keys[keyCount++] = { duration, glm::vec4(position, 0.0f) };
+		}
+		else
+		{
+			keys[keyCount++] = { 0.0f, glm::vec4(1.0f) };
+			keys[keyCount++] = { duration * 0.5f, glm::vec4(unit(random), unit(random), unit(random), 1.0f) };
+			keys[keyCount++] = { duration, glm::vec4(1.0f) };
+		}
+		scene.AddAnimationTrack(index, channel, keys, keyCount, true);
+		animation.AddTrack((uint32_t)index, channel, keys, keyCount, true);
+	}
+
+	unsigned int maxThreads = GetHardwareThreadCount();
+	JobSystem jobs(maxThreads - 1);
+
+	std::cout << "INFO: Animation benchmark, " << trackCount << " tracks on " << objectCount
+		<< " objects, " << maxThreads << " threads" << std::endl;
+
+	// warm up the caches, then play frames at 60 frames per second
+	animation.Evaluate(0.0, NULL);
+	auto start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < FRAMES; frame++)
+	{
+		animation.Evaluate(frame * FRAME_SECONDS, NULL);
+	}
+	double singleThreadMilliseconds = GetMillisecondsSince(start) / FRAMES;
+
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < FRAMES; frame++)
+	{
+		animation.Evaluate(frame * FRAME_SECONDS, &jobs);
+	}
+	double evaluateMilliseconds = GetMillisecondsSince(start) / FRAMES;
+
+	scene.SetJobSystem(&jobs);
+	scene.UpdateAnimations(0.0);
+	start = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < FRAMES; frame++)
+	{
+		scene.UpdateAnimations(frame * FRAME_SECONDS);
+	}
+	double updateMilliseconds = GetMillisecondsSince(start) / FRAMES;
+	scene.SetJobSystem(NULL);
+
+	std::cout << "INFO:   evaluate ms per frame, one thread:" << singleThreadMilliseconds
+		<< ", all threads:" << evaluateMilliseconds
+		<< ", tracks per second:" << (trackCount / (evaluateMilliseconds / 1000.0)) << std::endl;
+	std::cout << "INFO:   update ms per frame, evaluating and moving the objects:" << updateMilliseconds << std::endl;
+}
+
+/***********************************************************
+ *	InitializeGLEW()
+ *
+ *  This function is used to initialize the GLEW library on
+ *  the current context.  A GLEW built for GLX reports that
+ *  it found no X display on an EGL context, after it has
+ *  loaded the OpenGL functions, so that error is ignored.
+ ***********************************************************/
+bool InitializeGLEW()
+{
+	GLenum GLEWInitResult = glewInit();
+
+#ifdef GLEW_ERROR_NO_GLX_DISPLAY
+	if (GLEW_ERROR_NO_GLX_DISPLAY == GLEWInitResult)
+	{
+		GLEWInitResult = GLEW_OK;
+	}
+#endif
+	if (GLEW_OK != GLEWInitResult)
+	{
+		std::cerr << "ERROR: " << glewGetErrorString(GLEWInitResult) << std::endl;
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *	RunMicroBenchmarks()
+ *
+ *  This function is used to time the functions run for each
+ *  drawn object and each frame on the real scene and shader,
+ *  then save the results as JSON under filename.  The OpenGL
+ *  context comes from EGL without a window, so it also runs
+ *  on a build machine with no display server, e.g. on Mesa's
+ *  llvmpipe software rasterizer.  The view manager opens no
+ *  window either - the light setup and camera math it times
+ *  only need the shader program.
+ ***********************************************************/
+bool RunMicroBenchmarks(const char* filename)
+{
+	const int SAMPLES = 15;
+	const double MIN_SAMPLE_SECONDS = 0.01;
+	MicroBenchmark benchmark(SAMPLES, MIN_SAMPLE_SECONDS);
+	HeadlessContext context;
+	VIEW_STATE viewState;
+
+	if ((context.Create(SURFACE_WIDTH, SURFACE_HEIGHT) == false) || (InitializeGLEW() == false))
+	{
+		std::cerr << "ERROR: Could not create the OpenGL context for the benchmarks" << std::endl;
+		return(false);
+	}
+
+	ShaderManager* pShaderManager = new ShaderManager();
+	ViewManager* pViewManager = new ViewManager(pShaderManager);
+	pShaderManager->LoadShaders(
+		VERTEX_SHADER_PATH,
+		FRAGMENT_SHADER_PATH);
+	pShaderManager->use();
+
+	SceneManager* pSceneManager = new SceneManager(pShaderManager);
+	pSceneManager->PrepareScene();
+	pViewManager->UpdateViewState(viewState);
+	pViewManager->ApplyViewState(viewState);
+
+	std::cout << "INFO: Micro benchmarks, renderer " << glGetString(GL_RENDERER) << std::endl;
+	pSceneManager->RunMicroBenchmarks(benchmark);
+	pViewManager->RunMicroBenchmarks(benchmark);
+	benchmark.Print();
+	bool bWritten = benchmark.WriteJson(filename, (const char*)glGetString(GL_RENDERER));
+
+	delete pSceneManager;
+	delete pViewManager;
+	delete pShaderManager;
+	context.Destroy();
+
+	return(bWritten);
+}
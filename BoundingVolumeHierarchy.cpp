@@ -0,0 +1,309 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.cpp
+// ============
+// binary tree of object bounds built for finding the closest object hit
+// by a ray, such as the one under the mouse cursor
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BoundingVolumeHierarchy.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// number of centroid bins a split is chosen from
+	const int g_SplitBinCount = 12;
+	// most objects kept in a leaf because splitting them would cost
+	// more, past which a node is split anyway
+	const uint32_t g_MaxCostLeafObjects = 16;
+
+	// bin of a centroid offset along the split axis, with
+	// centroids that are not finite put in the end bins
+	int GetSplitBin(float offset, float binScale)
+	{
+		float bin = offset * binScale;
+		if (bin >= (float)(g_SplitBinCount - 1))
+		{
+			return(g_SplitBinCount - 1);
+		}
+		return((bin > 0.0f) ? (int)bin : 0);
+	}
+
+	// grow a box to contain another one
+	void ExpandBox(BOUNDING_BOX& bounds, const BOUNDING_BOX& other)
+	{
+		bounds.minXYZ = glm::min(bounds.minXYZ, other.minXYZ);
+		bounds.maxXYZ = glm::max(bounds.maxXYZ, other.maxXYZ);
+	}
+
+	// a box that contains nothing until it is expanded
+	BOUNDING_BOX GetEmptyBox()
+	{
+		BOUNDING_BOX bounds;
+		bounds.minXYZ = glm::vec3(std::numeric_limits<float>::max());
+		bounds.maxXYZ = glm::vec3(-std::numeric_limits<float>::max());
+		return(bounds);
+	}
+
+	// half the surface area of a box, 0 when it is empty
+	float GetHalfArea(const BOUNDING_BOX& bounds)
+	{
+		glm::vec3 extent = bounds.maxXYZ - bounds.minXYZ;
+		if ((extent.x < 0.0f) || (extent.y < 0.0f) || (extent.z < 0.0f))
+		{
+			return(0.0f);
+		}
+		return((extent.x * extent.y) + (extent.y * extent.z) + (extent.z * extent.x));
+	}
+}
+
+/***********************************************************
+ *  BoundingVolumeHierarchy()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+}
+
+/***********************************************************
+ *  ~BoundingVolumeHierarchy()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+BoundingVolumeHierarchy::~BoundingVolumeHierarchy()
+{
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the tree from scratch
+ *  over the bounds of count objects.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Build(const BOUNDING_BOX* pBounds, size_t count)
+{
+	m_nodes.clear();
+	m_objectIndices.resize(count);
+	m_centroids.resize(count);
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	for (size_t i = 0; i < count; i++)
+	{
+		m_objectIndices[i] = (uint32_t)i;
+		m_centroids[i] = (pBounds[i].minXYZ + pBounds[i].maxXYZ) * 0.5f;
+	}
+
+	// a binary tree with leaves of one or more objects never has
+	// more than 2n - 1 nodes
+	m_nodes.reserve((count * 2) - 1);
+
+	BVH_NODE root;
+	root.first = 0;
+	root.objectCount = (uint32_t)count;
+	root.bounds = GetLeafBounds(root, pBounds);
+	m_nodes.push_back(root);
+
+	Subdivide(0, pBounds, 0);
+}
+
+/***********************************************************
+ *  GetLeafBounds()
+ *
+ *  This method is used for getting the box around the
+ *  objects of a leaf.
+ ***********************************************************/
+BOUNDING_BOX BoundingVolumeHierarchy::GetLeafBounds(const BVH_NODE& node, const BOUNDING_BOX* pBounds) const
+{
+	BOUNDING_BOX bounds = GetEmptyBox();
+
+	for (uint32_t i = 0; i < node.objectCount; i++)
+	{
+		ExpandBox(bounds, pBounds[m_objectIndices[node.first + i]]);
+	}
+
+	return(bounds);
+}
+
+/***********************************************************
+ *  Subdivide()
+ *
+ *  This method is used for splitting a leaf in two along the
+ *  axis where its object centroids spread the most, at the
+ *  bin boundary with the lowest surface area cost, and then
+ *  splitting the two halves in turn.  A node stays a leaf
+ *  when splitting it would cost more than testing all of its
+ *  objects.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Subdivide(uint32_t nodeIndex, const BOUNDING_BOX* pBounds, int depth)
+{
+	uint32_t first = m_nodes[nodeIndex].first;
+	uint32_t objectCount = m_nodes[nodeIndex].objectCount;
+
+	if ((objectCount <= MAX_LEAF_OBJECTS) || (depth >= MAX_DEPTH))
+	{
+		return;
+	}
+
+	// split along the widest spread of the centroids
+	glm::vec3 centroidMin = m_centroids[m_objectIndices[first]];
+	glm::vec3 centroidMax = centroidMin;
+	for (uint32_t i = 1; i < objectCount; i++)
+	{
+		const glm::vec3& centroid = m_centroids[m_objectIndices[first + i]];
+		centroidMin = glm::min(centroidMin, centroid);
+		centroidMax = glm::max(centroidMax, centroid);
+	}
+
+	glm::vec3 spread = centroidMax - centroidMin;
+	int axis = 0;
+	if (spread.y > spread[axis])
+	{
+		axis = 1;
+	}
+	if (spread.z > spread[axis])
+	{
+		axis = 2;
+	}
+	// every centroid in one place cannot be split
+	if (!(spread[axis] > 0.0f) || !std::isfinite(spread[axis]))
+	{
+		return;
+	}
+
+	// count the objects and their bounds in each bin
+	BOUNDING_BOX binBounds[g_SplitBinCount];
+	uint32_t binCounts[g_SplitBinCount];
+	float binScale = (float)g_SplitBinCount / spread[axis];
+	for (int bin = 0; bin < g_SplitBinCount; bin++)
+	{
+		binBounds[bin] = GetEmptyBox();
+		binCounts[bin] = 0;
+	}
+	for (uint32_t i = 0; i < objectCount; i++)
+	{
+		uint32_t objectIndex = m_objectIndices[first + i];
+		int bin = GetSplitBin(m_centroids[objectIndex][axis] - centroidMin[axis], binScale);
+		binCounts[bin]++;
+		ExpandBox(binBounds[bin], pBounds[objectIndex]);
+	}
+
+	// sweep from the right for the cost of everything right of
+	// each boundary, then from the left to find the cheapest one
+	float rightCosts[g_SplitBinCount];
+	BOUNDING_BOX sweepBounds = GetEmptyBox();
+	uint32_t sweepCount = 0;
+	for (int bin = g_SplitBinCount - 1; bin > 0; bin--)
+	{
+		ExpandBox(sweepBounds, binBounds[bin]);
+		sweepCount += binCounts[bin];
+		rightCosts[bin] = GetHalfArea(sweepBounds) * (float)sweepCount;
+	}
+
+	float bestCost = std::numeric_limits<float>::max();
+	int bestSplit = 0;
+	sweepBounds = GetEmptyBox();
+	sweepCount = 0;
+	for (int bin = 1; bin < g_SplitBinCount; bin++)
+	{
+		ExpandBox(sweepBounds, binBounds[bin - 1]);
+		sweepCount += binCounts[bin - 1];
+		float cost = (GetHalfArea(sweepBounds) * (float)sweepCount) + rightCosts[bin];
+		if ((sweepCount > 0) && (sweepCount < objectCount) && (cost < bestCost))
+		{
+			bestCost = cost;
+			bestSplit = bin;
+		}
+	}
+
+	// a leaf costs one exact test per object, a split the tests of
+	// each child weighed by how often a ray through the parent
+	// reaches it, which follows the surface area of the child
+	float leafCost = GetHalfArea(m_nodes[nodeIndex].bounds) * (float)objectCount;
+	if ((bestSplit == 0) || ((bestCost >= leafCost) && (objectCount <= g_MaxCostLeafObjects)))
+	{
+		return;
+	}
+
+	// move the objects left of the split to the front
+	uint32_t* pBegin = &m_objectIndices[first];
+	uint32_t* pMiddle = std::partition(pBegin, pBegin + objectCount,
+		[&](uint32_t objectIndex)
+		{
+			return(GetSplitBin(m_centroids[objectIndex][axis] - centroidMin[axis], binScale) < bestSplit);
+		});
+	uint32_t leftCount = (uint32_t)(pMiddle - pBegin);
+
+	BVH_NODE left;
+	left.first = first;
+	left.objectCount = leftCount;
+	left.bounds = GetLeafBounds(left, pBounds);
+
+	BVH_NODE right;
+	right.first = first + leftCount;
+	right.objectCount = objectCount - leftCount;
+	right.bounds = GetLeafBounds(right, pBounds);
+
+	uint32_t leftIndex = (uint32_t)m_nodes.size();
+	m_nodes.push_back(left);
+	m_nodes.push_back(right);
+
+	m_nodes[nodeIndex].first = leftIndex;
+	m_nodes[nodeIndex].objectCount = 0;
+
+	Subdivide(leftIndex, pBounds, depth + 1);
+	Subdivide(leftIndex + 1, pBounds, depth + 1);
+}
+
+/***********************************************************
+ *  Refit()
+ *
+ *  This method is used for recomputing every box from the
+ *  current object bounds, keeping the shape of the tree.
+ *  Children are always stored after their parent, so one
+ *  pass from the back updates the children first.
+ ***********************************************************/
+void BoundingVolumeHierarchy::Refit(const BOUNDING_BOX* pBounds)
+{
+	for (size_t i = m_nodes.size(); i > 0; i--)
+	{
+		BVH_NODE& node = m_nodes[i - 1];
+		if (node.objectCount > 0)
+		{
+			node.bounds = GetLeafBounds(node, pBounds);
+		}
+		else
+		{
+			node.bounds = m_nodes[node.first].bounds;
+			ExpandBox(node.bounds, m_nodes[node.first + 1].bounds);
+		}
+	}
+}
+
+/***********************************************************
+ *  GetObjectCount()
+ *
+ *  This method is used for getting the number of objects the
+ *  tree was built over.
+ ***********************************************************/
+size_t BoundingVolumeHierarchy::GetObjectCount() const
+{
+	return(m_objectIndices.size());
+}
+
+/***********************************************************
+ *  GetNodeCount()
+ *
+ *  This method is used for getting the number of nodes in
+ *  the tree.
+ ***********************************************************/
+size_t BoundingVolumeHierarchy::GetNodeCount() const
+{
+	return(m_nodes.size());
+}
@@ -0,0 +1,178 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumehierarchy.h
+// ============
+// binary tree of object bounds built for finding the closest object hit
+// by a ray, such as the one under the mouse cursor
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "BoundingVolumes.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+/***********************************************************
+ *  BoundingVolumeHierarchy
+ *
+ *  This class contains a bounding volume hierarchy over the
+ *  bounds of a set of objects, split with the surface area
+ *  heuristic over binned centroids.  The nodes live in one
+ *  array with the two children of a node next to each other.
+ *  Moving objects only needs Refit(), which keeps the tree
+ *  and grows the boxes; a full Build() restores its quality.
+ *
+ *  IntersectRay() walks the nodes front to back, hands the
+ *  objects of each leaf reached to an exact hit test, and
+ *  skips every node further away than the closest hit so far.
+ ***********************************************************/
+class BoundingVolumeHierarchy
+{
+public:
+	// constructor
+	BoundingVolumeHierarchy();
+	// destructor
+	~BoundingVolumeHierarchy();
+
+	// most objects in a leaf, and deepest level built
+	static const uint32_t MAX_LEAF_OBJECTS = 4;
+	static const int MAX_DEPTH = 48;
+
+private:
+	// one box of the tree - an inner node has its children at
+	// first and first + 1, a leaf its objects at first in the
+	// object index list
+	struct BVH_NODE
+	{
+		BOUNDING_BOX bounds;
+		uint32_t first;
+		uint32_t objectCount;
+	};
+
+	std::vector<BVH_NODE> m_nodes;
+	std::vector<uint32_t> m_objectIndices;
+	std::vector<glm::vec3> m_centroids;
+
+	// split a node until its leaves are small enough
+	void Subdivide(uint32_t nodeIndex, const BOUNDING_BOX* pBounds, int depth);
+	// bounds of the objects of a leaf
+	BOUNDING_BOX GetLeafBounds(const BVH_NODE& node, const BOUNDING_BOX* pBounds) const;
+
+public:
+	// build the tree over count object bounds
+	void Build(const BOUNDING_BOX* pBounds, size_t count);
+	// update the boxes after objects moved, keeping the tree
+	void Refit(const BOUNDING_BOX* pBounds);
+	// number of objects the tree was built over
+	size_t GetObjectCount() const;
+	size_t GetNodeCount() const;
+
+	// find the closest object the ray hits within maxDistance, or -1 -
+	// hitTest(objectIndex, maxDistance, distance) returns true with the
+	// distance of the exact hit when the object is hit before maxDistance
+	template <typename HIT_TEST>
+	int IntersectRay(
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float maxDistance,
+		const HIT_TEST& hitTest,
+		float& distance) const
+	{
+		int closestObject = -1;
+		float closestDistance = maxDistance;
+		glm::vec3 inverseDirection;
+		float entry = 0.0f;
+		float farEntry = 0.0f;
+
+		if ((m_nodes.size() == 0) || (m_objectIndices.size() == 0))
+		{
+			return(-1);
+		}
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			inverseDirection[axis] = (direction[axis] != 0.0f) ?
+				(1.0f / direction[axis]) : std::numeric_limits<float>::infinity();
+		}
+
+		if (IntersectRayBox(origin, inverseDirection, closestDistance, m_nodes[0].bounds, entry) == false)
+		{
+			return(-1);
+		}
+
+		// nodes still to visit and the distance where the ray enters them
+		uint32_t stack[MAX_DEPTH + 2];
+		float stackEntry[MAX_DEPTH + 2];
+		int stackSize = 0;
+		stack[stackSize] = 0;
+		stackEntry[stackSize] = entry;
+		stackSize++;
+
+		while (stackSize > 0)
+		{
+			stackSize--;
+			const BVH_NODE& node = m_nodes[stack[stackSize]];
+			if (stackEntry[stackSize] > closestDistance)
+			{
+				continue;
+			}
+
+			if (node.objectCount > 0)
+			{
+				for (uint32_t i = 0; i < node.objectCount; i++)
+				{
+					uint32_t objectIndex = m_objectIndices[node.first + i];
+					float hitDistance = 0.0f;
+					if (hitTest(objectIndex, closestDistance, hitDistance) && (hitDistance < closestDistance))
+					{
+						closestDistance = hitDistance;
+						closestObject = (int)objectIndex;
+					}
+				}
+				continue;
+			}
+
+			// visit the nearer child first by pushing it last
+			uint32_t nearChild = node.first;
+			uint32_t farChild = node.first + 1;
+			bool bNearHit = IntersectRayBox(origin, inverseDirection, closestDistance, m_nodes[nearChild].bounds, entry);
+			bool bFarHit = IntersectRayBox(origin, inverseDirection, closestDistance, m_nodes[farChild].bounds, farEntry);
+			if (bNearHit && bFarHit && (farEntry < entry))
+			{
+				uint32_t swapChild = nearChild;
+				nearChild = farChild;
+				farChild = swapChild;
+				float swapEntry = entry;
+				entry = farEntry;
+				farEntry = swapEntry;
+			}
+			else if (!bNearHit && bFarHit)
+			{
+				nearChild = farChild;
+				entry = farEntry;
+				bNearHit = true;
+				bFarHit = false;
+			}
+
+			if (bFarHit)
+			{
+				stack[stackSize] = farChild;
+				stackEntry[stackSize] = farEntry;
+				stackSize++;
+			}
+			if (bNearHit)
+			{
+				stack[stackSize] = nearChild;
+				stackEntry[stackSize] = entry;
+				stackSize++;
+			}
+		}
+
+		distance = closestDistance;
+		return(closestObject);
+	}
+};
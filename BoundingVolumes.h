@@ -0,0 +1,218 @@
+///////////////////////////////////////////////////////////////////////////////
+// boundingvolumes.h
+// ============
+// axis aligned bounding boxes and view frustum tests shared by the
+// scene update, culling and spatial query code
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cmath>
+
+/***********************************************************
+ *  BOUNDING_BOX
+ *
+ *  Axis aligned box described by its minimum and maximum
+ *  corners in the coordinate space of its owner.
+ ***********************************************************/
+struct BOUNDING_BOX
+{
+	glm::vec3 minXYZ;
+	glm::vec3 maxXYZ;
+};
+
+/***********************************************************
+ *  FRUSTUM
+ *
+ *  Six inward facing planes (left, right, bottom, top, near,
+ *  far) stored as (normal.xyz, distance).
+ ***********************************************************/
+struct FRUSTUM
+{
+	glm::vec4 planes[6];
+};
+
+/***********************************************************
+ *  TransformBoundingBox()
+ *
+ *  Returns the axis aligned box enclosing the passed in box
+ *  after it has been transformed by the passed in matrix.
+ ***********************************************************/
+inline BOUNDING_BOX TransformBoundingBox(
+	const BOUNDING_BOX& box,
+	const glm::mat4& transform)
+{
+	BOUNDING_BOX result;
+	glm::vec3 translation = glm::vec3(transform[3].x, transform[3].y, transform[3].z);
+
+	result.minXYZ = translation;
+	result.maxXYZ = translation;
+
+	// accumulate the extents of each matrix column against the box corners
+	for (int column = 0; column < 3; column++)
+	{
+		for (int row = 0; row < 3; row++)
+		{
+			float a = transform[column][row] * box.minXYZ[column];
+			float b = transform[column][row] * box.maxXYZ[column];
+			result.minXYZ[row] += (a < b) ? a : b;
+			result.maxXYZ[row] += (a < b) ? b : a;
+		}
+	}
+
+	return(result);
+}
+
+/***********************************************************
+ *  ExtractFrustum()
+ *
+ *  Builds the frustum planes from a combined projection * view
+ *  matrix, normalizing each plane.
+ ***********************************************************/
+inline FRUSTUM ExtractFrustum(const glm::mat4& viewProjection)
+{
+	FRUSTUM frustum;
+	glm::vec4 rows[4];
+
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(
+			viewProjection[0][row],
+			viewProjection[1][row],
+			viewProjection[2][row],
+			viewProjection[3][row]);
+	}
+
+	frustum.planes[0] = rows[3] + rows[0];
+	frustum.planes[1] = rows[3] - rows[0];
+	frustum.planes[2] = rows[3] + rows[1];
+	frustum.planes[3] = rows[3] - rows[1];
+	frustum.planes[4] = rows[3] + rows[2];
+	frustum.planes[5] = rows[3] - rows[2];
+
+	for (int i = 0; i < 6; i++)
+	{
+		float length = std::sqrt(
+			frustum.planes[i].x * frustum.planes[i].x +
+			frustum.planes[i].y * frustum.planes[i].y +
+			frustum.planes[i].z * frustum.planes[i].z);
+		if (length > 0.0f)
+		{
+			frustum.planes[i] = frustum.planes[i] / length;
+		}
+	}
+
+	return(frustum);
+}
+
+/***********************************************************
+ *  IsBoxInFrustum()
+ *
+ *  Returns false only when the box lies completely outside
+ *  one of the frustum planes.
+ ***********************************************************/
+inline bool IsBoxInFrustum(const FRUSTUM& frustum, const BOUNDING_BOX& box)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		const glm::vec4& plane = frustum.planes[i];
+
+		// test the corner furthest along the plane normal
+		glm::vec3 positive(
+			(plane.x >= 0.0f) ? box.maxXYZ.x : box.minXYZ.x,
+			(plane.y >= 0.0f) ? box.maxXYZ.y : box.minXYZ.y,
+			(plane.z >= 0.0f) ? box.maxXYZ.z : box.minXYZ.z);
+
+		if ((plane.x * positive.x) + (plane.y * positive.y) + (plane.z * positive.z) + plane.w < 0.0f)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  IsBoxInsideFrustum()
+ *
+ *  Returns true only when the box lies completely inside all
+ *  of the frustum planes.
+ ***********************************************************/
+inline bool IsBoxInsideFrustum(const FRUSTUM& frustum, const BOUNDING_BOX& box)
+{
+	for (int i = 0; i < 6; i++)
+	{
+		const glm::vec4& plane = frustum.planes[i];
+
+		// test the corner furthest against the plane normal
+		glm::vec3 negative(
+			(plane.x >= 0.0f) ? box.minXYZ.x : box.maxXYZ.x,
+			(plane.y >= 0.0f) ? box.minXYZ.y : box.maxXYZ.y,
+			(plane.z >= 0.0f) ? box.minXYZ.z : box.maxXYZ.z);
+
+		if ((plane.x * negative.x) + (plane.y * negative.y) + (plane.z * negative.z) + plane.w < 0.0f)
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  DoesBoxIntersectSphere()
+ *
+ *  Returns true when the box and the sphere overlap.
+ ***********************************************************/
+inline bool DoesBoxIntersectSphere(const BOUNDING_BOX& box, const glm::vec3& center, float radius)
+{
+	glm::vec3 closest = glm::clamp(center, box.minXYZ, box.maxXYZ);
+	glm::vec3 offset = center - closest;
+
+	return(glm::dot(offset, offset) <= radius * radius);
+}
+
+/***********************************************************
+ *  IntersectRayBox()
+ *
+ *  Returns true when the ray from origin hits the box within
+ *  maxDistance, with the distance where it enters the box, or
+ *  0 from inside it.  inverseDirection holds 1 / direction
+ *  per axis, infinite for a zero component.
+ ***********************************************************/
+inline bool IntersectRayBox(
+	const glm::vec3& origin,
+	const glm::vec3& inverseDirection,
+	float maxDistance,
+	const BOUNDING_BOX& box,
+	float& distance)
+{
+	float tNear = 0.0f;
+	float tFar = maxDistance;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float t0 = (box.minXYZ[axis] - origin[axis]) * inverseDirection[axis];
+		float t1 = (box.maxXYZ[axis] - origin[axis]) * inverseDirection[axis];
+		if (t0 > t1)
+		{
+			float swap = t0;
+			t0 = t1;
+			t1 = swap;
+		}
+
+		// a NaN from a ray lying in a slab face is ignored, so the
+		// ray counts as inside that slab
+		tNear = (t0 > tNear) ? t0 : tNear;
+		tFar = (t1 < tFar) ? t1 : tFar;
+		if (tNear > tFar)
+		{
+			return(false);
+		}
+	}
+
+	distance = tNear;
+	return(true);
+}
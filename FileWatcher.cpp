@@ -0,0 +1,234 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.cpp
+// ============
+// report the asset files written on disk while the application runs, so
+// they can be reloaded without a restart
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FileWatcher.h"
+
+#include <sys/stat.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// seconds a changed file must be left alone before it is reported
+	const double g_SettleSeconds = 0.2;
+	// seconds between modification time checks without inotify
+	const double g_CheckIntervalSeconds = 0.5;
+}
+
+/***********************************************************
+ *  FileWatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FileWatcher::FileWatcher()
+{
+	m_inotifyDescriptor = -1;
+	m_lastCheckTime = std::chrono::steady_clock::now();
+
+#ifdef __linux__
+	m_inotifyDescriptor = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_inotifyDescriptor < 0)
+	{
+		std::cerr << "ERROR: Could not start inotify, polling the watched files instead" << std::endl;
+	}
+#endif
+}
+
+/***********************************************************
+ *  ~FileWatcher()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FileWatcher::~FileWatcher()
+{
+#ifdef __linux__
+	// closing the instance also removes its watches
+	if (m_inotifyDescriptor >= 0)
+	{
+		close(m_inotifyDescriptor);
+	}
+#endif
+	m_inotifyDescriptor = -1;
+}
+
+/***********************************************************
+ *  Watch()
+ *
+ *  This method is used for adding a file to the watched
+ *  ones.  Its directory is watched rather than the file, so
+ *  the watch survives editors that save by replacing it.
+ ***********************************************************/
+bool FileWatcher::Watch(const char* filename)
+{
+	WATCHED_FILE file;
+	std::string path = filename;
+	size_t separator = path.find_last_of("/\\");
+
+	for (const WATCHED_FILE& watched : m_files)
+	{
+		if (watched.filename == path)
+		{
+			return(true);
+		}
+	}
+
+	file.filename = path;
+	file.name = (separator == std::string::npos) ? path : path.substr(separator + 1);
+	file.directoryWatch = -1;
+	file.modifiedTime = GetModifiedTime(filename);
+	file.bChanged = false;
+
+#ifdef __linux__
+	if (m_inotifyDescriptor >= 0)
+	{
+		std::string directory = (separator == std::string::npos) ? "." : path.substr(0, separator + 1);
+
+		// the same directory always gets the same watch back
+		file.directoryWatch = inotify_add_watch(m_inotifyDescriptor, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+		if (file.directoryWatch < 0)
+		{
+			std::cerr << "ERROR: Could not watch directory:" << directory << std::endl;
+			return(false);
+		}
+	}
+#endif
+
+	m_files.push_back(file);
+	return(true);
+}
+
+/***********************************************************
+ *  GetFileCount()
+ *
+ *  This method is used for getting the number of watched
+ *  files.
+ ***********************************************************/
+size_t FileWatcher::GetFileCount() const
+{
+	return(m_files.size());
+}
+
+/***********************************************************
+ *  PollChanges()
+ *
+ *  This method is used for collecting the changes seen since
+ *  the last call, then reporting the changed files that have
+ *  settled.
+ ***********************************************************/
+void FileWatcher::PollChanges(std::vector<std::string>& changedFiles)
+{
+	auto now = std::chrono::steady_clock::now();
+
+	changedFiles.clear();
+
+	if (m_inotifyDescriptor >= 0)
+	{
+		ReadEvents();
+	}
+	else if (std::chrono::duration<double>(now - m_lastCheckTime).count() >= g_CheckIntervalSeconds)
+	{
+		CheckModifiedTimes();
+		m_lastCheckTime = now;
+	}
+
+	for (WATCHED_FILE& file : m_files)
+	{
+		if (file.bChanged &&
+			(std::chrono::duration<double>(now - file.changeTime).count() >= g_SettleSeconds))
+		{
+			file.bChanged = false;
+			changedFiles.push_back(file.filename);
+		}
+	}
+}
+
+/***********************************************************
+ *  ReadEvents()
+ *
+ *  This method is used for reading every queued inotify
+ *  event without blocking and marking the watched files
+ *  they name.  A file written again restarts its settle
+ *  time.
+ ***********************************************************/
+void FileWatcher::ReadEvents()
+{
+#ifdef __linux__
+	alignas(struct inotify_event) char buffer[4096];
+
+	while (true)
+	{
+		ssize_t bytes = read(m_inotifyDescriptor, buffer, sizeof(buffer));
+		if (bytes <= 0)
+		{
+			break;
+		}
+
+		for (ssize_t offset = 0; offset < bytes;)
+		{
+			const struct inotify_event* pEvent = (const struct inotify_event*)(buffer + offset);
+			offset += sizeof(struct inotify_event) + pEvent->len;
+
+			if (pEvent->len == 0)
+			{
+				continue;
+			}
+			for (WATCHED_FILE& file : m_files)
+			{
+				if ((file.directoryWatch == pEvent->wd) && (file.name == pEvent->name))
+				{
+					file.bChanged = true;
+					file.changeTime = std::chrono::steady_clock::now();
+				}
+			}
+		}
+	}
+#endif
+}
+
+/***********************************************************
+ *  CheckModifiedTimes()
+ *
+ *  This method is used for comparing the modification time
+ *  of each watched file with the one seen last.
+ ***********************************************************/
+void FileWatcher::CheckModifiedTimes()
+{
+	for (WATCHED_FILE& file : m_files)
+	{
+		time_t modifiedTime = GetModifiedTime(file.filename.c_str());
+		if ((modifiedTime != 0) && (modifiedTime != file.modifiedTime))
+		{
+			file.modifiedTime = modifiedTime;
+			file.bChanged = true;
+			file.changeTime = std::chrono::steady_clock::now();
+		}
+	}
+}
+
+/***********************************************************
+ *  GetModifiedTime()
+ *
+ *  This method is used for getting the time a file was last
+ *  written.
+ ***********************************************************/
+time_t FileWatcher::GetModifiedTime(const char* filename)
+{
+	struct stat status;
+
+	if (stat(filename, &status) != 0)
+	{
+		return(0);
+	}
+
+	return(status.st_mtime);
+}
@@ -0,0 +1,70 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.h
+// ============
+// report the asset files written on disk while the application runs, so
+// they can be reloaded without a restart
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FileWatcher
+ *
+ *  This class contains a set of watched files.  On Linux the
+ *  directories holding them are watched through inotify for
+ *  files closed after writing and files renamed into place,
+ *  which is how most editors save, so polling only reads the
+ *  queued events.  Elsewhere the modification times are
+ *  checked twice a second.  A change is only reported once
+ *  the file has been left alone for a moment, so a save made
+ *  of several writes is reloaded once, from the finished file.
+ ***********************************************************/
+class FileWatcher
+{
+public:
+	// constructor
+	FileWatcher();
+	// destructor
+	~FileWatcher();
+
+	// start watching a file, returns false when it cannot be watched
+	bool Watch(const char* filename);
+	// number of watched files
+	size_t GetFileCount() const;
+	// get the watched files changed since the last call, each once -
+	// call on the thread that reloads them
+	void PollChanges(std::vector<std::string>& changedFiles);
+
+private:
+	// one watched file
+	struct WATCHED_FILE
+	{
+		std::string filename;
+		// name of the file in its directory and the inotify watch of
+		// the directory
+		std::string name;
+		int directoryWatch;
+		// modification time when last checked
+		time_t modifiedTime;
+		// true once a change is seen, reported after the settle time
+		bool bChanged;
+		std::chrono::steady_clock::time_point changeTime;
+	};
+
+	std::vector<WATCHED_FILE> m_files;
+	// inotify instance, or -1 when the modification times are polled
+	int m_inotifyDescriptor;
+	std::chrono::steady_clock::time_point m_lastCheckTime;
+
+	// mark the files named in the queued inotify events as changed
+	void ReadEvents();
+	// mark the files with a new modification time as changed
+	void CheckModifiedTimes();
+	// get the modification time of a file, or 0 when it is missing
+	static time_t GetModifiedTime(const char* filename);
+};
@@ -0,0 +1,231 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.cpp
+// ============
+// hand out the short lived memory of one frame from a single block that is
+// reset as a whole, and check that the steady state frames stay off the heap
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameArena.h"
+#include "ResourceTracker.h"
+
+#include <algorithm>
+#include <iostream>
+
+#ifndef NDEBUG
+#include <cassert>
+#include <cstdlib>
+#include <new>
+#endif
+
+// declaration of global variables
+namespace
+{
+#ifndef NDEBUG
+	// operator new calls made by each thread
+	thread_local size_t g_ThreadAllocations = 0;
+#endif
+}
+
+#ifndef NDEBUG
+/***********************************************************
+ *  operator new / operator delete
+ *
+ *  Debug builds replace the global allocation functions to
+ *  count the allocations of each thread.  The array and
+ *  nothrow forms forward to these.
+ ***********************************************************/
+void* operator new(size_t size)
+{
+	g_ThreadAllocations++;
+
+	void* pMemory = std::malloc((size > 0) ? size : 1);
+	if (NULL == pMemory)
+	{
+		throw std::bad_alloc();
+	}
+	return(pMemory);
+}
+
+void operator delete(void* pMemory) noexcept
+{
+	std::free(pMemory);
+}
+
+void operator delete(void* pMemory, size_t) noexcept
+{
+	std::free(pMemory);
+}
+#endif
+
+/***********************************************************
+ *  FrameArena()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameArena::FrameArena(size_t capacity)
+{
+	m_pBuffer = (capacity > 0) ? new uint8_t[capacity] : NULL;
+	m_capacity = capacity;
+	m_offset = 0;
+	m_overflowBytes = 0;
+	m_peakBytes = 0;
+
+	// the block is tracked by the arena address, which stays put
+	// when the block is regrown
+	ResourceTracker::Allocate(ResourceCategory::HostMemory, (uintptr_t)this, m_capacity, "Frame arena");
+}
+
+/***********************************************************
+ *  ~FrameArena()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameArena::~FrameArena()
+{
+	Reset();
+	delete[] m_pBuffer;
+	m_pBuffer = NULL;
+	ResourceTracker::Release(ResourceCategory::HostMemory, (uintptr_t)this);
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for taking the next size bytes of the
+ *  block.  Threads race for the offset with a compare and
+ *  swap, and a request past the end of the block goes to the
+ *  heap until the next reset.
+ ***********************************************************/
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	uintptr_t base = (uintptr_t)m_pBuffer;
+	size_t offset = m_offset.load(std::memory_order_relaxed);
+
+	while (true)
+	{
+		size_t aligned = (size_t)(((base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base);
+		if (aligned + size > m_capacity)
+		{
+			break;
+		}
+		if (m_offset.compare_exchange_weak(offset, aligned + size, std::memory_order_relaxed))
+		{
+			return(m_pBuffer + aligned);
+		}
+	}
+
+	std::lock_guard<std::mutex> lock(m_overflowMutex);
+	uint8_t* pBlock = new uint8_t[size + alignment];
+	m_overflowBlocks.push_back(pBlock);
+	m_overflowBytes += size + alignment;
+
+	return((void*)(((uintptr_t)pBlock + alignment - 1) & ~(uintptr_t)(alignment - 1)));
+}
+
+/***********************************************************
+ *  Reset()
+ *
+ *  This method is used for releasing every allocation at
+ *  once.  When some of them did not fit, the block is grown
+ *  to the peak usage with some room to spare.
+ ***********************************************************/
+void FrameArena::Reset()
+{
+	size_t usedBytes = GetUsedBytes();
+	m_peakBytes = std::max(m_peakBytes, usedBytes);
+
+	if (m_overflowBlocks.size() > 0)
+	{
+		for (uint8_t* pBlock : m_overflowBlocks)
+		{
+			delete[] pBlock;
+		}
+		m_overflowBlocks.clear();
+		m_overflowBytes = 0;
+
+		delete[] m_pBuffer;
+		m_capacity = m_peakBytes + m_peakBytes / 4;
+		m_pBuffer = new uint8_t[m_capacity];
+		ResourceTracker::Resize(ResourceCategory::HostMemory, (uintptr_t)this, m_capacity);
+		std::cout << "INFO: Frame arena grown to " << m_capacity << " bytes" << std::endl;
+	}
+
+	m_offset.store(0, std::memory_order_relaxed);
+}
+
+/***********************************************************
+ *  GetCapacity()
+ *
+ *  This method is used for getting the size of the block.
+ ***********************************************************/
+size_t FrameArena::GetCapacity() const
+{
+	return(m_capacity);
+}
+
+/***********************************************************
+ *  GetUsedBytes()
+ *
+ *  This method is used for getting the bytes allocated since
+ *  the last reset, counting those that did not fit.
+ ***********************************************************/
+size_t FrameArena::GetUsedBytes() const
+{
+	return(m_offset.load(std::memory_order_relaxed) + m_overflowBytes);
+}
+
+/***********************************************************
+ *  GetPeakBytes()
+ *
+ *  This method is used for getting the most bytes allocated
+ *  between two resets.
+ ***********************************************************/
+size_t FrameArena::GetPeakBytes() const
+{
+	return(std::max(m_peakBytes, GetUsedBytes()));
+}
+
+/***********************************************************
+ *  HeapAllocationCheck()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+HeapAllocationCheck::HeapAllocationCheck(const char* scopeName, bool bEnabled)
+{
+	m_scopeName = scopeName;
+	m_bEnabled = bEnabled;
+	m_startCount = GetThreadAllocationCount();
+}
+
+/***********************************************************
+ *  ~HeapAllocationCheck()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+HeapAllocationCheck::~HeapAllocationCheck()
+{
+#ifndef NDEBUG
+	size_t allocations = GetThreadAllocationCount() - m_startCount;
+	if (m_bEnabled && (allocations > 0))
+	{
+		std::cerr << "ERROR: " << m_scopeName << " made " << allocations
+			<< " heap allocations in a steady state frame" << std::endl;
+		assert(false);
+	}
+#endif
+}
+
+/***********************************************************
+ *  GetThreadAllocationCount()
+ *
+ *  This method is used for getting the number of operator
+ *  new calls made by the calling thread.
+ ***********************************************************/
+size_t HeapAllocationCheck::GetThreadAllocationCount()
+{
+#ifndef NDEBUG
+	return(g_ThreadAllocations);
+#else
+	return(0);
+#endif
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+// framearena.h
+// ============
+// hand out the short lived memory of one frame from a single block that is
+// reset as a whole, and check that the steady state frames stay off the heap
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+
+/***********************************************************
+ *  FrameArena
+ *
+ *  This class contains a linear allocator for the data built
+ *  and consumed within one frame.  Allocating only moves an
+ *  atomic offset, so the job system threads can share it, and
+ *  nothing is freed until Reset() releases everything at once.
+ *
+ *  A request that does not fit is served from the heap and the
+ *  block grows to the peak usage on the next Reset(), so after
+ *  the first frames an arena no longer touches the heap.
+ *  Nothing allocated here is destructed, so it only holds
+ *  trivially destructible types.
+ ***********************************************************/
+class FrameArena
+{
+public:
+	// constructor
+	FrameArena(size_t capacity);
+	// destructor
+	~FrameArena();
+
+private:
+	// the block and the offset of its first free byte
+	uint8_t* m_pBuffer;
+	size_t m_capacity;
+	std::atomic<size_t> m_offset;
+	// requests that did not fit in the block
+	std::mutex m_overflowMutex;
+	std::vector<uint8_t*> m_overflowBlocks;
+	size_t m_overflowBytes;
+	// most bytes requested between two resets
+	size_t m_peakBytes;
+
+public:
+	// get size bytes aligned to alignment, a power of two
+	void* Allocate(size_t size, size_t alignment);
+	// get room for count objects of type T, left uninitialized
+	template <typename T>
+	T* AllocateArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible<T>::value,
+			"frame arena memory is released without running destructors");
+		return((T*)Allocate(count * sizeof(T), alignof(T)));
+	}
+
+	// release everything allocated since the last reset - no
+	// other thread may use the arena or its memory meanwhile
+	void Reset();
+
+	size_t GetCapacity() const;
+	size_t GetUsedBytes() const;
+	size_t GetPeakBytes() const;
+};
+
+/***********************************************************
+ *  HeapAllocationCheck
+ *
+ *  This class contains a debug check that the code run while
+ *  an instance exists does not allocate from the global heap
+ *  on its thread.  Debug builds count every operator new per
+ *  thread and report and assert on leaving a scope that
+ *  allocated.  Release builds count nothing.
+ ***********************************************************/
+class HeapAllocationCheck
+{
+public:
+	// start watching the calling thread, unless bEnabled is false
+	HeapAllocationCheck(const char* scopeName, bool bEnabled = true);
+	// report the allocations made since the constructor
+	~HeapAllocationCheck();
+
+	// operator new calls made so far by the calling thread, always
+	// 0 in release builds
+	static size_t GetThreadAllocationCount();
+
+private:
+	const char* m_scopeName;
+	bool m_bEnabled;
+	size_t m_startCount;
+};
@@ -0,0 +1,237 @@
+///////////////////////////////////////////////////////////////////////////////
+// framemanager.cpp
+// ============
+// manage the scene update thread and the double buffered draw lists
+// handed from it to the OpenGL rendering thread
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameManager.h"
+
+#include <chrono>
+
+// declaration of global variables
+namespace
+{
+	// starting size of the arena of each frame, it grows to the
+	// largest frame built
+	const size_t g_FrameArenaCapacity = 256 * 1024;
+}
+
+/***********************************************************
+ *  FrameManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameManager::FrameManager(SceneManager* pSceneManager)
+{
+	m_pSceneManager = pSceneManager;
+	m_pInstanceBuffer = NULL;
+	m_frontFrame = 0;
+	m_nextFrameNumber = 0;
+	m_bBuildPending = false;
+	m_bFrameReady = false;
+	m_bStopRequested = false;
+
+	for (int i = 0; i < 2; i++)
+	{
+		m_frames[i].frameNumber = 0;
+		m_frames[i].pArena = new FrameArena(g_FrameArenaCapacity);
+		m_frames[i].viewSet.viewCount = 0;
+		for (int view = 0; view < VIEW_SET::MAX_VIEWS; view++)
+		{
+			m_frames[i].drawLists[view].pCommands = NULL;
+			m_frames[i].drawLists[view].count = 0;
+		}
+		m_frames[i].buildMilliseconds = 0.0;
+		m_frames[i].instanceRegion = -1;
+		m_frames[i].pInstances = NULL;
+		m_frames[i].instanceCount = 0;
+	}
+}
+
+/***********************************************************
+ *  ~FrameManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameManager::~FrameManager()
+{
+	Stop();
+	m_pSceneManager = NULL;
+	m_pInstanceBuffer = NULL;
+
+	for (int i = 0; i < 2; i++)
+	{
+		delete m_frames[i].pArena;
+		m_frames[i].pArena = NULL;
+	}
+}
+
+/***********************************************************
+ *  Start()
+ *
+ *  This method is used for starting the scene update thread.
+ ***********************************************************/
+void FrameManager::Start()
+{
+	if (m_updateThread.joinable())
+	{
+		return;
+	}
+
+	m_bStopRequested = false;
+	m_updateThread = std::thread(&FrameManager::UpdateThreadMain, this);
+}
+
+/***********************************************************
+ *  Stop()
+ *
+ *  This method is used for stopping the scene update thread
+ *  after it finishes any frame it is building.
+ ***********************************************************/
+void FrameManager::Stop()
+{
+	if (!m_updateThread.joinable())
+	{
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopRequested = true;
+	}
+	m_condition.notify_all();
+	m_updateThread.join();
+}
+
+/***********************************************************
+ *  SetInstanceBuffer()
+ *
+ *  This method is used for setting the ring buffer that
+ *  receives the per-instance data of each built frame.
+ ***********************************************************/
+void FrameManager::SetInstanceBuffer(InstanceRingBuffer* pInstanceBuffer)
+{
+	m_pInstanceBuffer = pInstanceBuffer;
+}
+
+/***********************************************************
+ *  SubmitViews()
+ *
+ *  This method is used for handing the views of the next
+ *  frame to the scene update thread.  The back buffer is free as
+ *  soon as the previous frame has been taken by WaitForFrame().
+ *  The instance ring buffer region for the frame is acquired
+ *  here because waiting on its fence needs the GL context.
+ ***********************************************************/
+void FrameManager::SubmitViews(const VIEW_SET& viewSet)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	// a frame that was built but never taken still owns the back buffer
+	m_condition.wait(lock, [this] { return !m_bBuildPending && !m_bFrameReady; });
+
+	RENDER_FRAME& backFrame = m_frames[1 - m_frontFrame];
+	backFrame.instanceRegion = -1;
+	backFrame.pInstances = NULL;
+	if (NULL != m_pInstanceBuffer)
+	{
+		backFrame.pInstances = m_pInstanceBuffer->AcquireRegion(backFrame.instanceRegion);
+	}
+
+	m_pendingViews = viewSet;
+	m_bBuildPending = true;
+	lock.unlock();
+	m_condition.notify_all();
+}
+
+/***********************************************************
+ *  WaitForFrame()
+ *
+ *  This method is used for waiting until the scene update
+ *  thread has finished the submitted frame and swapping it
+ *  to the front for the GL thread.
+ ***********************************************************/
+const FrameManager::RENDER_FRAME& FrameManager::WaitForFrame()
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	m_condition.wait(lock, [this] { return m_bFrameReady; });
+
+	m_frontFrame = 1 - m_frontFrame;
+	m_bFrameReady = false;
+	lock.unlock();
+	m_condition.notify_all();
+
+	return(m_frames[m_frontFrame]);
+}
+
+/***********************************************************
+ *  ReleaseFrame()
+ *
+ *  This method is used for fencing the instance data of a
+ *  frame after all of its draws have been submitted.
+ ***********************************************************/
+void FrameManager::ReleaseFrame(const RENDER_FRAME& frame)
+{
+	if (NULL != m_pInstanceBuffer)
+	{
+		m_pInstanceBuffer->ReleaseRegion(frame.instanceRegion);
+	}
+}
+
+/***********************************************************
+ *  UpdateThreadMain()
+ *
+ *  This method is the body of the scene update thread.  It
+ *  builds each submitted frame into the buffer that is not
+ *  being read by the GL thread, with the draw lists of all
+ *  of its views built together.
+ ***********************************************************/
+void FrameManager::UpdateThreadMain()
+{
+	while (true)
+	{
+		VIEW_SET viewSet;
+		int backFrame = 0;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this] { return m_bBuildPending || m_bStopRequested; });
+			if (m_bStopRequested)
+			{
+				break;
+			}
+			viewSet = m_pendingViews;
+			backFrame = 1 - m_frontFrame;
+		}
+
+		RENDER_FRAME& frame = m_frames[backFrame];
+		auto buildStart = std::chrono::steady_clock::now();
+
+		frame.frameNumber = m_nextFrameNumber++;
+		frame.viewSet = viewSet;
+		// the GL thread finished with this buffer before taking the other
+		frame.pArena->Reset();
+		if (NULL != m_pSceneManager)
+		{
+			frame.instanceCount = m_pSceneManager->BuildDrawLists(
+				viewSet.views,
+				(size_t)viewSet.viewCount,
+				*frame.pArena,
+				frame.drawLists,
+				frame.pInstances,
+				(NULL != frame.pInstances) ? m_pInstanceBuffer->GetMaxInstances() : 0);
+		}
+
+		frame.buildMilliseconds = std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - buildStart).count();
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_bBuildPending = false;
+			m_bFrameReady = true;
+		}
+		m_condition.notify_all();
+	}
+}
@@ -0,0 +1,97 @@
+///////////////////////////////////////////////////////////////////////////////
+// framemanager.h
+// ============
+// manage the scene update thread and the double buffered draw lists
+// handed from it to the OpenGL rendering thread
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneManager.h"
+#include "ViewManager.h"
+#include "InstanceRingBuffer.h"
+#include "FrameArena.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  FrameManager
+ *
+ *  This class owns the scene update thread.  While the GL
+ *  thread submits the draw list of one frame, the update
+ *  thread builds the draw list of the next frame into the
+ *  other buffer, and the two buffers are swapped once per
+ *  frame.  Each buffer has its own frame arena holding the
+ *  draw list, reset only when the buffer is built again, so
+ *  the GL thread can read it while the other one is filled.
+ ***********************************************************/
+class FrameManager
+{
+public:
+	// constructor
+	FrameManager(SceneManager* pSceneManager);
+	// destructor
+	~FrameManager();
+
+	// everything needed by the GL thread to draw one frame
+	struct RENDER_FRAME
+	{
+		unsigned int frameNumber;
+		VIEW_SET viewSet;
+		// memory of the frame, and the draw list of each view
+		// allocated from it
+		FrameArena* pArena;
+		SceneManager::DRAW_LIST drawLists[VIEW_SET::MAX_VIEWS];
+		// instance ring buffer region written for this frame, shared
+		// by the draw lists of all views, and the slots it holds
+		int instanceRegion;
+		INSTANCE_DATA* pInstances;
+		size_t instanceCount;
+		// time spent by the update thread building this frame
+		double buildMilliseconds;
+	};
+
+private:
+	// pointer to scene manager object
+	SceneManager* m_pSceneManager;
+	// pointer to the ring buffer receiving the instance data
+	InstanceRingBuffer* m_pInstanceBuffer;
+	// the two frame buffers and the one owned by the GL thread
+	RENDER_FRAME m_frames[2];
+	int m_frontFrame;
+	// number of the next frame to be built
+	unsigned int m_nextFrameNumber;
+
+	// scene update thread and the state guarded by the mutex
+	std::thread m_updateThread;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	VIEW_SET m_pendingViews;
+	bool m_bBuildPending;
+	bool m_bFrameReady;
+	bool m_bStopRequested;
+
+	// body of the scene update thread
+	void UpdateThreadMain();
+
+public:
+	// start and stop the scene update thread
+	void Start();
+	void Stop();
+	// set the ring buffer the update thread writes instance data
+	// into, or NULL to draw with the per-object uniforms only
+	void SetInstanceBuffer(InstanceRingBuffer* pInstanceBuffer);
+
+	// hand the views of the next frame to the update thread - the
+	// update thread starts building them into the back buffer
+	void SubmitViews(const VIEW_SET& viewSet);
+	// wait for the update thread to finish the submitted frame and
+	// make it the front buffer, valid until the next call
+	const RENDER_FRAME& WaitForFrame();
+	// give the frame's instance data back to the ring buffer once
+	// its draws have been submitted
+	void ReleaseFrame(const RENDER_FRAME& frame);
+};
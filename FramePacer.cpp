@@ -0,0 +1,232 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.cpp
+// ============
+// limit how many frames the CPU may queue ahead of the GPU and measure
+// the latency from input sampling to presentation
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FramePacer.h"
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// time slice for each wait on a frame fence, in nanoseconds
+	const GLuint64 g_FenceWaitTimeout = 1000000;
+}
+
+/***********************************************************
+ *  FramePacer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FramePacer::FramePacer(unsigned int maxFramesInFlight)
+{
+	m_firstPending = 0;
+	m_pendingCount = 0;
+	m_maxFramesInFlight = 1;
+	SetMaxFramesInFlight(maxFramesInFlight);
+
+	m_intervalStart = glfwGetTime();
+	m_intervalFrames = 0;
+	m_latencySum = 0.0;
+	m_latencyMax = 0.0;
+	m_waitSum = 0.0;
+	m_idleSum = 0.0;
+}
+
+/***********************************************************
+ *  ~FramePacer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FramePacer::~FramePacer()
+{
+	while (m_pendingCount > 0)
+	{
+		glDeleteSync(m_pendingFrames[m_firstPending].fence);
+		m_firstPending = (m_firstPending + 1) % MAX_FRAMES_IN_FLIGHT;
+		m_pendingCount--;
+	}
+}
+
+/***********************************************************
+ *  SetMaxFramesInFlight()
+ *
+ *  This method is used for setting how many presented frames
+ *  may still be processed by the GPU when a new one starts.
+ ***********************************************************/
+void FramePacer::SetMaxFramesInFlight(unsigned int maxFramesInFlight)
+{
+	if (maxFramesInFlight < 1)
+		maxFramesInFlight = 1;
+	if (maxFramesInFlight > MAX_FRAMES_IN_FLIGHT)
+		maxFramesInFlight = MAX_FRAMES_IN_FLIGHT;
+
+	m_maxFramesInFlight = maxFramesInFlight;
+}
+
+/***********************************************************
+ *  GetMaxFramesInFlight()
+ *
+ *  This method is used for getting the frames in flight limit.
+ ***********************************************************/
+unsigned int FramePacer::GetMaxFramesInFlight() const
+{
+	return(m_maxFramesInFlight);
+}
+
+/***********************************************************
+ *  RetireOldestFrame()
+ *
+ *  This method is used for removing the oldest pending frame
+ *  once its fence has signaled and recording its latency.  It
+ *  returns false when the frame is still pending and bWait is
+ *  false.
+ ***********************************************************/
+bool FramePacer::RetireOldestFrame(bool bWait)
+{
+	if (m_pendingCount == 0)
+	{
+		return(false);
+	}
+
+	PENDING_FRAME& frame = m_pendingFrames[m_firstPending];
+	double waitStart = glfwGetTime();
+	GLenum waitResult = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, 0);
+
+	if (waitResult == GL_TIMEOUT_EXPIRED)
+	{
+		if (bWait == false)
+		{
+			return(false);
+		}
+
+		while (waitResult == GL_TIMEOUT_EXPIRED)
+		{
+			waitResult = glClientWaitSync(frame.fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceWaitTimeout);
+		}
+	}
+
+	double presentTime = glfwGetTime();
+	double latency = presentTime - frame.inputTime;
+
+	m_waitSum += presentTime - waitStart;
+	m_latencySum += latency;
+	if (latency > m_latencyMax)
+	{
+		m_latencyMax = latency;
+	}
+	m_intervalFrames++;
+
+	glDeleteSync(frame.fence);
+	m_firstPending = (m_firstPending + 1) % MAX_FRAMES_IN_FLIGHT;
+	m_pendingCount--;
+
+	return(true);
+}
+
+/***********************************************************
+ *  WaitForFrameSlot()
+ *
+ *  This method is used for blocking the GL thread until fewer
+ *  than the allowed number of frames are in flight.  Frames
+ *  that already finished are retired without waiting, so
+ *  their latency is measured close to when they completed.
+ ***********************************************************/
+void FramePacer::WaitForFrameSlot()
+{
+	while (RetireOldestFrame(false))
+	{
+	}
+
+	while (m_pendingCount >= m_maxFramesInFlight)
+	{
+		RetireOldestFrame(true);
+	}
+}
+
+/***********************************************************
+ *  WaitForAllFrames()
+ *
+ *  This method is used for retiring every pending frame, so
+ *  their latency is recorded before the render loop goes idle.
+ ***********************************************************/
+void FramePacer::WaitForAllFrames()
+{
+	while (m_pendingCount > 0)
+	{
+		RetireOldestFrame(true);
+	}
+}
+
+/***********************************************************
+ *  FramePresented()
+ *
+ *  This method is used for fencing the frame that was just
+ *  handed to glfwSwapBuffers().
+ ***********************************************************/
+void FramePacer::FramePresented(double inputTime)
+{
+	// never let the ring overflow, even if the limit was lowered
+	if (m_pendingCount == MAX_FRAMES_IN_FLIGHT)
+	{
+		RetireOldestFrame(true);
+	}
+
+	PENDING_FRAME& frame = m_pendingFrames[(m_firstPending + m_pendingCount) % MAX_FRAMES_IN_FLIGHT];
+	frame.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	frame.inputTime = inputTime;
+	m_pendingCount++;
+}
+
+/***********************************************************
+ *  RecordIdleTime()
+ *
+ *  This method is used for adding the time the on-demand
+ *  render loop spent blocked, so the busy share of each
+ *  reporting interval can be printed.
+ ***********************************************************/
+void FramePacer::RecordIdleTime(double seconds)
+{
+	m_idleSum += seconds;
+}
+
+/***********************************************************
+ *  ReportLatency()
+ *
+ *  This method is used for printing the average and worst
+ *  input-to-present latency, the time spent waiting on the
+ *  GPU and the share of time the render loop was busy, once
+ *  per reporting interval.
+ ***********************************************************/
+void FramePacer::ReportLatency(double reportInterval)
+{
+	double now = glfwGetTime();
+
+	if ((now - m_intervalStart) < reportInterval)
+	{
+		return;
+	}
+
+	if (m_intervalFrames > 0)
+	{
+		std::cout << "INFO: Frames:" << m_intervalFrames
+			<< ", in flight:" << m_maxFramesInFlight
+			<< ", input-to-present ms avg:" << (m_latencySum / m_intervalFrames) * 1000.0
+			<< ", max:" << m_latencyMax * 1000.0
+			<< ", GPU wait ms avg:" << (m_waitSum / m_intervalFrames) * 1000.0
+			<< ", busy %:" << (1.0 - (m_idleSum / (now - m_intervalStart))) * 100.0 << std::endl;
+	}
+
+	m_intervalStart = now;
+	m_intervalFrames = 0;
+	m_latencySum = 0.0;
+	m_latencyMax = 0.0;
+	m_waitSum = 0.0;
+	m_idleSum = 0.0;
+}
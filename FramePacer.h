@@ -0,0 +1,72 @@
+///////////////////////////////////////////////////////////////////////////////
+// framepacer.h
+// ============
+// limit how many frames the CPU may queue ahead of the GPU and measure
+// the latency from input sampling to presentation
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  FramePacer
+ *
+ *  This class places a fence after each presented frame and
+ *  blocks the GL thread before a new frame while too many of
+ *  those fences are still pending.  When a fence signals, the
+ *  time since the frame's input was sampled is recorded as
+ *  its input-to-present latency.
+ ***********************************************************/
+class FramePacer
+{
+public:
+	// constructor
+	FramePacer(unsigned int maxFramesInFlight);
+	// destructor
+	~FramePacer();
+
+	// upper bound for the frames in flight setting
+	static const unsigned int MAX_FRAMES_IN_FLIGHT = 4;
+
+private:
+	// presented frame still being processed by the GPU
+	struct PENDING_FRAME
+	{
+		GLsync fence;
+		double inputTime;
+	};
+
+	// ring of pending frames, oldest first
+	PENDING_FRAME m_pendingFrames[MAX_FRAMES_IN_FLIGHT];
+	unsigned int m_firstPending;
+	unsigned int m_pendingCount;
+	unsigned int m_maxFramesInFlight;
+
+	// statistics of the current reporting interval
+	double m_intervalStart;
+	unsigned int m_intervalFrames;
+	double m_latencySum;
+	double m_latencyMax;
+	double m_waitSum;
+	double m_idleSum;
+
+	// retire the oldest pending frame, waiting for it when asked
+	bool RetireOldestFrame(bool bWait);
+
+public:
+	// set how many presented frames may be pending on the GPU
+	void SetMaxFramesInFlight(unsigned int maxFramesInFlight);
+	unsigned int GetMaxFramesInFlight() const;
+
+	// block until a new frame may be started
+	void WaitForFrameSlot();
+	// block until every presented frame has been processed
+	void WaitForAllFrames();
+	// fence the frame just presented, with the time its input was sampled
+	void FramePresented(double inputTime);
+	// add time the render loop spent blocked waiting for events
+	void RecordIdleTime(double seconds);
+	// print the latency statistics every reportInterval seconds
+	void ReportLatency(double reportInterval);
+};
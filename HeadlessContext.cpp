@@ -0,0 +1,175 @@
+///////////////////////////////////////////////////////////////////////////////
+// headlesscontext.cpp
+// ============
+// create an OpenGL context through EGL without a window or a display server
+///////////////////////////////////////////////////////////////////////////////
+
+#include "HeadlessContext.h"
+
+#include <EGL/eglext.h>
+
+#include <cstring>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// core profile versions tried in turn, the shaders need 3.3
+	const EGLint g_ContextVersions[][2] = { { 4, 6 }, { 4, 5 }, { 4, 3 }, { 3, 3 } };
+}
+
+/***********************************************************
+ *  HeadlessContext()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+HeadlessContext::HeadlessContext()
+{
+	m_display = EGL_NO_DISPLAY;
+	m_surface = EGL_NO_SURFACE;
+	m_context = EGL_NO_CONTEXT;
+}
+
+/***********************************************************
+ *  ~HeadlessContext()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+HeadlessContext::~HeadlessContext()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  OpenDisplay()
+ *
+ *  This method is used for opening Mesa's surfaceless
+ *  platform display, which renders without any window
+ *  system, falling back to the default display when the
+ *  EGL implementation does not list that platform.
+ ***********************************************************/
+EGLDisplay HeadlessContext::OpenDisplay()
+{
+#ifdef EGL_MESA_platform_surfaceless
+	const char* extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+	if ((NULL != extensions) && (NULL != strstr(extensions, "EGL_MESA_platform_surfaceless")))
+	{
+		PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+			(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+		if (NULL != getPlatformDisplay)
+		{
+			EGLDisplay display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+			if (EGL_NO_DISPLAY != display)
+			{
+				return(display);
+			}
+		}
+	}
+#endif
+
+	return(eglGetDisplay(EGL_DEFAULT_DISPLAY));
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for initializing EGL, creating a
+ *  pbuffer surface of the given size and the newest core
+ *  profile context the driver offers, and making it
+ *  current on the calling thread.
+ ***********************************************************/
+bool HeadlessContext::Create(int width, int height)
+{
+	const EGLint configAttributes[] = {
+		EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+		EGL_RED_SIZE, 8,
+		EGL_GREEN_SIZE, 8,
+		EGL_BLUE_SIZE, 8,
+		EGL_ALPHA_SIZE, 8,
+		EGL_DEPTH_SIZE, 24,
+		EGL_NONE
+	};
+	const EGLint surfaceAttributes[] = {
+		EGL_WIDTH, width,
+		EGL_HEIGHT, height,
+		EGL_NONE
+	};
+	EGLint major = 0;
+	EGLint minor = 0;
+	EGLConfig config = NULL;
+	EGLint configCount = 0;
+
+	m_display = OpenDisplay();
+	if ((EGL_NO_DISPLAY == m_display) || (eglInitialize(m_display, &major, &minor) == EGL_FALSE))
+	{
+		std::cerr << "ERROR: Could not initialize an EGL display" << std::endl;
+		m_display = EGL_NO_DISPLAY;
+		return(false);
+	}
+
+	if ((eglChooseConfig(m_display, configAttributes, &config, 1, &configCount) == EGL_FALSE) ||
+		(configCount == 0) ||
+		(eglBindAPI(EGL_OPENGL_API) == EGL_FALSE))
+	{
+		std::cerr << "ERROR: EGL " << major << "." << minor << " offers no OpenGL pbuffer configuration" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	m_surface = eglCreatePbufferSurface(m_display, config, surfaceAttributes);
+	if (EGL_NO_SURFACE == m_surface)
+	{
+		std::cerr << "ERROR: Could not create a " << width << "x" << height << " pbuffer surface" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	for (size_t i = 0; (i < sizeof(g_ContextVersions) / sizeof(g_ContextVersions[0])) && (EGL_NO_CONTEXT == m_context); i++)
+	{
+		const EGLint contextAttributes[] = {
+			EGL_CONTEXT_MAJOR_VERSION, g_ContextVersions[i][0],
+			EGL_CONTEXT_MINOR_VERSION, g_ContextVersions[i][1],
+			EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+			EGL_NONE
+		};
+		m_context = eglCreateContext(m_display, config, EGL_NO_CONTEXT, contextAttributes);
+	}
+	if ((EGL_NO_CONTEXT == m_context) || (eglMakeCurrent(m_display, m_surface, m_surface, m_context) == EGL_FALSE))
+	{
+		std::cerr << "ERROR: Could not create an OpenGL 3.3 or later core profile context" << std::endl;
+		Destroy();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for releasing the context and the
+ *  surface, and terminating the display.
+ ***********************************************************/
+void HeadlessContext::Destroy()
+{
+	if (EGL_NO_DISPLAY == m_display)
+	{
+		return;
+	}
+
+	eglMakeCurrent(m_display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (EGL_NO_CONTEXT != m_context)
+	{
+		eglDestroyContext(m_display, m_context);
+		m_context = EGL_NO_CONTEXT;
+	}
+	if (EGL_NO_SURFACE != m_surface)
+	{
+		eglDestroySurface(m_display, m_surface);
+		m_surface = EGL_NO_SURFACE;
+	}
+	eglTerminate(m_display);
+	m_display = EGL_NO_DISPLAY;
+}
@@ -0,0 +1,42 @@
+///////////////////////////////////////////////////////////////////////////////
+// headlesscontext.h
+// ============
+// create an OpenGL context through EGL without a window or a display server
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <EGL/egl.h>
+
+/***********************************************************
+ *  HeadlessContext
+ *
+ *  This class contains an OpenGL core profile context made
+ *  current on a small pbuffer surface.  The EGL display is
+ *  taken from Mesa's surfaceless platform when the driver
+ *  offers it, so no X11 or Wayland server is needed, e.g.
+ *  on a build machine rendering with llvmpipe, and from the
+ *  default display otherwise.
+ ***********************************************************/
+class HeadlessContext
+{
+public:
+	// constructor
+	HeadlessContext();
+	// destructor
+	~HeadlessContext();
+
+	// create the newest core profile context from 4.6 down to 3.3
+	// and make it current, returns false when EGL or OpenGL is missing
+	bool Create(int width, int height);
+	// release the context, the surface and the display
+	void Destroy();
+
+private:
+	EGLDisplay m_display;
+	EGLSurface m_surface;
+	EGLContext m_context;
+
+	// open the surfaceless platform display, or the default one
+	static EGLDisplay OpenDisplay();
+};
@@ -0,0 +1,240 @@
+///////////////////////////////////////////////////////////////////////////////
+// instanceringbuffer.cpp
+// ============
+// manage a persistently mapped buffer that streams the per-instance data
+// of each frame to the GPU without mapping or orphaning stalls
+///////////////////////////////////////////////////////////////////////////////
+
+#include "InstanceRingBuffer.h"
+#include "ResourceTracker.h"
+
+#include <chrono>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// time slice for each wait on a region fence, in nanoseconds
+	const GLuint64 g_FenceWaitTimeout = 1000000;
+}
+
+/***********************************************************
+ *  InstanceRingBuffer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+InstanceRingBuffer::InstanceRingBuffer()
+{
+	m_bufferID = 0;
+	m_pMappedData = NULL;
+	m_regionCount = 0;
+	m_maxInstances = 0;
+	m_regionBytes = 0;
+	m_regionFences = NULL;
+	m_nextRegion = 0;
+	m_fenceWaitMilliseconds = 0.0;
+}
+
+/***********************************************************
+ *  ~InstanceRingBuffer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+InstanceRingBuffer::~InstanceRingBuffer()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for allocating the immutable buffer
+ *  storage for all the regions and mapping it once for the
+ *  lifetime of the buffer.
+ ***********************************************************/
+bool InstanceRingBuffer::Create(unsigned int regionCount, size_t maxInstances)
+{
+	if (!GLEW_VERSION_4_4 && !GLEW_ARB_buffer_storage)
+	{
+		std::cout << "Persistent instance buffer needs OpenGL 4.4 buffer storage" << std::endl;
+		return false;
+	}
+
+	Destroy();
+
+	// keep each region aligned for binding it as a storage range
+	GLint alignment = 256;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	m_regionBytes = maxInstances * sizeof(INSTANCE_DATA);
+	m_regionBytes = ((m_regionBytes + alignment - 1) / alignment) * alignment;
+	m_regionCount = regionCount;
+	m_maxInstances = maxInstances;
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	glGenBuffers(1, &m_bufferID);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_bufferID);
+	glBufferStorage(GL_SHADER_STORAGE_BUFFER, m_regionBytes * m_regionCount, NULL, flags);
+	m_pMappedData = (unsigned char*)glMapBufferRange(
+		GL_SHADER_STORAGE_BUFFER, 0, m_regionBytes * m_regionCount, flags);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	ResourceTracker::Allocate(ResourceCategory::Buffer, m_bufferID, m_regionBytes * m_regionCount, "Instance ring buffer");
+
+	if (m_pMappedData == NULL)
+	{
+		std::cout << "Could not map the persistent instance buffer" << std::endl;
+		Destroy();
+		return false;
+	}
+
+	m_regionFences = new GLsync[m_regionCount];
+	for (unsigned int i = 0; i < m_regionCount; i++)
+	{
+		m_regionFences[i] = 0;
+	}
+	m_nextRegion = 0;
+
+	std::cout << "Created instance ring buffer, regions:" << m_regionCount << ", instances per region:" << m_maxInstances << std::endl;
+
+	return true;
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the fences and the buffer.
+ ***********************************************************/
+void InstanceRingBuffer::Destroy()
+{
+	if (NULL != m_regionFences)
+	{
+		for (unsigned int i = 0; i < m_regionCount; i++)
+		{
+			if (m_regionFences[i] != 0)
+			{
+				glDeleteSync(m_regionFences[i]);
+			}
+		}
+		delete[] m_regionFences;
+		m_regionFences = NULL;
+	}
+
+	if (m_bufferID != 0)
+	{
+		if (NULL != m_pMappedData)
+		{
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_bufferID);
+			glUnmapBuffer(GL_SHADER_STORAGE_BUFFER);
+			glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		}
+		glDeleteBuffers(1, &m_bufferID);
+		ResourceTracker::Release(ResourceCategory::Buffer, m_bufferID);
+		m_bufferID = 0;
+	}
+
+	m_pMappedData = NULL;
+	m_regionCount = 0;
+	m_maxInstances = 0;
+}
+
+/***********************************************************
+ *  AcquireRegion()
+ *
+ *  This method is used for taking the next region of the
+ *  ring.  When the GPU may still read it, the method waits on
+ *  the fence placed after the frame that last used it.  Must
+ *  be called on the thread owning the OpenGL context.
+ ***********************************************************/
+INSTANCE_DATA* InstanceRingBuffer::AcquireRegion(int& regionIndex)
+{
+	if (NULL == m_pMappedData)
+	{
+		regionIndex = -1;
+		return(NULL);
+	}
+
+	regionIndex = (int)m_nextRegion;
+	m_nextRegion = (m_nextRegion + 1) % m_regionCount;
+
+	GLsync fence = m_regionFences[regionIndex];
+	if (fence != 0)
+	{
+		auto waitStart = std::chrono::steady_clock::now();
+		GLenum waitResult = GL_TIMEOUT_EXPIRED;
+
+		while (waitResult == GL_TIMEOUT_EXPIRED)
+		{
+			waitResult = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, g_FenceWaitTimeout);
+		}
+
+		m_fenceWaitMilliseconds += std::chrono::duration<double, std::milli>(
+			std::chrono::steady_clock::now() - waitStart).count();
+
+		glDeleteSync(fence);
+		m_regionFences[regionIndex] = 0;
+	}
+
+	return((INSTANCE_DATA*)(m_pMappedData + (m_regionBytes * regionIndex)));
+}
+
+/***********************************************************
+ *  BindRegion()
+ *
+ *  This method is used for binding one region as the
+ *  instance block read by the vertex shader.
+ ***********************************************************/
+void InstanceRingBuffer::BindRegion(int regionIndex, GLuint bindingPoint)
+{
+	if ((regionIndex < 0) || (m_bufferID == 0))
+	{
+		return;
+	}
+
+	glBindBufferRange(
+		GL_SHADER_STORAGE_BUFFER,
+		bindingPoint,
+		m_bufferID,
+		m_regionBytes * regionIndex,
+		m_regionBytes);
+}
+
+/***********************************************************
+ *  ReleaseRegion()
+ *
+ *  This method is used for placing a fence after the draws
+ *  that read a region, so it is not overwritten too early.
+ ***********************************************************/
+void InstanceRingBuffer::ReleaseRegion(int regionIndex)
+{
+	if ((regionIndex < 0) || (NULL == m_regionFences))
+	{
+		return;
+	}
+
+	if (m_regionFences[regionIndex] != 0)
+	{
+		glDeleteSync(m_regionFences[regionIndex]);
+	}
+	m_regionFences[regionIndex] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/***********************************************************
+ *  GetMaxInstances()
+ *
+ *  This method is used for getting the capacity of a region.
+ ***********************************************************/
+size_t InstanceRingBuffer::GetMaxInstances() const
+{
+	return(m_maxInstances);
+}
+
+/***********************************************************
+ *  GetFenceWaitMilliseconds()
+ *
+ *  This method is used for getting the total time spent
+ *  waiting for the GPU to release regions.
+ ***********************************************************/
+double InstanceRingBuffer::GetFenceWaitMilliseconds() const
+{
+	return(m_fenceWaitMilliseconds);
+}
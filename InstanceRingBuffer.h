@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// instanceringbuffer.h
+// ============
+// manage a persistently mapped buffer that streams the per-instance data
+// of each frame to the GPU without mapping or orphaning stalls
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+
+/***********************************************************
+ *  INSTANCE_DATA
+ *
+ *  Per-instance values of one draw, laid out to match this
+ *  std430 block in the vertex shader:
+ *
+ *    struct InstanceData { mat4 model; vec4 color;
+ *                          vec4 UVscaleAndTexture; };
+ *    layout(std430, binding = 0) buffer InstanceBlock
+ *    { InstanceData instances[]; };
+ *    uniform int instanceIndex;  // -1 uses the uniforms
+ ***********************************************************/
+struct INSTANCE_DATA
+{
+	glm::mat4 model;
+	glm::vec4 color;
+	// UV scale in xy, 1.0 in z when textured, unused w
+	glm::vec4 UVscaleAndTexture;
+};
+
+/***********************************************************
+ *  InstanceRingBuffer
+ *
+ *  This class contains one coherent, persistently mapped
+ *  shader storage buffer split into a region per frame in
+ *  flight.  A fence placed after the draws of a frame guards
+ *  its region until the GPU has finished reading it.
+ ***********************************************************/
+class InstanceRingBuffer
+{
+public:
+	// constructor
+	InstanceRingBuffer();
+	// destructor
+	~InstanceRingBuffer();
+
+private:
+	// buffer object and its persistent mapping
+	GLuint m_bufferID;
+	unsigned char* m_pMappedData;
+	// number of regions and instances per region
+	unsigned int m_regionCount;
+	size_t m_maxInstances;
+	size_t m_regionBytes;
+	// fence guarding each region, or 0 when it is free
+	GLsync* m_regionFences;
+	// next region to be handed out
+	unsigned int m_nextRegion;
+	// accumulated time spent waiting for the GPU
+	double m_fenceWaitMilliseconds;
+
+public:
+	// create and map the buffer, false when the GL version lacks
+	// buffer storage
+	bool Create(unsigned int regionCount, size_t maxInstances);
+	// unmap and delete the buffer
+	void Destroy();
+
+	// wait until the next region is no longer read by the GPU and
+	// return its mapped memory for the CPU to fill
+	INSTANCE_DATA* AcquireRegion(int& regionIndex);
+	// bind a region to the shader storage binding point
+	void BindRegion(int regionIndex, GLuint bindingPoint);
+	// fence a region after the draws that read it were submitted
+	void ReleaseRegion(int regionIndex);
+
+	size_t GetMaxInstances() const;
+	double GetFenceWaitMilliseconds() const;
+};
@@ -0,0 +1,265 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// manage a pool of worker threads that split ranges of work between
+// them, stealing from each other when their own queue runs dry
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+JobSystem::JobSystem(unsigned int workerCount)
+{
+	m_queueCount = workerCount + 1;
+	m_queues = new WORK_QUEUE[m_queueCount];
+	for (unsigned int i = 0; i < m_queueCount; i++)
+	{
+		m_queues[i].head = 0;
+		m_queues[i].count = 0;
+	}
+
+	m_nextQueue = 0;
+	m_queuedJobs = 0;
+	m_bStopRequested = false;
+
+	for (unsigned int i = 0; i < workerCount; i++)
+	{
+		m_workers.push_back(std::thread(&JobSystem::WorkerMain, this, i));
+	}
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+		m_bStopRequested = true;
+	}
+	m_sleepCondition.notify_all();
+
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+
+	delete[] m_queues;
+	m_queues = NULL;
+}
+
+/***********************************************************
+ *  GetThreadCount()
+ *
+ *  This method is used for getting the number of threads that
+ *  run jobs, counting the thread calling ParallelFor().
+ ***********************************************************/
+unsigned int JobSystem::GetThreadCount() const
+{
+	return(m_queueCount);
+}
+
+/***********************************************************
+ *  PushJob()
+ *
+ *  This method is used for adding a job to the newest end of
+ *  a queue.  It returns false when the queue is full.
+ ***********************************************************/
+bool JobSystem::PushJob(unsigned int queueIndex, const JOB& job)
+{
+	WORK_QUEUE& queue = m_queues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+
+	if (queue.count == QUEUE_CAPACITY)
+	{
+		return(false);
+	}
+
+	queue.jobs[(queue.head + queue.count) % QUEUE_CAPACITY] = job;
+	queue.count++;
+	m_queuedJobs++;
+
+	return(true);
+}
+
+/***********************************************************
+ *  PopJob()
+ *
+ *  This method is used by the owner of a queue for taking
+ *  the newest job, which is the most likely to be in cache.
+ ***********************************************************/
+bool JobSystem::PopJob(unsigned int queueIndex, JOB& job)
+{
+	WORK_QUEUE& queue = m_queues[queueIndex];
+	std::lock_guard<std::mutex> lock(queue.mutex);
+
+	if (queue.count == 0)
+	{
+		return(false);
+	}
+
+	queue.count--;
+	job = queue.jobs[(queue.head + queue.count) % QUEUE_CAPACITY];
+	m_queuedJobs--;
+
+	return(true);
+}
+
+/***********************************************************
+ *  StealJob()
+ *
+ *  This method is used for taking the oldest job from the
+ *  queue of another thread, starting after the thief's own.
+ ***********************************************************/
+bool JobSystem::StealJob(unsigned int thiefIndex, JOB& job)
+{
+	for (unsigned int offset = 1; offset < m_queueCount; offset++)
+	{
+		WORK_QUEUE& queue = m_queues[(thiefIndex + offset) % m_queueCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+
+		if (queue.count > 0)
+		{
+			job = queue.jobs[queue.head];
+			queue.head = (queue.head + 1) % QUEUE_CAPACITY;
+			queue.count--;
+			m_queuedJobs--;
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  FindJob()
+ *
+ *  This method is used for getting the next job to run,
+ *  preferring the thread's own queue over stealing.
+ ***********************************************************/
+bool JobSystem::FindJob(unsigned int queueIndex, JOB& job)
+{
+	if (PopJob(queueIndex, job))
+	{
+		return(true);
+	}
+
+	return(StealJob(queueIndex, job));
+}
+
+/***********************************************************
+ *  RunJob()
+ *
+ *  This method is used for running a job and marking its
+ *  range as finished.
+ ***********************************************************/
+void JobSystem::RunJob(const JOB& job)
+{
+	(*job.pBody)(job.begin, job.end);
+	job.pRemaining->fetch_sub(1, std::memory_order_acq_rel);
+}
+
+/***********************************************************
+ *  WorkerMain()
+ *
+ *  This method is the body of each worker thread.  Workers
+ *  sleep while every queue is empty.
+ ***********************************************************/
+void JobSystem::WorkerMain(unsigned int workerIndex)
+{
+	while (true)
+	{
+		JOB job;
+
+		if (FindJob(workerIndex, job))
+		{
+			RunJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_sleepMutex);
+		m_sleepCondition.wait(lock, [this] { return m_bStopRequested || (m_queuedJobs > 0); });
+		if (m_bStopRequested)
+		{
+			break;
+		}
+	}
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for splitting a range into jobs spread
+ *  over all the worker queues.  The calling thread runs jobs
+ *  too, so nested calls from inside a job cannot deadlock.
+ ***********************************************************/
+void JobSystem::ParallelFor(
+	size_t count,
+	size_t grainSize,
+	const RANGE_FUNCTION& body)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	if (grainSize == 0)
+	{
+		grainSize = 1;
+	}
+
+	// without workers, or with a single range, run the ranges in order
+	if ((m_queueCount == 1) || (count <= grainSize))
+	{
+		for (size_t begin = 0; begin < count; begin += grainSize)
+		{
+			body(begin, (begin + grainSize < count) ? (begin + grainSize) : count);
+		}
+		return;
+	}
+
+	std::atomic<size_t> remaining((count + grainSize - 1) / grainSize);
+	unsigned int callerQueue = m_queueCount - 1;
+
+	for (size_t begin = 0; begin < count; begin += grainSize)
+	{
+		JOB job;
+		job.pBody = &body;
+		job.begin = begin;
+		job.end = (begin + grainSize < count) ? (begin + grainSize) : count;
+		job.pRemaining = &remaining;
+
+		// spread the ranges round robin over all the queues, running
+		// a range directly when its queue is full
+		unsigned int queueIndex = m_nextQueue++ % m_queueCount;
+		if (PushJob(queueIndex, job) == false)
+		{
+			RunJob(job);
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(m_sleepMutex);
+	}
+	m_sleepCondition.notify_all();
+
+	// help with the queued jobs until this range is finished
+	while (remaining.load(std::memory_order_acquire) > 0)
+	{
+		JOB job;
+
+		if (FindJob(callerQueue, job))
+		{
+			RunJob(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
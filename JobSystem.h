@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// manage a pool of worker threads that split ranges of work between
+// them, stealing from each other when their own queue runs dry
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class contains a fixed pool of worker threads, each
+ *  with its own queue of jobs.  A worker takes the newest job
+ *  from its own queue and steals the oldest job from another
+ *  queue when its own is empty.  The thread calling
+ *  ParallelFor() also runs jobs until its range is finished.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// constructor
+	JobSystem(unsigned int workerCount);
+	// destructor
+	~JobSystem();
+
+	// body of a parallel for, called with [begin, end) sub ranges -
+	// it only refers to the callable it is made from, so unlike a
+	// std::function holding a lambda it never allocates, and the
+	// callable must outlive the ParallelFor() call
+	class RANGE_FUNCTION
+	{
+	public:
+		template <typename FUNCTION>
+		RANGE_FUNCTION(const FUNCTION& body) : m_pBody(&body), m_pInvoke(&Invoke<FUNCTION>) {}
+
+		void operator()(size_t begin, size_t end) const { m_pInvoke(m_pBody, begin, end); }
+
+	private:
+		const void* m_pBody;
+		void (*m_pInvoke)(const void* pBody, size_t begin, size_t end);
+
+		template <typename FUNCTION>
+		static void Invoke(const void* pBody, size_t begin, size_t end) { (*(const FUNCTION*)pBody)(begin, end); }
+	};
+
+private:
+	// one sub range of a parallel for
+	struct JOB
+	{
+		const RANGE_FUNCTION* pBody;
+		size_t begin;
+		size_t end;
+		std::atomic<size_t>* pRemaining;
+	};
+
+	// fixed capacity ring of jobs guarded by its own lock
+	static const size_t QUEUE_CAPACITY = 1024;
+	struct WORK_QUEUE
+	{
+		std::mutex mutex;
+		JOB jobs[QUEUE_CAPACITY];
+		size_t head;
+		size_t count;
+	};
+
+	// worker threads and their queues - the last queue is
+	// shared by the threads calling ParallelFor()
+	std::vector<std::thread> m_workers;
+	WORK_QUEUE* m_queues;
+	unsigned int m_queueCount;
+	// next queue to receive a job
+	std::atomic<unsigned int> m_nextQueue;
+
+	// idle workers sleep until jobs are pushed
+	std::atomic<size_t> m_queuedJobs;
+	std::atomic<bool> m_bStopRequested;
+	std::mutex m_sleepMutex;
+	std::condition_variable m_sleepCondition;
+
+	// queue operations
+	bool PushJob(unsigned int queueIndex, const JOB& job);
+	bool PopJob(unsigned int queueIndex, JOB& job);
+	bool StealJob(unsigned int thiefIndex, JOB& job);
+	bool FindJob(unsigned int queueIndex, JOB& job);
+	void RunJob(const JOB& job);
+
+	// body of each worker thread
+	void WorkerMain(unsigned int workerIndex);
+
+public:
+	// number of threads that run jobs, including the caller
+	unsigned int GetThreadCount() const;
+
+	// split [0, count) into ranges of at most grainSize elements,
+	// run them on all the threads and return when all are done
+	void ParallelFor(
+		size_t count,
+		size_t grainSize,
+		const RANGE_FUNCTION& body);
+};
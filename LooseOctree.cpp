@@ -0,0 +1,715 @@
+///////////////////////////////////////////////////////////////////////////////
+// looseoctree.cpp
+// ============
+// spatial index over object bounds, updated in place as objects are added,
+// moved and removed, answering frustum, sphere and ray queries
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LooseOctree.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// declaration of global variables
+namespace
+{
+	// most times the root doubles to reach one object, the rest of
+	// an unreachable object is kept in the root
+	const int g_MaxRootGrowth = 32;
+
+	// center and largest half extent of a box
+	void GetBoxCenterAndRadius(const BOUNDING_BOX& bounds, glm::vec3& center, float& radius)
+	{
+		glm::vec3 halfExtent = (bounds.maxXYZ - bounds.minXYZ) * 0.5f;
+
+		center = (bounds.minXYZ + bounds.maxXYZ) * 0.5f;
+		radius = std::fmax(halfExtent.x, std::fmax(halfExtent.y, halfExtent.z));
+	}
+}
+
+/***********************************************************
+ *  LooseOctree()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LooseOctree::LooseOctree(const glm::vec3& center, float halfSize, float minHalfSize)
+{
+	m_initialCenter = center;
+	m_initialHalfSize = halfSize;
+	m_minHalfSize = minHalfSize;
+	m_root = -1;
+	m_objectCount = 0;
+
+	Clear();
+}
+
+/***********************************************************
+ *  ~LooseOctree()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LooseOctree::~LooseOctree()
+{
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing every object and going
+ *  back to a single root node.
+ ***********************************************************/
+void LooseOctree::Clear()
+{
+	m_nodes.clear();
+	m_freeNodes.clear();
+	m_entries.clear();
+	m_objectCount = 0;
+	m_root = AllocateNode(m_initialCenter, m_initialHalfSize, -1);
+}
+
+/***********************************************************
+ *  AllocateNode()
+ *
+ *  This method is used for taking an empty node from the
+ *  free list or the end of the pool.
+ ***********************************************************/
+int LooseOctree::AllocateNode(const glm::vec3& center, float halfSize, int parent)
+{
+	int nodeIndex = 0;
+
+	if (m_freeNodes.size() > 0)
+	{
+		nodeIndex = m_freeNodes.back();
+		m_freeNodes.pop_back();
+	}
+	else
+	{
+		nodeIndex = (int)m_nodes.size();
+		m_nodes.push_back(NODE());
+	}
+
+	NODE& node = m_nodes[nodeIndex];
+	node.center = center;
+	node.halfSize = halfSize;
+	node.parent = parent;
+	for (int octant = 0; octant < 8; octant++)
+	{
+		node.children[octant] = -1;
+	}
+	// a reused node keeps the capacity of its slots
+	node.objects.clear();
+	node.subtreeCount = 0;
+
+	return(nodeIndex);
+}
+
+/***********************************************************
+ *  FreeNode()
+ *
+ *  This method is used for detaching an empty node from its
+ *  parent and returning it to the free list.
+ ***********************************************************/
+void LooseOctree::FreeNode(int nodeIndex)
+{
+	NODE& node = m_nodes[nodeIndex];
+
+	if (node.parent >= 0)
+	{
+		NODE& parent = m_nodes[node.parent];
+		for (int octant = 0; octant < 8; octant++)
+		{
+			if (parent.children[octant] == nodeIndex)
+			{
+				parent.children[octant] = -1;
+			}
+		}
+	}
+
+	m_freeNodes.push_back(nodeIndex);
+}
+
+/***********************************************************
+ *  GrowRoot()
+ *
+ *  This method is used for replacing the root with a cell
+ *  twice its size that extends toward the passed in point.
+ *  The old root becomes one of its octants, so every node
+ *  keeps its cell.
+ ***********************************************************/
+void LooseOctree::GrowRoot(const glm::vec3& towards)
+{
+	glm::vec3 oldCenter = m_nodes[m_root].center;
+	float oldHalfSize = m_nodes[m_root].halfSize;
+	glm::vec3 newCenter;
+	int octant = 0;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if (towards[axis] >= oldCenter[axis])
+		{
+			newCenter[axis] = oldCenter[axis] + oldHalfSize;
+		}
+		else
+		{
+			newCenter[axis] = oldCenter[axis] - oldHalfSize;
+			octant |= (1 << axis);
+		}
+	}
+
+	int oldRoot = m_root;
+	int newRoot = AllocateNode(newCenter, oldHalfSize * 2.0f, -1);
+	m_nodes[newRoot].children[octant] = oldRoot;
+	m_nodes[newRoot].subtreeCount = m_nodes[oldRoot].subtreeCount;
+	m_nodes[oldRoot].parent = newRoot;
+	m_root = newRoot;
+}
+
+/***********************************************************
+ *  IsHomeNode()
+ *
+ *  This method is used for checking whether an object with
+ *  the passed in center and largest half extent belongs in
+ *  a node: its center is in the cell, it is no larger than
+ *  the cell, and it is too large for the next level down.
+ ***********************************************************/
+bool LooseOctree::IsHomeNode(const NODE& node, const glm::vec3& center, float radius) const
+{
+	for (int axis = 0; axis < 3; axis++)
+	{
+		if ((center[axis] < node.center[axis] - node.halfSize) ||
+			(center[axis] >= node.center[axis] + node.halfSize))
+		{
+			return(false);
+		}
+	}
+
+	float childHalfSize = node.halfSize * 0.5f;
+	return((radius <= node.halfSize) &&
+		((radius > childHalfSize) || (childHalfSize < m_minHalfSize)));
+}
+
+/***********************************************************
+ *  FindHomeNode()
+ *
+ *  This method is used for finding the node an object is
+ *  stored in, growing the root until it holds the object and
+ *  creating the missing nodes on the way down.
+ ***********************************************************/
+int LooseOctree::FindHomeNode(const glm::vec3& center, float radius)
+{
+	// bounds that are not finite stay in the root
+	if (!std::isfinite(center.x) || !std::isfinite(center.y) || !std::isfinite(center.z) ||
+		!std::isfinite(radius))
+	{
+		return(m_root);
+	}
+
+	for (int growth = 0; growth < g_MaxRootGrowth; growth++)
+	{
+		const NODE& root = m_nodes[m_root];
+		bool bInside = (radius <= root.halfSize);
+		for (int axis = 0; axis < 3; axis++)
+		{
+			bInside = bInside &&
+				(center[axis] >= root.center[axis] - root.halfSize) &&
+				(center[axis] < root.center[axis] + root.halfSize);
+		}
+		if (bInside)
+		{
+			break;
+		}
+		GrowRoot(center);
+	}
+
+	int nodeIndex = m_root;
+	while (true)
+	{
+		glm::vec3 nodeCenter = m_nodes[nodeIndex].center;
+		float childHalfSize = m_nodes[nodeIndex].halfSize * 0.5f;
+		if ((radius > childHalfSize) || (childHalfSize < m_minHalfSize))
+		{
+			break;
+		}
+
+		int octant = 0;
+		glm::vec3 childCenter;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (center[axis] >= nodeCenter[axis])
+			{
+				childCenter[axis] = nodeCenter[axis] + childHalfSize;
+				octant |= (1 << axis);
+			}
+			else
+			{
+				childCenter[axis] = nodeCenter[axis] - childHalfSize;
+			}
+		}
+
+		int childIndex = m_nodes[nodeIndex].children[octant];
+		if (childIndex < 0)
+		{
+			// the pool may move, so only keep indices across this call
+			childIndex = AllocateNode(childCenter, childHalfSize, nodeIndex);
+			m_nodes[nodeIndex].children[octant] = childIndex;
+		}
+		nodeIndex = childIndex;
+	}
+
+	return(nodeIndex);
+}
+
+/***********************************************************
+ *  LinkObject()
+ *
+ *  This method is used for adding an object to the slots of
+ *  a node and counting it up to the root.
+ ***********************************************************/
+void LooseOctree::LinkObject(uint32_t id, const BOUNDING_BOX& bounds, int nodeIndex)
+{
+	OBJECT_SLOT slot;
+	slot.bounds = bounds;
+	slot.id = id;
+
+	m_entries[id].node = nodeIndex;
+	m_entries[id].slot = (int)m_nodes[nodeIndex].objects.size();
+	m_nodes[nodeIndex].objects.push_back(slot);
+
+	for (int index = nodeIndex; index >= 0; index = m_nodes[index].parent)
+	{
+		m_nodes[index].subtreeCount++;
+	}
+}
+
+/***********************************************************
+ *  UnlinkObject()
+ *
+ *  This method is used for removing an object from the slots
+ *  of its node by moving the last slot into its place, and
+ *  freeing the nodes left with empty subtrees.
+ ***********************************************************/
+void LooseOctree::UnlinkObject(uint32_t id)
+{
+	ENTRY& entry = m_entries[id];
+	std::vector<OBJECT_SLOT>& objects = m_nodes[entry.node].objects;
+
+	objects[entry.slot] = objects.back();
+	m_entries[objects[entry.slot].id].slot = entry.slot;
+	objects.pop_back();
+
+	int index = entry.node;
+	while (index >= 0)
+	{
+		int parent = m_nodes[index].parent;
+		m_nodes[index].subtreeCount--;
+		if ((m_nodes[index].subtreeCount == 0) && (index != m_root))
+		{
+			FreeNode(index);
+		}
+		index = parent;
+	}
+
+	entry.node = -1;
+	entry.slot = -1;
+}
+
+/***********************************************************
+ *  Insert()
+ *
+ *  This method is used for adding an object to the tree.
+ ***********************************************************/
+void LooseOctree::Insert(uint32_t id, const BOUNDING_BOX& bounds)
+{
+	if (Contains(id))
+	{
+		Update(id, bounds);
+		return;
+	}
+
+	if (id >= m_entries.size())
+	{
+		ENTRY empty;
+		empty.node = -1;
+		empty.slot = -1;
+		m_entries.resize(id + 1, empty);
+	}
+
+	glm::vec3 center;
+	float radius = 0.0f;
+	GetBoxCenterAndRadius(bounds, center, radius);
+
+	LinkObject(id, bounds, FindHomeNode(center, radius));
+	m_objectCount++;
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for setting the new bounds of an
+ *  object.  It only changes node when the object left its
+ *  cell or changed size enough to belong to another level.
+ ***********************************************************/
+void LooseOctree::Update(uint32_t id, const BOUNDING_BOX& bounds)
+{
+	if (Contains(id) == false)
+	{
+		Insert(id, bounds);
+		return;
+	}
+
+	glm::vec3 center;
+	float radius = 0.0f;
+	GetBoxCenterAndRadius(bounds, center, radius);
+
+	const ENTRY& entry = m_entries[id];
+	if (IsHomeNode(m_nodes[entry.node], center, radius))
+	{
+		m_nodes[entry.node].objects[entry.slot].bounds = bounds;
+		return;
+	}
+
+	UnlinkObject(id);
+	LinkObject(id, bounds, FindHomeNode(center, radius));
+}
+
+/***********************************************************
+ *  Remove()
+ *
+ *  This method is used for removing an object from the tree.
+ ***********************************************************/
+void LooseOctree::Remove(uint32_t id)
+{
+	if (Contains(id) == false)
+	{
+		return;
+	}
+
+	UnlinkObject(id);
+	m_objectCount--;
+}
+
+/***********************************************************
+ *  Contains()
+ *
+ *  This method is used for checking whether an object is
+ *  stored in the tree.
+ ***********************************************************/
+bool LooseOctree::Contains(uint32_t id) const
+{
+	return((id < m_entries.size()) && (m_entries[id].node >= 0));
+}
+
+/***********************************************************
+ *  GetObjectCount()
+ *
+ *  This method is used for getting the number of stored
+ *  objects, the room a query result buffer needs.
+ ***********************************************************/
+size_t LooseOctree::GetObjectCount() const
+{
+	return(m_objectCount);
+}
+
+/***********************************************************
+ *  GetNodeCount()
+ *
+ *  This method is used for getting the number of nodes in
+ *  use.
+ ***********************************************************/
+size_t LooseOctree::GetNodeCount() const
+{
+	return(m_nodes.size() - m_freeNodes.size());
+}
+
+/***********************************************************
+ *  AddSubtree()
+ *
+ *  This method is used for adding every object of a subtree
+ *  to the results without testing them.
+ ***********************************************************/
+void LooseOctree::AddSubtree(int nodeIndex, uint32_t* pResults, size_t& count) const
+{
+	const NODE& node = m_nodes[nodeIndex];
+
+	for (const OBJECT_SLOT& slot : node.objects)
+	{
+		pResults[count++] = slot.id;
+	}
+	for (int octant = 0; octant < 8; octant++)
+	{
+		if (node.children[octant] >= 0)
+		{
+			AddSubtree(node.children[octant], pResults, count);
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryFrustumNode()
+ *
+ *  This method is used for collecting the visible objects of
+ *  a subtree.  A node whose loose bounds are completely
+ *  inside the frustum adds its whole subtree untested.  The
+ *  root is never culled by its own bounds, since objects it
+ *  could not grow to reach are kept in it.
+ ***********************************************************/
+void LooseOctree::QueryFrustumNode(int nodeIndex, const FRUSTUM& frustum, bool bInside, uint32_t* pResults, size_t& count) const
+{
+	const NODE& node = m_nodes[nodeIndex];
+
+	if (bInside)
+	{
+		AddSubtree(nodeIndex, pResults, count);
+		return;
+	}
+
+	if (nodeIndex != m_root)
+	{
+		BOUNDING_BOX looseBounds;
+		looseBounds.minXYZ = node.center - glm::vec3(node.halfSize * 2.0f);
+		looseBounds.maxXYZ = node.center + glm::vec3(node.halfSize * 2.0f);
+		if (IsBoxInFrustum(frustum, looseBounds) == false)
+		{
+			return;
+		}
+		if (IsBoxInsideFrustum(frustum, looseBounds))
+		{
+			AddSubtree(nodeIndex, pResults, count);
+			return;
+		}
+	}
+
+	for (const OBJECT_SLOT& slot : node.objects)
+	{
+		if (IsBoxInFrustum(frustum, slot.bounds))
+		{
+			pResults[count++] = slot.id;
+		}
+	}
+	for (int octant = 0; octant < 8; octant++)
+	{
+		if (node.children[octant] >= 0)
+		{
+			QueryFrustumNode(node.children[octant], frustum, false, pResults, count);
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryFrustumsNode()
+ *
+ *  This method is used for collecting the objects of a
+ *  subtree visible in any of several frustums.  The test mask
+ *  holds the frustums that cut through the parent and the
+ *  inside mask those that contain it, so each frustum stops
+ *  being tested below the node where it stops mattering.
+ ***********************************************************/
+void LooseOctree::QueryFrustumsNode(int nodeIndex, const FRUSTUM* pFrustums, uint32_t testMask, uint32_t insideMask, uint32_t* pResults, uint32_t* pMasks, size_t& count) const
+{
+	const NODE& node = m_nodes[nodeIndex];
+
+	if (nodeIndex != m_root)
+	{
+		BOUNDING_BOX looseBounds;
+		looseBounds.minXYZ = node.center - glm::vec3(node.halfSize * 2.0f);
+		looseBounds.maxXYZ = node.center + glm::vec3(node.halfSize * 2.0f);
+		for (int i = 0; (i < MAX_QUERY_FRUSTUMS) && ((testMask >> i) != 0); i++)
+		{
+			uint32_t bit = (uint32_t)1 << i;
+			if ((testMask & bit) == 0)
+			{
+				continue;
+			}
+			if (IsBoxInFrustum(pFrustums[i], looseBounds) == false)
+			{
+				testMask &= ~bit;
+			}
+			else if (IsBoxInsideFrustum(pFrustums[i], looseBounds))
+			{
+				testMask &= ~bit;
+				insideMask |= bit;
+			}
+		}
+		if ((testMask | insideMask) == 0)
+		{
+			return;
+		}
+	}
+
+	for (const OBJECT_SLOT& slot : node.objects)
+	{
+		uint32_t mask = insideMask;
+		for (int i = 0; (i < MAX_QUERY_FRUSTUMS) && ((testMask >> i) != 0); i++)
+		{
+			if (((testMask >> i) & 1) && IsBoxInFrustum(pFrustums[i], slot.bounds))
+			{
+				mask |= (uint32_t)1 << i;
+			}
+		}
+		if (mask != 0)
+		{
+			pResults[count] = slot.id;
+			pMasks[count] = mask;
+			count++;
+		}
+	}
+	for (int octant = 0; octant < 8; octant++)
+	{
+		if (node.children[octant] >= 0)
+		{
+			QueryFrustumsNode(node.children[octant], pFrustums, testMask, insideMask, pResults, pMasks, count);
+		}
+	}
+}
+
+/***********************************************************
+ *  QuerySphereNode()
+ *
+ *  This method is used for collecting the objects of a
+ *  subtree that overlap a sphere.
+ ***********************************************************/
+void LooseOctree::QuerySphereNode(int nodeIndex, const glm::vec3& center, float radius, uint32_t* pResults, size_t& count) const
+{
+	const NODE& node = m_nodes[nodeIndex];
+
+	if (nodeIndex != m_root)
+	{
+		BOUNDING_BOX looseBounds;
+		looseBounds.minXYZ = node.center - glm::vec3(node.halfSize * 2.0f);
+		looseBounds.maxXYZ = node.center + glm::vec3(node.halfSize * 2.0f);
+		if (DoesBoxIntersectSphere(looseBounds, center, radius) == false)
+		{
+			return;
+		}
+	}
+
+	for (const OBJECT_SLOT& slot : node.objects)
+	{
+		if (DoesBoxIntersectSphere(slot.bounds, center, radius))
+		{
+			pResults[count++] = slot.id;
+		}
+	}
+	for (int octant = 0; octant < 8; octant++)
+	{
+		if (node.children[octant] >= 0)
+		{
+			QuerySphereNode(node.children[octant], center, radius, pResults, count);
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryRayNode()
+ *
+ *  This method is used for collecting the objects of a
+ *  subtree whose bounds a ray hits.
+ ***********************************************************/
+void LooseOctree::QueryRayNode(int nodeIndex, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, uint32_t* pResults, size_t& count) const
+{
+	const NODE& node = m_nodes[nodeIndex];
+	float distance = 0.0f;
+
+	if (nodeIndex != m_root)
+	{
+		BOUNDING_BOX looseBounds;
+		looseBounds.minXYZ = node.center - glm::vec3(node.halfSize * 2.0f);
+		looseBounds.maxXYZ = node.center + glm::vec3(node.halfSize * 2.0f);
+		if (IntersectRayBox(origin, inverseDirection, maxDistance, looseBounds, distance) == false)
+		{
+			return;
+		}
+	}
+
+	for (const OBJECT_SLOT& slot : node.objects)
+	{
+		if (IntersectRayBox(origin, inverseDirection, maxDistance, slot.bounds, distance))
+		{
+			pResults[count++] = slot.id;
+		}
+	}
+	for (int octant = 0; octant < 8; octant++)
+	{
+		if (node.children[octant] >= 0)
+		{
+			QueryRayNode(node.children[octant], origin, inverseDirection, maxDistance, pResults, count);
+		}
+	}
+}
+
+/***********************************************************
+ *  QueryFrustum()
+ *
+ *  This method is used for finding the objects whose bounds
+ *  are at least partly inside a view frustum.
+ ***********************************************************/
+size_t LooseOctree::QueryFrustum(const FRUSTUM& frustum, uint32_t* pResults) const
+{
+	size_t count = 0;
+
+	QueryFrustumNode(m_root, frustum, false, pResults, count);
+
+	return(count);
+}
+
+/***********************************************************
+ *  QueryFrustums()
+ *
+ *  This method is used for finding the objects whose bounds
+ *  are at least partly inside any of up to MAX_QUERY_FRUSTUMS
+ *  view frustums.  Each object is reported once, with bit i
+ *  of its mask set when it is in frustum i.
+ ***********************************************************/
+size_t LooseOctree::QueryFrustums(const FRUSTUM* pFrustums, int frustumCount, uint32_t* pResults, uint32_t* pMasks) const
+{
+	size_t count = 0;
+
+	if (frustumCount <= 0)
+	{
+		return(0);
+	}
+	frustumCount = std::min(frustumCount, (int)MAX_QUERY_FRUSTUMS);
+
+	uint32_t testMask = (frustumCount == MAX_QUERY_FRUSTUMS) ? 0xFFFFFFFFu : (((uint32_t)1 << frustumCount) - 1);
+	QueryFrustumsNode(m_root, pFrustums, testMask, 0, pResults, pMasks, count);
+
+	return(count);
+}
+
+/***********************************************************
+ *  QuerySphere()
+ *
+ *  This method is used for finding the objects whose bounds
+ *  overlap a sphere.
+ ***********************************************************/
+size_t LooseOctree::QuerySphere(const glm::vec3& center, float radius, uint32_t* pResults) const
+{
+	size_t count = 0;
+
+	QuerySphereNode(m_root, center, radius, pResults, count);
+
+	return(count);
+}
+
+/***********************************************************
+ *  QueryRay()
+ *
+ *  This method is used for finding the objects whose bounds
+ *  a ray hits within maxDistance of its origin.
+ ***********************************************************/
+size_t LooseOctree::QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, uint32_t* pResults) const
+{
+	size_t count = 0;
+	glm::vec3 inverseDirection;
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		inverseDirection[axis] = (direction[axis] != 0.0f) ?
+			(1.0f / direction[axis]) : std::numeric_limits<float>::infinity();
+	}
+
+	QueryRayNode(m_root, origin, inverseDirection, maxDistance, pResults, count);
+
+	return(count);
+}
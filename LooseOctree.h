@@ -0,0 +1,128 @@
+///////////////////////////////////////////////////////////////////////////////
+// looseoctree.h
+// ============
+// spatial index over object bounds, updated in place as objects are added,
+// moved and removed, answering frustum, sphere and ray queries
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "BoundingVolumes.h"
+
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  LooseOctree
+ *
+ *  This class contains a loose octree of object bounds.  The
+ *  bounds of each node are twice the size of its cell, so an
+ *  object is stored in the smallest cell that contains its
+ *  center and is at least as large as its biggest half
+ *  extent, without ever being split between nodes.  Moving
+ *  an object usually keeps it in the same node, and otherwise
+ *  relinks it in O(depth).  The root doubles toward objects
+ *  placed outside it, and nodes are created on demand and
+ *  freed once their subtree is empty.
+ *
+ *  Objects are identified by the caller's index, and each
+ *  query writes the matching IDs to a buffer with room for
+ *  GetObjectCount() IDs, in no particular order.
+ ***********************************************************/
+class LooseOctree
+{
+public:
+	// constructor - cell of the root and smallest cell size
+	LooseOctree(const glm::vec3& center, float halfSize, float minHalfSize);
+	// destructor
+	~LooseOctree();
+
+private:
+	// bounds of one object stored in a node
+	struct OBJECT_SLOT
+	{
+		BOUNDING_BOX bounds;
+		uint32_t id;
+	};
+
+	// one cell of the tree
+	struct NODE
+	{
+		glm::vec3 center;
+		float halfSize;
+		int parent;
+		int children[8];
+		// objects stored in this node, kept together so a query
+		// reads them in order, and the number in the whole subtree
+		std::vector<OBJECT_SLOT> objects;
+		unsigned int subtreeCount;
+	};
+
+	// node and slot of one object, or -1 when it is not stored
+	struct ENTRY
+	{
+		int node;
+		int slot;
+	};
+
+	std::vector<NODE> m_nodes;
+	std::vector<int> m_freeNodes;
+	std::vector<ENTRY> m_entries;
+	int m_root;
+	size_t m_objectCount;
+	// root cell given to the constructor, restored by Clear()
+	glm::vec3 m_initialCenter;
+	float m_initialHalfSize;
+	float m_minHalfSize;
+
+	// node pool
+	int AllocateNode(const glm::vec3& center, float halfSize, int parent);
+	void FreeNode(int nodeIndex);
+	// double the root toward a point outside it
+	void GrowRoot(const glm::vec3& towards);
+	// true when an object is stored in exactly this node
+	bool IsHomeNode(const NODE& node, const glm::vec3& center, float radius) const;
+	// find, creating it when needed, the node storing an object
+	int FindHomeNode(const glm::vec3& center, float radius);
+	// add and remove an object from the slots of its node
+	void LinkObject(uint32_t id, const BOUNDING_BOX& bounds, int nodeIndex);
+	void UnlinkObject(uint32_t id);
+
+	// recursive query steps
+	void AddSubtree(int nodeIndex, uint32_t* pResults, size_t& count) const;
+	void QueryFrustumNode(int nodeIndex, const FRUSTUM& frustum, bool bInside, uint32_t* pResults, size_t& count) const;
+	void QueryFrustumsNode(int nodeIndex, const FRUSTUM* pFrustums, uint32_t testMask, uint32_t insideMask, uint32_t* pResults, uint32_t* pMasks, size_t& count) const;
+	void QuerySphereNode(int nodeIndex, const glm::vec3& center, float radius, uint32_t* pResults, size_t& count) const;
+	void QueryRayNode(int nodeIndex, const glm::vec3& origin, const glm::vec3& inverseDirection, float maxDistance, uint32_t* pResults, size_t& count) const;
+
+public:
+	// most frustums a single QueryFrustums() call tests
+	static const int MAX_QUERY_FRUSTUMS = 32;
+
+	// remove every object and go back to the initial root
+	void Clear();
+
+	// add an object, or move it when the ID is already stored
+	void Insert(uint32_t id, const BOUNDING_BOX& bounds);
+	// set the new bounds of a stored object
+	void Update(uint32_t id, const BOUNDING_BOX& bounds);
+	// remove a stored object
+	void Remove(uint32_t id);
+	bool Contains(uint32_t id) const;
+
+	size_t GetObjectCount() const;
+	size_t GetNodeCount() const;
+
+	// objects whose bounds are at least partly inside the frustum
+	size_t QueryFrustum(const FRUSTUM& frustum, uint32_t* pResults) const;
+	// objects at least partly inside any of several frustums, in one
+	// walk of the tree, with a mask per result of the frustums it is in
+	size_t QueryFrustums(const FRUSTUM* pFrustums, int frustumCount, uint32_t* pResults, uint32_t* pMasks) const;
+	// objects whose bounds overlap the sphere
+	size_t QuerySphere(const glm::vec3& center, float radius, uint32_t* pResults) const;
+	// objects whose bounds the ray hits within maxDistance
+	size_t QueryRay(const glm::vec3& origin, const glm::vec3& direction, float maxDistance, uint32_t* pResults) const;
+};
@@ -1,5 +1,8 @@
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <cstring>          // strcmp
+#include <chrono>           // timing the shader reloads
+#include <thread>           // hardware thread count
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -11,6 +14,14 @@
 
 #include "SceneManager.h"
 #include "ViewManager.h"
+#include "FrameManager.h"
+#include "JobSystem.h"
+#include "InstanceRingBuffer.h"
+#include "FramePacer.h"
+#include "ResolutionScaler.h"
+#include "ResourceTracker.h"
+#include "BatchRenderer.h"
+#include "FileWatcher.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
 
@@ -19,6 +30,9 @@ namespace
 {
 	// Macro for window title
 	const char* const WINDOW_TITLE = "7-1 FinalProject and Milestones"; 
+	// external GLSL files of the shader program
+	const char* const VERTEX_SHADER_PATH = "../../Utilities/shaders/vertexShader.glsl";
+	const char* const FRAGMENT_SHADER_PATH = "../../Utilities/shaders/fragmentShader.glsl";
 	// Main GLFW window
 	GLFWwindow* g_Window = nullptr;
 	SceneManager* g_pSceneManager = nullptr;
@@ -28,12 +42,67 @@ namespace
 	ShaderManager* g_ShaderManager = nullptr;
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+	// frame manager object for building the draw lists on the scene update thread
+	FrameManager* g_FrameManager = nullptr;
+	// job system object for spreading the scene update over the cores
+	JobSystem* g_JobSystem = nullptr;
+	// persistently mapped buffer streaming the per-instance data
+	InstanceRingBuffer* g_InstanceBuffer = nullptr;
+	// regions of the instance buffer - one being written by the scene
+	// update thread plus the frames the GPU may still be reading
+	const unsigned int INSTANCE_BUFFER_REGIONS = 3;
+	const size_t INSTANCE_BUFFER_CAPACITY = 65536;
+	// frame pacer object limiting how far the CPU runs ahead of the GPU
+	FramePacer* g_FramePacer = nullptr;
+	// frames in flight limit, set with --frames-in-flight <count>
+	unsigned int g_MaxFramesInFlight = 2;
+	// sample input right before each frame is built, set with --low-latency
+	bool g_bLowLatency = false;
+	// seconds between latency reports
+	const double LATENCY_REPORT_INTERVAL = 5.0;
+	// only draw when something changed, set with --on-demand
+	bool g_bOnDemand = false;
+	// frames per second still drawn while idle in on-demand mode,
+	// 0 blocks until an event arrives, set with --idle-fps <rate>
+	double g_IdleFrameRate = 0.0;
+	// glfwGetTime() when the last on-demand frame was started
+	double g_LastRedrawTime = 0.0;
+	// offscreen scene target following the frame time budget
+	ResolutionScaler* g_ResolutionScaler = nullptr;
+	// GPU milliseconds allowed for the scene, set with --frame-budget <ms>
+	double g_FrameBudgetMilliseconds = 1000.0 / 60.0;
+	// lowest render scale, set with --min-render-scale <scale>
+	float g_MinRenderScale = 0.5f;
+	// always render at the framebuffer size, set with --fixed-resolution
+	bool g_bFixedResolution = false;
+	// GPU memory for the streamed textures in megabytes, 0 keeps the
+	// scene default, set with --texture-budget <MB>
+	double g_TextureBudgetMegabytes = 0.0;
+	// seconds between resource memory reports
+	const double RESOURCE_REPORT_INTERVAL = 30.0;
+	// shader program loaded by the shader manager
+	GLuint g_ShaderProgramID = 0;
+	// reload the shaders and textures edited on disk, set with --hot-reload
+	bool g_bHotReload = false;
+	// watcher of the shader and texture files when hot reloading
+	FileWatcher* g_FileWatcher = nullptr;
+	// frames per second drawn while idle in on-demand mode, so the
+	// watched files are still checked
+	const double HOT_RELOAD_IDLE_FPS = 4.0;
+	// start with the window split into four views, set with --quad-view
+	bool g_bQuadViews = false;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+bool WaitForRedraw();
+bool RunBatchRender(int argc, char* argv[]);
+void ProcessPickRequest(const VIEW_SET& viewSet);
+void ProcessFileChanges();
+void UpdateSceneAnimations();
+bool ReloadShaders();
 
 
 /***********************************************************
@@ -44,6 +113,69 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// render a list of camera poses or a turntable into PNG files
+	// in a hidden window
+	if ((argc > 1) && (strcmp(argv[1], "--batch") == 0))
+	{
+		return(RunBatchRender(argc, argv) ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	// read the frame pacing options
+	for (int i = 1; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "--frames-in-flight") == 0) && (i + 1 < argc))
+		{
+			g_MaxFramesInFlight = (unsigned int)atoi(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--low-latency") == 0)
+		{
+			g_bLowLatency = true;
+		}
+		else if (strcmp(argv[i], "--on-demand") == 0)
+		{
+			g_bOnDemand = true;
+		}
+		else if ((strcmp(argv[i], "--idle-fps") == 0) && (i + 1 < argc))
+		{
+			g_IdleFrameRate = atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--frame-budget") == 0) && (i + 1 < argc))
+		{
+			g_FrameBudgetMilliseconds = atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--min-render-scale") == 0) && (i + 1 < argc))
+		{
+			g_MinRenderScale = (float)atof(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--texture-budget") == 0) && (i + 1 < argc))
+		{
+			g_TextureBudgetMegabytes = atof(argv[++i]);
+		}
+		else if (strcmp(argv[i], "--fixed-resolution") == 0)
+		{
+			g_bFixedResolution = true;
+		}
+		else if (strcmp(argv[i], "--hot-reload") == 0)
+		{
+			g_bHotReload = true;
+		}
+		else if (strcmp(argv[i], "--quad-view") == 0)
+		{
+			g_bQuadViews = true;
+		}
+	}
+
+	// an on-demand frame must show the input that woke the loop, so
+	// it is built right away instead of one frame ahead
+	if (g_bOnDemand)
+	{
+		g_bLowLatency = true;
+		if (g_bHotReload && (g_IdleFrameRate <= 0.0))
+		{
+			g_IdleFrameRate = HOT_RELOAD_IDLE_FPS;
+		}
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
@@ -57,6 +189,7 @@ int main(int argc, char* argv[])
 
 	// try to create the main display window
 	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	g_ViewManager->SetQuadViews(g_bQuadViews);
 
 	// if GLEW fails initialization, then terminate the application
 	if (InitializeGLEW() == false)
@@ -66,18 +199,137 @@ int main(int argc, char* argv[])
 
 	// load the shader code from the external GLSL files
 	g_ShaderManager->LoadShaders(
-		"../../Utilities/shaders/vertexShader.glsl",
-		"../../Utilities/shaders/fragmentShader.glsl");
+		VERTEX_SHADER_PATH,
+		FRAGMENT_SHADER_PATH);
 	g_ShaderManager->use();
 
+	// the shader manager does not report its program, so it is
+	// tracked here by the size of its binary
+	GLint currentProgram = 0;
+	GLint programBytes = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+	g_ShaderProgramID = (GLuint)currentProgram;
+	if (g_ShaderProgramID != 0)
+	{
+		glGetProgramiv(g_ShaderProgramID, GL_PROGRAM_BINARY_LENGTH, &programBytes);
+		ResourceTracker::Allocate(ResourceCategory::Program, g_ShaderProgramID, (size_t)programBytes, "Shader manager");
+	}
+
+	// create the job system with one worker per additional core
+	unsigned int coreCount = std::thread::hardware_concurrency();
+	g_JobSystem = new JobSystem((coreCount > 1) ? (coreCount - 1) : 0);
+
 	//try to create a new scene manager object and prepare the 3D scene
 	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager->SetJobSystem(g_JobSystem);
+	if (g_TextureBudgetMegabytes > 0.0)
+	{
+		g_SceneManager->SetTextureBudget((size_t)(g_TextureBudgetMegabytes * 1024.0 * 1024.0));
+	}
 	g_SceneManager->PrepareScene();
 
+	// watch the shader and texture files so an edit is reloaded in
+	// place while the scene keeps running
+	if (g_bHotReload)
+	{
+		std::vector<std::string> textureFiles;
+		g_SceneManager->GetTextureFilenames(textureFiles);
+
+		g_FileWatcher = new FileWatcher();
+		g_FileWatcher->Watch(VERTEX_SHADER_PATH);
+		g_FileWatcher->Watch(FRAGMENT_SHADER_PATH);
+		for (const std::string& filename : textureFiles)
+		{
+			g_FileWatcher->Watch(filename.c_str());
+		}
+		std::cout << "INFO: Hot reload watching " << g_FileWatcher->GetFileCount() << " files" << std::endl;
+	}
+
+	// stream the per-instance data through a persistently mapped buffer
+	// when the loaded shader declares the instance block
+	if (g_SceneManager->IsInstanceBlockSupported())
+	{
+		g_InstanceBuffer = new InstanceRingBuffer();
+		if (g_InstanceBuffer->Create(INSTANCE_BUFFER_REGIONS, INSTANCE_BUFFER_CAPACITY) == false)
+		{
+			delete g_InstanceBuffer;
+			g_InstanceBuffer = NULL;
+		}
+	}
+
+	// start the scene update thread
+	g_FrameManager = new FrameManager(g_SceneManager);
+	g_FrameManager->SetInstanceBuffer(g_InstanceBuffer);
+	g_FrameManager->Start();
+
+	g_FramePacer = new FramePacer(g_MaxFramesInFlight);
+
+	// the scene is drawn offscreen and upscaled to the framebuffer
+	g_ResolutionScaler = new ResolutionScaler();
+	g_ResolutionScaler->Create();
+	g_ResolutionScaler->SetBudget(g_FrameBudgetMilliseconds, g_MinRenderScale, 1.0f);
+	g_ResolutionScaler->SetEnabled(!g_bFixedResolution);
+
+	// unless in low latency mode, the next frame is built while the
+	// current one is submitted, so have the first frame built now
+	VIEW_SET viewSet;
+	if (!g_bLowLatency)
+	{
+		g_ViewManager->UpdateViewSet(viewSet);
+		g_FrameManager->SubmitViews(viewSet);
+	}
+
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
+		// in on-demand mode, block until something needs a new frame
+		if (g_bOnDemand && (WaitForRedraw() == false))
+		{
+			break;
+		}
+
+		// keep the CPU from queuing more frames than allowed
+		g_FramePacer->WaitForFrameSlot();
+
+		const FrameManager::RENDER_FRAME* pFrame = NULL;
+		if (g_bLowLatency)
+		{
+			// sample the input as late as possible, once the GPU has
+			// room for the frame, and build the frame right away
+			glfwPollEvents();
+			ProcessFileChanges();
+			UpdateSceneAnimations();
+			g_ViewManager->UpdateViewSet(viewSet);
+			g_FrameManager->SubmitViews(viewSet);
+			pFrame = &g_FrameManager->WaitForFrame();
+		}
+		else
+		{
+			// take the frame finished by the scene update thread
+			pFrame = &g_FrameManager->WaitForFrame();
+
+			// the update thread is idle until the next view is submitted,
+			// so the scene can be changed here
+			ProcessFileChanges();
+			UpdateSceneAnimations();
+
+			// process the latest input and start building the next frame
+			// while this one is being submitted to OpenGL
+			g_ViewManager->UpdateViewSet(viewSet);
+			g_FrameManager->SubmitViews(viewSet);
+		}
+		const FrameManager::RENDER_FRAME& frame = *pFrame;
+
+		// find the object under a click with the latest views
+		ProcessPickRequest(viewSet);
+
+		// draw into the offscreen target at the current render scale
+		int framebufferWidth = 0;
+		int framebufferHeight = 0;
+		ViewManager::GetFramebufferSize(framebufferWidth, framebufferHeight);
+		g_ResolutionScaler->BeginScene(framebufferWidth, framebufferHeight);
+
 		// Enable z-depth
 		glEnable(GL_DEPTH_TEST);
 
@@ -85,18 +337,78 @@ int main(int argc, char* argv[])
 		glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
+		// bring in the texture levels the last frames asked for
+		g_SceneManager->UpdateTextureStreaming();
+
+		// refresh the 3D scene in each view, all reading the same
+		// instance data
+		if (NULL != g_InstanceBuffer)
+		{
+			g_InstanceBuffer->BindRegion(frame.instanceRegion, 0);
+		}
+		int sceneWidth = 0;
+		int sceneHeight = 0;
+		g_ResolutionScaler->GetSceneSize(sceneWidth, sceneHeight);
+		for (int view = 0; view < frame.viewSet.viewCount; view++)
+		{
+			const glm::vec4& viewport = frame.viewSet.viewports[view];
+			if (frame.viewSet.viewCount > 1)
+			{
+				glViewport(
+					(GLint)(viewport.x * sceneWidth),
+					(GLint)(viewport.y * sceneHeight),
+					(GLsizei)(viewport.z * sceneWidth),
+					(GLsizei)(viewport.w * sceneHeight));
+			}
 
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
+			// convert from 3D object space to 2D view
+			g_ViewManager->ApplyViewState(frame.viewSet.views[view]);
+			g_SceneManager->RenderScene(frame.drawLists[view]);
+		}
+		g_FrameManager->ReleaseFrame(frame);
 
+		// upscale the scene to the display framebuffer
+		g_ResolutionScaler->EndScene();
 
 		// Flips the the back buffer with the front buffer every frame.
 		glfwSwapBuffers(g_Window);
+		g_FramePacer->FramePresented(frame.viewSet.views[0].inputTime);
+		g_FramePacer->ReportLatency(LATENCY_REPORT_INTERVAL);
+		ResourceTracker::ReportPeriodically(RESOURCE_REPORT_INTERVAL);
 
 		// query the latest GLFW events
-		glfwPollEvents();
+		if (!g_bLowLatency)
+		{
+			glfwPollEvents();
+		}
+	}
+
+	// stop the scene update thread before the scene it reads is freed
+	if (NULL != g_FrameManager)
+	{
+		g_FrameManager->Stop();
+		delete g_FrameManager;
+		g_FrameManager = NULL;
+	}
+	if (NULL != g_FileWatcher)
+	{
+		delete g_FileWatcher;
+		g_FileWatcher = NULL;
+	}
+	if (NULL != g_FramePacer)
+	{
+		delete g_FramePacer;
+		g_FramePacer = NULL;
+	}
+	if (NULL != g_ResolutionScaler)
+	{
+		delete g_ResolutionScaler;
+		g_ResolutionScaler = NULL;
+	}
+	if (NULL != g_InstanceBuffer)
+	{
+		delete g_InstanceBuffer;
+		g_InstanceBuffer = NULL;
 	}
 
 	// clear the allocated manager objects from memory
@@ -105,6 +417,11 @@ int main(int argc, char* argv[])
 		delete g_SceneManager;
 		g_SceneManager = NULL;
 	}
+	if (NULL != g_JobSystem)
+	{
+		delete g_JobSystem;
+		g_JobSystem = NULL;
+	}
 	if (NULL != g_ViewManager)
 	{
 		delete g_ViewManager;
@@ -114,8 +431,17 @@ int main(int argc, char* argv[])
 	{
 		delete g_ShaderManager;
 		g_ShaderManager = NULL;
+		if (g_ShaderProgramID != 0)
+		{
+			ResourceTracker::Release(ResourceCategory::Program, g_ShaderProgramID);
+			g_ShaderProgramID = 0;
+		}
 	}
 
+	// report the resources an owner failed to release
+	ResourceTracker::Dump();
+	ResourceTracker::ReportLeaks();
+
 	// Terminates the program successfully
 	exit(EXIT_SUCCESS); 
 }
@@ -172,4 +498,318 @@ bool InitializeGLEW()
 	std::cout << "INFO: OpenGL Version: " << glGetString(GL_VERSION) << "\n" << std::endl;
 
 	return(true);
-}
\ No newline at end of file
+}
+
+/***********************************************************
+ *	WaitForRedraw()
+ *
+ *  This function is used in on-demand mode to block in
+ *  glfwWaitEvents() until input, a resize, a finished asset
+ *  or an animation requests a frame, or until the idle frame
+ *  rate is due.  Frames keep coming while textures stream
+ *  in, so each finer level is drawn and the next one asked
+ *  for.  It returns false when the window is closing.
+ ***********************************************************/
+bool WaitForRedraw()
+{
+	if (ViewManager::ConsumeRedrawRequest() || g_SceneManager->IsStreamingTextures())
+	{
+		g_LastRedrawTime = glfwGetTime();
+		return(true);
+	}
+
+	// let the GPU finish the presented frames before going idle
+	g_FramePacer->WaitForAllFrames();
+
+	double waitStart = glfwGetTime();
+	while (ViewManager::ConsumeRedrawRequest() == false)
+	{
+		if (glfwWindowShouldClose(g_Window))
+		{
+			return(false);
+		}
+
+		if (g_IdleFrameRate > 0.0)
+		{
+			double remaining = (g_LastRedrawTime + (1.0 / g_IdleFrameRate)) - glfwGetTime();
+			if (remaining <= 0.0)
+			{
+				break;
+			}
+			glfwWaitEventsTimeout(remaining);
+		}
+		else
+		{
+			glfwWaitEvents();
+		}
+	}
+
+	g_LastRedrawTime = glfwGetTime();
+	g_FramePacer->RecordIdleTime(g_LastRedrawTime - waitStart);
+	g_ResolutionScaler->RecordIdleTime(g_LastRedrawTime - waitStart);
+
+	return(true);
+}
+
+/***********************************************************
+ *	ProcessPickRequest()
+ *
+ *  This function is used to find the scene object under the
+ *  last left click, if there was one, and print it with the
+ *  time the pick took.  The click is picked in the view it
+ *  landed in, with its coordinates moved into that view.
+ ***********************************************************/
+void ProcessPickRequest(const VIEW_SET& viewSet)
+{
+	float ndcX = 0.0f;
+	float ndcY = 0.0f;
+	SceneManager::PICK_RESULT pick;
+	int pickView = 0;
+
+	if (ViewManager::ConsumePickRequest(ndcX, ndcY) == false)
+	{
+		return;
+	}
+
+	float windowX = (ndcX + 1.0f) * 0.5f;
+	float windowY = (ndcY + 1.0f) * 0.5f;
+	for (int view = 0; view < viewSet.viewCount; view++)
+	{
+		const glm::vec4& viewport = viewSet.viewports[view];
+		if ((windowX >= viewport.x) && (windowX <= viewport.x + viewport.z) &&
+			(windowY >= viewport.y) && (windowY <= viewport.y + viewport.w))
+		{
+			pickView = view;
+			ndcX = ((windowX - viewport.x) / viewport.z) * 2.0f - 1.0f;
+			ndcY = ((windowY - viewport.y) / viewport.w) * 2.0f - 1.0f;
+			break;
+		}
+	}
+
+	if (g_SceneManager->PickObject(viewSet.views[pickView], ndcX, ndcY, pick))
+	{
+		std::cout << "INFO: Picked object " << pick.objectIndex
+			<< " at distance " << pick.distance
+			<< " in " << pick.microseconds << " us" << std::endl;
+	}
+	else
+	{
+		std::cout << "INFO: Picked nothing in " << pick.microseconds << " us" << std::endl;
+	}
+}
+
+/***********************************************************
+ *	ProcessFileChanges()
+ *
+ *  This function is used to reload the watched files saved
+ *  since the last frame, each on its own - an edited texture
+ *  is decoded into its existing texture object and an edited
+ *  shader relinks the program.  It must be called while the
+ *  scene update thread is idle.
+ ***********************************************************/
+void ProcessFileChanges()
+{
+	std::vector<std::string> changedFiles;
+	bool bShaderChanged = false;
+
+	if (NULL == g_FileWatcher)
+	{
+		return;
+	}
+
+	g_FileWatcher->PollChanges(changedFiles);
+	for (const std::string& filename : changedFiles)
+	{
+		if ((filename == VERTEX_SHADER_PATH) || (filename == FRAGMENT_SHADER_PATH))
+		{
+			bShaderChanged = true;
+		}
+		else
+		{
+			g_SceneManager->ReloadTexture(filename.c_str());
+		}
+	}
+
+	// both shader files saved together are linked once
+	if (bShaderChanged)
+	{
+		ReloadShaders();
+	}
+
+	if (changedFiles.size() > 0)
+	{
+		ViewManager::RequestRedraw();
+	}
+}
+
+/***********************************************************
+ *	UpdateSceneAnimations()
+ *
+ *  This function is used to play the scene animations at
+ *  the current time, and to keep drawing in on-demand mode
+ *  while anything is animated.  It must be called while the
+ *  scene update thread is idle.
+ ***********************************************************/
+void UpdateSceneAnimations()
+{
+	if (g_SceneManager->UpdateAnimations(glfwGetTime()))
+	{
+		ViewManager::RequestRedraw();
+	}
+}
+
+/***********************************************************
+ *	ReloadShaders()
+ *
+ *  This function is used to compile and link the shader
+ *  files again and switch to the new program once it linked
+ *  and its uniforms are looked up.  A program that fails to
+ *  link, or that adds or drops the instance block the frames
+ *  are built around, is thrown away and the previous one is
+ *  kept.
+ ***********************************************************/
+bool ReloadShaders()
+{
+	auto start = std::chrono::steady_clock::now();
+	GLuint previousProgramID = g_ShaderProgramID;
+	GLint linked = GL_FALSE;
+
+	GLuint programID = g_ShaderManager->LoadShaders(
+		VERTEX_SHADER_PATH,
+		FRAGMENT_SHADER_PATH);
+	if (programID != 0)
+	{
+		glGetProgramiv(programID, GL_LINK_STATUS, &linked);
+	}
+	if (linked == GL_FALSE)
+	{
+		std::cerr << "ERROR: Reloaded shaders did not link, keeping the previous program" << std::endl;
+		if ((programID != 0) && (programID != previousProgramID))
+		{
+			glDeleteProgram(programID);
+		}
+		glUseProgram(previousProgramID);
+		return(false);
+	}
+
+	glUseProgram(programID);
+	if (g_SceneManager->ReloadShaderInputs() == false)
+	{
+		std::cerr << "ERROR: Reloaded shaders change the instance block, restart to use them" << std::endl;
+		glUseProgram(previousProgramID);
+		g_SceneManager->ReloadShaderInputs();
+		glDeleteProgram(programID);
+		return(false);
+	}
+	g_ViewManager->ReloadShaderInputs();
+
+	GLint programBytes = 0;
+	glGetProgramiv(programID, GL_PROGRAM_BINARY_LENGTH, &programBytes);
+	if (previousProgramID != 0)
+	{
+		glDeleteProgram(previousProgramID);
+		ResourceTracker::Release(ResourceCategory::Program, previousProgramID);
+	}
+	ResourceTracker::Allocate(ResourceCategory::Program, programID, (size_t)programBytes, "Shader manager");
+	g_ShaderProgramID = programID;
+
+	std::cout << "INFO: Reloaded shaders in "
+		<< std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count()
+		<< " ms" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *	RunBatchRender()
+ *
+ *  This function is used to render the scene from many
+ *  cameras into PNG files without showing a window.  After
+ *  --batch it reads:
+ *    --poses <file>                 views listed in a file
+ *    --orbit <views> [radius] [height]  a turntable of views
+ *    --size <width> <height>        image size, 512x512
+ *    --output <directory>           existing directory, "."
+ *    --encoders <count>             PNG encoder threads
+ ***********************************************************/
+bool RunBatchRender(int argc, char* argv[])
+{
+	// the turntable circles the middle of the showcase scene
+	const glm::vec3 ORBIT_TARGET = glm::vec3(0.8f, 0.5f, 1.0f);
+	const float FIELD_OF_VIEW = 60.0f;
+	std::vector<BatchRenderer::CAMERA_POSE> poses;
+	const char* outputDirectory = ".";
+	int width = 512;
+	int height = 512;
+	unsigned int coreCount = std::thread::hardware_concurrency();
+	unsigned int encoderCount = (coreCount > 1) ? (coreCount - 1) : 1;
+
+	for (int i = 2; i < argc; i++)
+	{
+		if ((strcmp(argv[i], "--poses") == 0) && (i + 1 < argc))
+		{
+			if (BatchRenderer::LoadPoses(argv[++i], poses) == false)
+			{
+				return(false);
+			}
+		}
+		else if ((strcmp(argv[i], "--orbit") == 0) && (i + 1 < argc))
+		{
+			int viewCount = atoi(argv[++i]);
+			float radius = ((i + 1 < argc) && (argv[i + 1][0] != '-')) ? (float)atof(argv[++i]) : 6.0f;
+			float orbitHeight = ((i + 1 < argc) && (argv[i + 1][0] != '-')) ? (float)atof(argv[++i]) : 3.0f;
+			BatchRenderer::BuildOrbit(viewCount, radius, orbitHeight, ORBIT_TARGET, poses);
+		}
+		else if ((strcmp(argv[i], "--size") == 0) && (i + 2 < argc))
+		{
+			width = atoi(argv[++i]);
+			height = atoi(argv[++i]);
+		}
+		else if ((strcmp(argv[i], "--output") == 0) && (i + 1 < argc))
+		{
+			outputDirectory = argv[++i];
+		}
+		else if ((strcmp(argv[i], "--encoders") == 0) && (i + 1 < argc))
+		{
+			encoderCount = (unsigned int)atoi(argv[++i]);
+		}
+	}
+	if ((poses.size() == 0) || (width <= 0) || (height <= 0))
+	{
+		std::cerr << "ERROR: Batch mode needs --poses <file> or --orbit <views>, and a valid --size" << std::endl;
+		return(false);
+	}
+
+	if (InitializeGLFW() == false)
+	{
+		return(false);
+	}
+	glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
+	ShaderManager* pShaderManager = new ShaderManager();
+	ViewManager* pViewManager = new ViewManager(pShaderManager);
+	if ((pViewManager->CreateDisplayWindow(WINDOW_TITLE) == NULL) || (InitializeGLEW() == false))
+	{
+		delete pViewManager;
+		delete pShaderManager;
+		return(false);
+	}
+	pShaderManager->LoadShaders(
+		VERTEX_SHADER_PATH,
+		FRAGMENT_SHADER_PATH);
+	pShaderManager->use();
+
+	SceneManager* pSceneManager = new SceneManager(pShaderManager);
+	pSceneManager->PrepareScene();
+
+	BatchRenderer* pBatchRenderer = new BatchRenderer(pSceneManager, pViewManager);
+	bool bRendered = pBatchRenderer->Create(width, height, encoderCount) &&
+		pBatchRenderer->RenderViews(poses, outputDirectory, FIELD_OF_VIEW);
+
+	delete pBatchRenderer;
+	delete pSceneManager;
+	delete pViewManager;
+	delete pShaderManager;
+	glfwTerminate();
+
+	return(bRendered);
+}
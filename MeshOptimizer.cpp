@@ -0,0 +1,456 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.cpp
+// ============
+// reorder and deduplicate the generated mesh data so the GPU transforms
+// and fetches each vertex as few times as possible
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// LRU cache modeled while ordering the triangles, larger than the
+	// hardware cache so the order also suits bigger caches
+	const int g_ScoreCacheSize = 32;
+	// score of the vertices of the last triangle, slightly below the
+	// rest of the cache so the strip does not double back on itself
+	const float g_LastTriangleScore = 0.75f;
+	const float g_CacheDecayPower = 1.5f;
+	// bonus for vertices with few triangles left, so no lonely
+	// triangles are left behind to be picked up later
+	const float g_ValenceBoostScale = 2.0f;
+	const float g_ValenceBoostPower = 0.5f;
+	// allowed ACMR growth when ordering the clusters for overdraw
+	const float g_OverdrawThreshold = 1.05f;
+
+	/***********************************************************
+	 *  VertexScore()
+	 *
+	 *  This function is used for scoring a vertex from its
+	 *  position in the modeled cache and its remaining triangles.
+	 ***********************************************************/
+	float VertexScore(int cachePosition, unsigned int remainingTriangles)
+	{
+		if (remainingTriangles == 0)
+		{
+			return(-1.0f);
+		}
+
+		float score = 0.0f;
+		if (cachePosition >= 0)
+		{
+			if (cachePosition < 3)
+			{
+				score = g_LastTriangleScore;
+			}
+			else
+			{
+				float scale = 1.0f - (float)(cachePosition - 3) / (g_ScoreCacheSize - 3);
+				score = powf(scale, g_CacheDecayPower);
+			}
+		}
+
+		score += g_ValenceBoostScale * powf((float)remainingTriangles, -g_ValenceBoostPower);
+
+		return(score);
+	}
+}
+
+/***********************************************************
+ *  OptimizeMesh()
+ *
+ *  This method is used for running the whole optimization
+ *  stage on a mesh and reporting its effect.
+ ***********************************************************/
+MeshOptimizer::OPTIMIZE_REPORT MeshOptimizer::OptimizeMesh(ParametricMeshes::MESH_DATA& mesh)
+{
+	OPTIMIZE_REPORT report;
+
+	report.verticesBefore = mesh.vertices.size();
+	report.ACMRbefore = ComputeACMR(mesh.indices, mesh.vertices.size());
+
+	DeduplicateVertices(mesh);
+	OptimizeVertexCache(mesh.indices, mesh.vertices.size());
+	OptimizeOverdraw(mesh, mesh.indices, g_OverdrawThreshold);
+	OptimizeVertexFetch(mesh);
+
+	report.verticesAfter = mesh.vertices.size();
+	report.ACMRafter = ComputeACMR(mesh.indices, mesh.vertices.size());
+
+	return(report);
+}
+
+/***********************************************************
+ *  DeduplicateVertices()
+ *
+ *  This method is used for merging vertices with identical
+ *  position, normal and texture coordinate.  The vertices are
+ *  sorted by content so equal ones end up next to each other,
+ *  and each run is replaced by its first vertex.
+ ***********************************************************/
+void MeshOptimizer::DeduplicateVertices(ParametricMeshes::MESH_DATA& mesh)
+{
+	const std::vector<ParametricMeshes::MESH_VERTEX>& vertices = mesh.vertices;
+	std::vector<GLuint> order(vertices.size());
+
+	for (GLuint i = 0; i < (GLuint)order.size(); i++)
+	{
+		order[i] = i;
+	}
+	std::sort(order.begin(), order.end(), [&vertices](GLuint a, GLuint b)
+	{
+		int compare = memcmp(&vertices[a], &vertices[b], sizeof(ParametricMeshes::MESH_VERTEX));
+		return (compare < 0) || ((compare == 0) && (a < b));
+	});
+
+	// point each vertex at the first copy of its content
+	std::vector<GLuint> firstCopy(vertices.size());
+	for (size_t i = 0; i < order.size(); i++)
+	{
+		bool bSameAsPrevious = (i > 0) &&
+			(memcmp(&vertices[order[i]], &vertices[order[i - 1]], sizeof(ParametricMeshes::MESH_VERTEX)) == 0);
+		firstCopy[order[i]] = bSameAsPrevious ? firstCopy[order[i - 1]] : order[i];
+	}
+
+	// keep the first copies in their original order
+	std::vector<ParametricMeshes::MESH_VERTEX> uniqueVertices;
+	std::vector<GLuint> remap(vertices.size());
+	for (GLuint i = 0; i < (GLuint)vertices.size(); i++)
+	{
+		if (firstCopy[i] == i)
+		{
+			remap[i] = (GLuint)uniqueVertices.size();
+			uniqueVertices.push_back(vertices[i]);
+		}
+	}
+	for (GLuint& index : mesh.indices)
+	{
+		index = remap[firstCopy[index]];
+	}
+
+	mesh.vertices.swap(uniqueVertices);
+}
+
+/***********************************************************
+ *  OptimizeVertexCache()
+ *
+ *  This method is used for ordering the triangles with Tom
+ *  Forsyth's linear-speed vertex cache optimization.  Each
+ *  vertex is scored from its place in a modeled LRU cache
+ *  and its remaining triangles, and the next triangle drawn
+ *  is the best scored one using a cached vertex.
+ ***********************************************************/
+void MeshOptimizer::OptimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// triangles of each vertex, the first remainingTriangles of
+	// each range are the ones not drawn yet
+	std::vector<unsigned int> remainingTriangles(vertexCount, 0);
+	std::vector<size_t> adjacencyStart(vertexCount + 1, 0);
+	std::vector<GLuint> adjacency(indices.size());
+
+	for (GLuint index : indices)
+	{
+		remainingTriangles[index]++;
+	}
+	for (size_t vertex = 0; vertex < vertexCount; vertex++)
+	{
+		adjacencyStart[vertex + 1] = adjacencyStart[vertex] + remainingTriangles[vertex];
+	}
+	{
+		std::vector<size_t> fill(adjacencyStart.begin(), adjacencyStart.end() - 1);
+		for (size_t i = 0; i < indices.size(); i++)
+		{
+			adjacency[fill[indices[i]]++] = (GLuint)(i / 3);
+		}
+	}
+
+	std::vector<int> cachePosition(vertexCount, -1);
+	std::vector<float> vertexScore(vertexCount);
+	std::vector<float> triangleScore(triangleCount, 0.0f);
+	std::vector<bool> bTriangleDrawn(triangleCount, false);
+
+	for (size_t vertex = 0; vertex < vertexCount; vertex++)
+	{
+		vertexScore[vertex] = VertexScore(-1, remainingTriangles[vertex]);
+	}
+	for (size_t i = 0; i < indices.size(); i++)
+	{
+		triangleScore[i / 3] += vertexScore[indices[i]];
+	}
+
+	std::vector<GLuint> cache;
+	std::vector<GLuint> newCache;
+	std::vector<GLuint> output;
+	output.reserve(indices.size());
+
+	int bestTriangle = (int)(std::max_element(triangleScore.begin(), triangleScore.end()) - triangleScore.begin());
+	size_t nextUndrawn = 0;
+
+	while (output.size() < indices.size())
+	{
+		// nothing in the cache is connected to an undrawn triangle,
+		// so continue with the next one in the original order
+		if (bestTriangle < 0)
+		{
+			while (bTriangleDrawn[nextUndrawn])
+			{
+				nextUndrawn++;
+			}
+			bestTriangle = (int)nextUndrawn;
+		}
+
+		const GLuint* triangle = &indices[bestTriangle * 3];
+		output.insert(output.end(), triangle, triangle + 3);
+		bTriangleDrawn[bestTriangle] = true;
+
+		// take the triangle out of the undrawn ranges of its vertices
+		for (int corner = 0; corner < 3; corner++)
+		{
+			GLuint vertex = triangle[corner];
+			GLuint* pFirst = &adjacency[adjacencyStart[vertex]];
+			GLuint* pLast = pFirst + remainingTriangles[vertex] - 1;
+			GLuint* pFound = std::find(pFirst, pLast + 1, (GLuint)bestTriangle);
+			if (pFound <= pLast)
+			{
+				std::swap(*pFound, *pLast);
+				remainingTriangles[vertex]--;
+			}
+		}
+
+		// the triangle's vertices move to the front of the cache
+		newCache.assign(triangle, triangle + 3);
+		for (GLuint vertex : cache)
+		{
+			if ((vertex != triangle[0]) && (vertex != triangle[1]) && (vertex != triangle[2]))
+			{
+				newCache.push_back(vertex);
+			}
+		}
+		for (size_t i = g_ScoreCacheSize; i < newCache.size(); i++)
+		{
+			cachePosition[newCache[i]] = -1;
+			vertexScore[newCache[i]] = VertexScore(-1, remainingTriangles[newCache[i]]);
+		}
+		if (newCache.size() > (size_t)g_ScoreCacheSize)
+		{
+			newCache.resize(g_ScoreCacheSize);
+		}
+		cache.swap(newCache);
+
+		// rescore the cached vertices and their undrawn triangles
+		for (size_t i = 0; i < cache.size(); i++)
+		{
+			cachePosition[cache[i]] = (int)i;
+			vertexScore[cache[i]] = VertexScore((int)i, remainingTriangles[cache[i]]);
+		}
+
+		bestTriangle = -1;
+		float bestScore = -1.0f;
+		for (GLuint vertex : cache)
+		{
+			for (unsigned int i = 0; i < remainingTriangles[vertex]; i++)
+			{
+				GLuint candidate = adjacency[adjacencyStart[vertex] + i];
+				const GLuint* candidateIndices = &indices[candidate * 3];
+
+				triangleScore[candidate] =
+					vertexScore[candidateIndices[0]] +
+					vertexScore[candidateIndices[1]] +
+					vertexScore[candidateIndices[2]];
+				if (triangleScore[candidate] > bestScore)
+				{
+					bestScore = triangleScore[candidate];
+					bestTriangle = (int)candidate;
+				}
+			}
+		}
+	}
+
+	indices.swap(output);
+}
+
+/***********************************************************
+ *  OptimizeOverdraw()
+ *
+ *  This method is used for reordering a cache optimized
+ *  triangle list to draw its outward facing parts first.  The
+ *  list is cut into clusters where a triangle misses the
+ *  cache on all three vertices, so the reordering barely
+ *  affects the cache, and the clusters are sorted by how far
+ *  out from the mesh center they face.
+ ***********************************************************/
+void MeshOptimizer::OptimizeOverdraw(const ParametricMeshes::MESH_DATA& mesh, std::vector<GLuint>& indices, float threshold)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+	{
+		return;
+	}
+
+	// cut the list where the FIFO cache starts over
+	std::vector<size_t> clusterStart;
+	{
+		std::vector<size_t> cacheTime(mesh.vertices.size(), 0);
+		size_t time = CACHE_SIZE + 1;
+
+		for (size_t triangle = 0; triangle < triangleCount; triangle++)
+		{
+			int misses = 0;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				GLuint vertex = indices[triangle * 3 + corner];
+				if (time - cacheTime[vertex] > CACHE_SIZE)
+				{
+					cacheTime[vertex] = time++;
+					misses++;
+				}
+			}
+			if ((misses == 3) || (triangle == 0))
+			{
+				clusterStart.push_back(triangle);
+			}
+		}
+	}
+	clusterStart.push_back(triangleCount);
+
+	if (clusterStart.size() <= 2)
+	{
+		return;
+	}
+
+	// area weighted center of the whole mesh and of each cluster
+	struct CLUSTER
+	{
+		size_t firstTriangle;
+		size_t triangleCount;
+		float sortKey;
+	};
+	std::vector<CLUSTER> clusters;
+	std::vector<glm::vec3> clusterCenters;
+	std::vector<glm::vec3> clusterNormals;
+	glm::vec3 meshCenter(0.0f);
+	float meshArea = 0.0f;
+
+	for (size_t cluster = 0; cluster + 1 < clusterStart.size(); cluster++)
+	{
+		glm::vec3 center(0.0f);
+		glm::vec3 normal(0.0f);
+		float area = 0.0f;
+
+		for (size_t triangle = clusterStart[cluster]; triangle < clusterStart[cluster + 1]; triangle++)
+		{
+			const glm::vec3& p0 = mesh.vertices[indices[triangle * 3 + 0]].position;
+			const glm::vec3& p1 = mesh.vertices[indices[triangle * 3 + 1]].position;
+			const glm::vec3& p2 = mesh.vertices[indices[triangle * 3 + 2]].position;
+			glm::vec3 areaNormal = glm::cross(p1 - p0, p2 - p0);
+			float triangleArea = glm::length(areaNormal);
+
+			center += (p0 + p1 + p2) * (triangleArea / 3.0f);
+			normal += areaNormal;
+			area += triangleArea;
+		}
+
+		meshCenter += center;
+		meshArea += area;
+		clusterCenters.push_back((area > 0.0f) ? center / area : center);
+		clusterNormals.push_back((glm::length(normal) > 0.0f) ? glm::normalize(normal) : normal);
+		clusters.push_back({ clusterStart[cluster], clusterStart[cluster + 1] - clusterStart[cluster], 0.0f });
+	}
+	if (meshArea > 0.0f)
+	{
+		meshCenter /= meshArea;
+	}
+
+	for (size_t cluster = 0; cluster < clusters.size(); cluster++)
+	{
+		clusters[cluster].sortKey = glm::dot(clusterCenters[cluster] - meshCenter, clusterNormals[cluster]);
+	}
+	std::stable_sort(clusters.begin(), clusters.end(),
+		[](const CLUSTER& a, const CLUSTER& b) { return a.sortKey > b.sortKey; });
+
+	std::vector<GLuint> sorted;
+	sorted.reserve(indices.size());
+	for (const CLUSTER& cluster : clusters)
+	{
+		sorted.insert(sorted.end(),
+			indices.begin() + cluster.firstTriangle * 3,
+			indices.begin() + (cluster.firstTriangle + cluster.triangleCount) * 3);
+	}
+
+	// keep the cache order when the clusters cost too many misses
+	if (ComputeACMR(sorted, mesh.vertices.size()) <= ComputeACMR(indices, mesh.vertices.size()) * threshold)
+	{
+		indices.swap(sorted);
+	}
+}
+
+/***********************************************************
+ *  OptimizeVertexFetch()
+ *
+ *  This method is used for renumbering the vertices in the
+ *  order the triangles first use them, so the vertex fetch
+ *  walks forward through memory.  Unused vertices are
+ *  dropped.
+ ***********************************************************/
+void MeshOptimizer::OptimizeVertexFetch(ParametricMeshes::MESH_DATA& mesh)
+{
+	const GLuint UNUSED = (GLuint)-1;
+	std::vector<GLuint> remap(mesh.vertices.size(), UNUSED);
+	std::vector<ParametricMeshes::MESH_VERTEX> vertices;
+
+	vertices.reserve(mesh.vertices.size());
+	for (GLuint& index : mesh.indices)
+	{
+		if (remap[index] == UNUSED)
+		{
+			remap[index] = (GLuint)vertices.size();
+			vertices.push_back(mesh.vertices[index]);
+		}
+		index = remap[index];
+	}
+
+	mesh.vertices.swap(vertices);
+}
+
+/***********************************************************
+ *  ComputeACMR()
+ *
+ *  This method is used for counting the vertices a FIFO
+ *  post-transform cache would have to transform per triangle.
+ *  1.0 or less is good, 3.0 means no vertex is ever reused.
+ ***********************************************************/
+float MeshOptimizer::ComputeACMR(const std::vector<GLuint>& indices, size_t vertexCount, unsigned int cacheSize)
+{
+	size_t triangleCount = indices.size() / 3;
+	if (triangleCount == 0)
+	{
+		return(0.0f);
+	}
+
+	// a vertex is cached while fewer than cacheSize misses followed it
+	std::vector<size_t> cacheTime(vertexCount, 0);
+	size_t time = cacheSize + 1;
+	size_t misses = 0;
+
+	for (GLuint index : indices)
+	{
+		if (time - cacheTime[index] > cacheSize)
+		{
+			cacheTime[index] = time++;
+			misses++;
+		}
+	}
+
+	return((float)misses / triangleCount);
+}
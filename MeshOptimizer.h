@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshoptimizer.h
+// ============
+// reorder and deduplicate the generated mesh data so the GPU transforms
+// and fetches each vertex as few times as possible
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ParametricMeshes.h"
+
+#include <vector>
+
+/***********************************************************
+ *  MeshOptimizer
+ *
+ *  This class contains the mesh optimization stage run on
+ *  generated meshes before they are uploaded.  Identical
+ *  vertices are merged, the triangles are ordered for the
+ *  post-transform vertex cache and then, in clusters that
+ *  keep that order, front to back from the outside in to
+ *  cut overdraw, and the vertices are finally renumbered in
+ *  the order they are first used.
+ ***********************************************************/
+class MeshOptimizer
+{
+public:
+	// size of the FIFO cache simulated for the ACMR
+	static const unsigned int CACHE_SIZE = 16;
+
+	// vertex counts and average cache miss ratios around OptimizeMesh()
+	struct OPTIMIZE_REPORT
+	{
+		size_t verticesBefore;
+		size_t verticesAfter;
+		float ACMRbefore;
+		float ACMRafter;
+	};
+
+	// run every step below on a mesh
+	static OPTIMIZE_REPORT OptimizeMesh(ParametricMeshes::MESH_DATA& mesh);
+
+	// merge bitwise identical vertices
+	static void DeduplicateVertices(ParametricMeshes::MESH_DATA& mesh);
+	// order the triangles for the post-transform vertex cache
+	static void OptimizeVertexCache(std::vector<GLuint>& indices, size_t vertexCount);
+	// order clusters of cache optimized triangles to draw the outer
+	// ones first, unless the ACMR grows by more than threshold
+	static void OptimizeOverdraw(const ParametricMeshes::MESH_DATA& mesh, std::vector<GLuint>& indices, float threshold);
+	// renumber the vertices in the order the triangles use them
+	static void OptimizeVertexFetch(ParametricMeshes::MESH_DATA& mesh);
+
+	// average number of vertices transformed per triangle with a
+	// FIFO cache of cacheSize entries
+	static float ComputeACMR(const std::vector<GLuint>& indices, size_t vertexCount, unsigned int cacheSize = CACHE_SIZE);
+};
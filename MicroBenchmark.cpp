@@ -0,0 +1,177 @@
+///////////////////////////////////////////////////////////////////////////////
+// microbenchmark.cpp
+// ============
+// time small hot functions over many calls and save the results as JSON, so
+// the numbers of two builds can be compared
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MicroBenchmark.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// write a string as a JSON string literal
+	void WriteJsonString(std::ostream& stream, const char* text)
+	{
+		stream << '"';
+		for (const char* pCharacter = text; *pCharacter != '\0'; pCharacter++)
+		{
+			if ((*pCharacter == '"') || (*pCharacter == '\\'))
+			{
+				stream << '\\';
+			}
+			if ((unsigned char)*pCharacter >= 0x20)
+			{
+				stream << *pCharacter;
+			}
+		}
+		stream << '"';
+	}
+}
+
+/***********************************************************
+ *  MicroBenchmark()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MicroBenchmark::MicroBenchmark(int samples, double minSampleSeconds)
+{
+	m_samples = (samples > 0) ? samples : 1;
+	m_minSampleSeconds = minSampleSeconds;
+	m_intSink = 0;
+	m_floatSink = 0.0f;
+}
+
+/***********************************************************
+ *  Consume()
+ *
+ *  This method is used for storing a computed value where
+ *  the compiler has to assume it is read.
+ ***********************************************************/
+void MicroBenchmark::Consume(int value)
+{
+	m_intSink = value;
+}
+
+void MicroBenchmark::Consume(float value)
+{
+	m_floatSink = value;
+}
+
+/***********************************************************
+ *  AddResult()
+ *
+ *  This method is used for turning the sample times into
+ *  the fastest, median and mean time per call.
+ ***********************************************************/
+void MicroBenchmark::AddResult(const char* name, size_t callsPerSample, std::vector<double>& sampleSeconds)
+{
+	BENCHMARK_RESULT result;
+	double totalSeconds = 0.0;
+
+	std::sort(sampleSeconds.begin(), sampleSeconds.end());
+	for (double seconds : sampleSeconds)
+	{
+		totalSeconds += seconds;
+	}
+
+	result.name = name;
+	result.callsPerSample = callsPerSample;
+	result.samples = (int)sampleSeconds.size();
+	result.minNanoseconds = sampleSeconds.front() * 1e9 / callsPerSample;
+	result.medianNanoseconds = sampleSeconds[sampleSeconds.size() / 2] * 1e9 / callsPerSample;
+	result.meanNanoseconds = totalSeconds / sampleSeconds.size() * 1e9 / callsPerSample;
+	m_results.push_back(result);
+}
+
+/***********************************************************
+ *  GetResults()
+ *
+ *  This method is used for getting the timed functions.
+ ***********************************************************/
+const std::vector<MicroBenchmark::BENCHMARK_RESULT>& MicroBenchmark::GetResults() const
+{
+	return(m_results);
+}
+
+/***********************************************************
+ *  Print()
+ *
+ *  This method is used for printing the results.
+ ***********************************************************/
+void MicroBenchmark::Print() const
+{
+	for (const BENCHMARK_RESULT& result : m_results)
+	{
+		std::cout << "INFO:   " << result.name
+			<< ", median ns:" << result.medianNanoseconds
+			<< ", min ns:" << result.minNanoseconds
+			<< ", mean ns:" << result.meanNanoseconds
+			<< ", calls per sample:" << result.callsPerSample << std::endl;
+	}
+}
+
+/***********************************************************
+ *  WriteJson()
+ *
+ *  This method is used for saving the results together with
+ *  what is needed to tell two builds apart: the compiler,
+ *  whether the checks of debug builds are on, the build time
+ *  and the OpenGL renderer the functions called into.
+ ***********************************************************/
+bool MicroBenchmark::WriteJson(const char* filename, const char* renderer) const
+{
+	std::ofstream file(filename);
+
+	if (!file)
+	{
+		std::cerr << "ERROR: Could not write the benchmark results to " << filename << std::endl;
+		return(false);
+	}
+
+#if defined(_MSC_VER)
+	std::string compiler = "MSVC " + std::to_string(_MSC_VER);
+#elif defined(__clang__)
+	std::string compiler = "clang " __clang_version__;
+#elif defined(__GNUC__)
+	std::string compiler = "gcc " __VERSION__;
+#else
+	std::string compiler = "unknown";
+#endif
+#ifdef NDEBUG
+	const char* configuration = "release";
+#else
+	const char* configuration = "debug";
+#endif
+
+	file << "{\n";
+	file << "\t\"build\": {\n";
+	file << "\t\t\"compiler\": ";
+	WriteJsonString(file, compiler.c_str());
+	file << ",\n\t\t\"configuration\": \"" << configuration << "\",\n";
+	file << "\t\t\"built\": \"" << __DATE__ << " " << __TIME__ << "\",\n";
+	file << "\t\t\"renderer\": ";
+	WriteJsonString(file, (NULL != renderer) ? renderer : "none");
+	file << "\n\t},\n";
+	file << "\t\"results\": [";
+	for (size_t i = 0; i < m_results.size(); i++)
+	{
+		const BENCHMARK_RESULT& result = m_results[i];
+		file << ((i == 0) ? "\n" : ",\n") << "\t\t{ \"name\": ";
+		WriteJsonString(file, result.name.c_str());
+		file << ", \"median_ns\": " << result.medianNanoseconds
+			<< ", \"min_ns\": " << result.minNanoseconds
+			<< ", \"mean_ns\": " << result.meanNanoseconds
+			<< ", \"calls_per_sample\": " << result.callsPerSample
+			<< ", \"samples\": " << result.samples << " }";
+	}
+	file << "\n\t]\n}\n";
+
+	std::cout << "INFO: Benchmark results written to " << filename << std::endl;
+
+	return(file.good());
+}
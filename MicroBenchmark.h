@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+// microbenchmark.h
+// ============
+// time small hot functions over many calls and save the results as JSON, so
+// the numbers of two builds can be compared
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  MicroBenchmark
+ *
+ *  This class contains the timings of a suite of small
+ *  functions.  Each function is first called in growing
+ *  batches until one batch takes the minimum sample time,
+ *  then that batch size is timed for a number of samples,
+ *  and the fastest, median and mean time per call are kept.
+ *  The function gets the index of the call, so it can vary
+ *  its input from call to call, and passes what it computed
+ *  to Consume() so the compiler cannot drop the work.
+ ***********************************************************/
+class MicroBenchmark
+{
+public:
+	// timing of one function
+	struct BENCHMARK_RESULT
+	{
+		std::string name;
+		size_t callsPerSample;
+		int samples;
+		double minNanoseconds;
+		double medianNanoseconds;
+		double meanNanoseconds;
+	};
+
+	// constructor
+	MicroBenchmark(int samples, double minSampleSeconds);
+
+	// time a function called as function(callIndex)
+	template<typename FUNCTION>
+	void Run(const char* name, FUNCTION function);
+
+	// keep a computed value alive
+	void Consume(int value);
+	void Consume(float value);
+
+	const std::vector<BENCHMARK_RESULT>& GetResults() const;
+	// print the results
+	void Print() const;
+	// save the results with a description of the build and of the
+	// OpenGL renderer, returns false when the file cannot be written
+	bool WriteJson(const char* filename, const char* renderer) const;
+
+private:
+	std::vector<BENCHMARK_RESULT> m_results;
+	int m_samples;
+	double m_minSampleSeconds;
+	volatile int m_intSink;
+	volatile float m_floatSink;
+
+	// sort the sample times into a result
+	void AddResult(const char* name, size_t callsPerSample, std::vector<double>& sampleSeconds);
+};
+
+/***********************************************************
+ *  Run()
+ *
+ *  This method is used for finding how many calls make up a
+ *  sample, then timing the samples.
+ ***********************************************************/
+template<typename FUNCTION>
+void MicroBenchmark::Run(const char* name, FUNCTION function)
+{
+	std::vector<double> sampleSeconds;
+	size_t callsPerSample = 1;
+	size_t callIndex = 0;
+
+	// time one batch of calls
+	auto timeSample = [&](size_t calls)
+	{
+		auto start = std::chrono::steady_clock::now();
+		for (size_t i = 0; i < calls; i++)
+		{
+			function(callIndex++);
+		}
+		return(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	};
+
+	// the calibration batches also warm up the caches
+	while ((timeSample(callsPerSample) < m_minSampleSeconds) && (callsPerSample < ((size_t)1 << 30)))
+	{
+		callsPerSample *= 2;
+	}
+
+	for (int i = 0; i < m_samples; i++)
+	{
+		sampleSeconds.push_back(timeSample(callsPerSample));
+	}
+
+	AddResult(name, callsPerSample, sampleSeconds);
+}
@@ -0,0 +1,510 @@
+///////////////////////////////////////////////////////////////////////////////
+// parametricmeshes.cpp
+// ============
+// generate the parametric basic meshes at several tessellation levels so
+// distant objects can be drawn with fewer vertices
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ParametricMeshes.h"
+#include "MeshOptimizer.h"
+#include "ResourceTracker.h"
+
+#include <glm/gtc/constants.hpp>
+#include <glm/gtc/packing.hpp>
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// stacks and slices of the sphere levels, index 0 is ShapeMeshes
+	const int g_SphereStacks[ParametricMeshes::LOD_COUNT] = { 0, 12, 8, 4 };
+	const int g_SphereSlices[ParametricMeshes::LOD_COUNT] = { 0, 24, 12, 6 };
+	// slices of the cylinder levels, index 0 is ShapeMeshes
+	const int g_CylinderSlices[ParametricMeshes::LOD_COUNT] = { 0, 24, 12, 6 };
+}
+
+/***********************************************************
+ *  ParametricMeshes()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ParametricMeshes::ParametricMeshes()
+{
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		m_sphereLods[lod] = { 0, 0, 0, 0, 0, glm::mat4(1.0f) };
+		m_cylinderLods[lod] = { 0, 0, 0, 0, 0, glm::mat4(1.0f) };
+	}
+}
+
+/***********************************************************
+ *  ~ParametricMeshes()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ParametricMeshes::~ParametricMeshes()
+{
+	for (int lod = 0; lod < LOD_COUNT; lod++)
+	{
+		DeleteMesh(m_sphereLods[lod]);
+		DeleteMesh(m_cylinderLods[lod]);
+	}
+}
+
+/***********************************************************
+ *  AddGrid()
+ *
+ *  This method is used for appending a flat face split into
+ *  uCells by vCells quads, with the texture covering it once.
+ ***********************************************************/
+void ParametricMeshes::AddGrid(
+	const glm::vec3& corner,
+	const glm::vec3& uEdge,
+	const glm::vec3& vEdge,
+	int uCells,
+	int vCells,
+	MESH_DATA& mesh)
+{
+	glm::vec3 normal = glm::normalize(glm::cross(uEdge, vEdge));
+	GLuint first = (GLuint)mesh.vertices.size();
+
+	uCells = std::max(uCells, 1);
+	vCells = std::max(vCells, 1);
+	for (int v = 0; v <= vCells; v++)
+	{
+		for (int u = 0; u <= uCells; u++)
+		{
+			glm::vec2 textureCoordinate((float)u / uCells, (float)v / vCells);
+			mesh.vertices.push_back({
+				corner + uEdge * textureCoordinate.x + vEdge * textureCoordinate.y,
+				normal,
+				textureCoordinate });
+		}
+	}
+
+	for (int v = 0; v < vCells; v++)
+	{
+		for (int u = 0; u < uCells; u++)
+		{
+			GLuint lower = first + v * (uCells + 1) + u;
+			GLuint upper = lower + uCells + 1;
+			mesh.indices.insert(mesh.indices.end(), { lower, lower + 1, upper + 1, lower, upper + 1, upper });
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildBox()
+ *
+ *  This method is used for generating a cube with sides of
+ *  1 centered on the origin.  Each face has its own vertices
+ *  so its normal is flat and the texture covers it once, and
+ *  is split into the cells given along the axes it spans.
+ ***********************************************************/
+void ParametricMeshes::BuildBox(MESH_DATA& mesh, const glm::ivec3& cells)
+{
+	// corner, U edge and V edge of each face, counter-clockwise
+	// when seen from outside
+	const glm::vec3 faces[6][3] = {
+		{ glm::vec3(-0.5f, -0.5f,  0.5f), glm::vec3( 1.0f, 0.0f,  0.0f), glm::vec3(0.0f, 1.0f,  0.0f) },	// front
+		{ glm::vec3( 0.5f, -0.5f, -0.5f), glm::vec3(-1.0f, 0.0f,  0.0f), glm::vec3(0.0f, 1.0f,  0.0f) },	// back
+		{ glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3( 0.0f, 0.0f,  1.0f), glm::vec3(0.0f, 1.0f,  0.0f) },	// left
+		{ glm::vec3( 0.5f, -0.5f,  0.5f), glm::vec3( 0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f,  0.0f) },	// right
+		{ glm::vec3(-0.5f,  0.5f,  0.5f), glm::vec3( 1.0f, 0.0f,  0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },	// top
+		{ glm::vec3(-0.5f, -0.5f, -0.5f), glm::vec3( 1.0f, 0.0f,  0.0f), glm::vec3(0.0f, 0.0f,  1.0f) }	// bottom
+	};
+	// axes the U and V edges of each face run along
+	const int faceAxes[6][2] = { { 0, 1 }, { 0, 1 }, { 2, 1 }, { 2, 1 }, { 0, 2 }, { 0, 2 } };
+
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	for (int face = 0; face < 6; face++)
+	{
+		AddGrid(faces[face][0], faces[face][1], faces[face][2],
+			cells[faceAxes[face][0]], cells[faceAxes[face][1]], mesh);
+	}
+}
+
+/***********************************************************
+ *  BuildPlane()
+ *
+ *  This method is used for generating a plane from -1 to 1
+ *  on the X and Z axes, facing up, with the texture covering
+ *  it once, split into xCells by zCells quads.
+ ***********************************************************/
+void ParametricMeshes::BuildPlane(MESH_DATA& mesh, int xCells, int zCells)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	AddGrid(glm::vec3(-1.0f, 0.0f, 1.0f), glm::vec3(2.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -2.0f),
+		xCells, zCells, mesh);
+}
+
+/***********************************************************
+ *  BuildSphere()
+ *
+ *  This method is used for generating a sphere of radius 1
+ *  from rings of latitude, with the poles on the Y axis and
+ *  the texture wrapped once around it.
+ ***********************************************************/
+void ParametricMeshes::BuildSphere(int stacks, int slices, MESH_DATA& mesh)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	// the seam column is duplicated so the texture does not wrap back
+	for (int stack = 0; stack <= stacks; stack++)
+	{
+		float phi = glm::pi<float>() * stack / stacks;
+		for (int slice = 0; slice <= slices; slice++)
+		{
+			float theta = glm::two_pi<float>() * slice / slices;
+			MESH_VERTEX vertex;
+
+			vertex.position = glm::vec3(
+				sinf(phi) * cosf(theta),
+				cosf(phi),
+				-sinf(phi) * sinf(theta));
+			vertex.normal = vertex.position;
+			vertex.textureCoordinate = glm::vec2(
+				(float)slice / slices,
+				1.0f - (float)stack / stacks);
+			mesh.vertices.push_back(vertex);
+		}
+	}
+
+	for (int stack = 0; stack < stacks; stack++)
+	{
+		for (int slice = 0; slice < slices; slice++)
+		{
+			GLuint upper = stack * (slices + 1) + slice;
+			GLuint lower = upper + slices + 1;
+
+			// the pole rows collapse to points, so skip their empty triangles
+			if (stack != 0)
+			{
+				mesh.indices.insert(mesh.indices.end(), { upper, lower, upper + 1 });
+			}
+			if (stack != stacks - 1)
+			{
+				mesh.indices.insert(mesh.indices.end(), { upper + 1, lower, lower + 1 });
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  BuildCylinder()
+ *
+ *  This method is used for generating a cylinder of radius
+ *  1 standing on the XZ plane with a height of 1, closed by
+ *  a cap at each end.
+ ***********************************************************/
+void ParametricMeshes::BuildCylinder(int slices, MESH_DATA& mesh)
+{
+	mesh.vertices.clear();
+	mesh.indices.clear();
+
+	// side, with a bottom and a top vertex per slice
+	for (int slice = 0; slice <= slices; slice++)
+	{
+		float theta = glm::two_pi<float>() * slice / slices;
+		glm::vec3 normal(cosf(theta), 0.0f, -sinf(theta));
+		float u = (float)slice / slices;
+
+		mesh.vertices.push_back({ normal, normal, glm::vec2(u, 0.0f) });
+		mesh.vertices.push_back({ normal + glm::vec3(0.0f, 1.0f, 0.0f), normal, glm::vec2(u, 1.0f) });
+	}
+	for (int slice = 0; slice < slices; slice++)
+	{
+		GLuint bottom = slice * 2;
+		mesh.indices.insert(mesh.indices.end(), { bottom, bottom + 2, bottom + 1 });
+		mesh.indices.insert(mesh.indices.end(), { bottom + 1, bottom + 2, bottom + 3 });
+	}
+
+	// caps, as fans around their center with planar texture mapping
+	for (int cap = 0; cap < 2; cap++)
+	{
+		float y = (float)cap;
+		glm::vec3 normal(0.0f, (cap == 0) ? -1.0f : 1.0f, 0.0f);
+		GLuint center = (GLuint)mesh.vertices.size();
+
+		mesh.vertices.push_back({ glm::vec3(0.0f, y, 0.0f), normal, glm::vec2(0.5f, 0.5f) });
+		for (int slice = 0; slice < slices; slice++)
+		{
+			float theta = glm::two_pi<float>() * slice / slices;
+			glm::vec3 position(cosf(theta), y, -sinf(theta));
+
+			mesh.vertices.push_back({ position, normal,
+				glm::vec2(position.x * 0.5f + 0.5f, -position.z * 0.5f + 0.5f) });
+		}
+		for (int slice = 0; slice < slices; slice++)
+		{
+			GLuint current = center + 1 + slice;
+			GLuint next = center + 1 + ((slice + 1) % slices);
+
+			// both caps face outward
+			if (cap == 0)
+			{
+				mesh.indices.insert(mesh.indices.end(), { center, next, current });
+			}
+			else
+			{
+				mesh.indices.insert(mesh.indices.end(), { center, current, next });
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  UploadMesh()
+ *
+ *  This method is used for creating the vertex array and
+ *  buffers of a generated mesh in the given vertex format.
+ ***********************************************************/
+void ParametricMeshes::UploadMesh(const MESH_DATA& mesh, VertexFormat format, const char* ownerTag, GL_MESH& glMesh)
+{
+	size_t vertexBytes = 0;
+	size_t indexBytes = mesh.indices.size() * sizeof(GLuint);
+
+	glGenVertexArrays(1, &glMesh.vao);
+	glGenBuffers(1, &glMesh.vbo);
+	glGenBuffers(1, &glMesh.ebo);
+	glMesh.bakedLightVbo = 0;
+	glMesh.indexCount = (GLsizei)mesh.indices.size();
+	glMesh.dequantize = glm::mat4(1.0f);
+
+	glBindVertexArray(glMesh.vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, glMesh.vbo);
+	if (format == VertexFormat::Quantized)
+	{
+		// the positions are stored relative to the mesh bounds
+		glm::vec3 minXYZ = mesh.vertices[0].position;
+		glm::vec3 maxXYZ = mesh.vertices[0].position;
+		for (const MESH_VERTEX& vertex : mesh.vertices)
+		{
+			minXYZ = glm::min(minXYZ, vertex.position);
+			maxXYZ = glm::max(maxXYZ, vertex.position);
+		}
+		glm::vec3 center = (minXYZ + maxXYZ) * 0.5f;
+		glm::vec3 halfExtent = (maxXYZ - minXYZ) * 0.5f;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			if (halfExtent[axis] <= 0.0f)
+				halfExtent[axis] = 1.0f;
+		}
+		glMesh.dequantize = glm::translate(center) * glm::scale(halfExtent);
+
+		std::vector<PACKED_VERTEX> packed(mesh.vertices.size());
+		for (size_t i = 0; i < mesh.vertices.size(); i++)
+		{
+			const MESH_VERTEX& vertex = mesh.vertices[i];
+			glm::vec3 position = (vertex.position - center) / halfExtent;
+
+			// the shader derives the normal matrix from the model matrix,
+			// which now includes the bounds scale, so the normal is
+			// scaled the same way up front to cancel it out
+			glm::vec3 normal = glm::normalize(vertex.normal * halfExtent);
+
+			packed[i].position[0] = (int16_t)glm::packSnorm1x16(position.x);
+			packed[i].position[1] = (int16_t)glm::packSnorm1x16(position.y);
+			packed[i].position[2] = (int16_t)glm::packSnorm1x16(position.z);
+			packed[i].position[3] = 0;
+			packed[i].normal = glm::packSnorm3x10_1x2(glm::vec4(normal, 0.0f));
+			packed[i].textureCoordinate = glm::packHalf2x16(vertex.textureCoordinate);
+		}
+		vertexBytes = packed.size() * sizeof(PACKED_VERTEX);
+		glBufferData(GL_ARRAY_BUFFER, vertexBytes, packed.data(), GL_STATIC_DRAW);
+
+		glVertexAttribPointer(0, 3, GL_SHORT, GL_TRUE, sizeof(PACKED_VERTEX), (void*)offsetof(PACKED_VERTEX, position));
+		glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PACKED_VERTEX), (void*)offsetof(PACKED_VERTEX, normal));
+		glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PACKED_VERTEX), (void*)offsetof(PACKED_VERTEX, textureCoordinate));
+	}
+	else
+	{
+		vertexBytes = mesh.vertices.size() * sizeof(MESH_VERTEX);
+		glBufferData(GL_ARRAY_BUFFER, vertexBytes, mesh.vertices.data(), GL_STATIC_DRAW);
+
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(MESH_VERTEX), (void*)offsetof(MESH_VERTEX, position));
+		glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(MESH_VERTEX), (void*)offsetof(MESH_VERTEX, normal));
+		glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(MESH_VERTEX), (void*)offsetof(MESH_VERTEX, textureCoordinate));
+	}
+	glEnableVertexAttribArray(0);
+	glEnableVertexAttribArray(1);
+	glEnableVertexAttribArray(2);
+
+	if (mesh.bakedLight.size() == mesh.vertices.size())
+	{
+		glGenBuffers(1, &glMesh.bakedLightVbo);
+		glBindBuffer(GL_ARRAY_BUFFER, glMesh.bakedLightVbo);
+		glBufferData(GL_ARRAY_BUFFER, mesh.bakedLight.size() * sizeof(uint32_t), mesh.bakedLight.data(), GL_STATIC_DRAW);
+		glVertexAttribPointer(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(uint32_t), (void*)0);
+		glEnableVertexAttribArray(3);
+		ResourceTracker::Allocate(ResourceCategory::Buffer, glMesh.bakedLightVbo, mesh.bakedLight.size() * sizeof(uint32_t), ownerTag);
+	}
+
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, glMesh.ebo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indexBytes, mesh.indices.data(), GL_STATIC_DRAW);
+
+	glBindVertexArray(0);
+
+	ResourceTracker::Allocate(ResourceCategory::VertexArray, glMesh.vao, 0, ownerTag);
+	ResourceTracker::Allocate(ResourceCategory::Buffer, glMesh.vbo, vertexBytes, ownerTag);
+	ResourceTracker::Allocate(ResourceCategory::Buffer, glMesh.ebo, indexBytes, ownerTag);
+}
+
+/***********************************************************
+ *  OptimizeAndUploadMesh()
+ *
+ *  This method is used for running the mesh optimization
+ *  stage on a generated mesh, reporting how much it saved,
+ *  and uploading the result.
+ ***********************************************************/
+void ParametricMeshes::OptimizeAndUploadMesh(const char* name, int lod, MESH_DATA& mesh, VertexFormat format, GL_MESH& glMesh)
+{
+	MeshOptimizer::OPTIMIZE_REPORT report = MeshOptimizer::OptimizeMesh(mesh);
+
+	std::cout << "INFO: " << name << " LOD " << lod
+		<< ": vertices " << report.verticesBefore << " -> " << report.verticesAfter
+		<< ", ACMR " << report.ACMRbefore << " -> " << report.ACMRafter
+		<< ", vertex bytes " << ((format == VertexFormat::Quantized) ? sizeof(PACKED_VERTEX) : sizeof(MESH_VERTEX))
+		<< std::endl;
+
+	UploadMesh(mesh, format, name, glMesh);
+}
+
+/***********************************************************
+ *  DeleteMesh()
+ *
+ *  This method is used for freeing the vertex array and
+ *  buffers of an uploaded mesh.
+ ***********************************************************/
+void ParametricMeshes::DeleteMesh(GL_MESH& glMesh)
+{
+	if (glMesh.vao != 0)
+	{
+		glDeleteVertexArrays(1, &glMesh.vao);
+		glDeleteBuffers(1, &glMesh.vbo);
+		glDeleteBuffers(1, &glMesh.ebo);
+		ResourceTracker::Release(ResourceCategory::VertexArray, glMesh.vao);
+		ResourceTracker::Release(ResourceCategory::Buffer, glMesh.vbo);
+		ResourceTracker::Release(ResourceCategory::Buffer, glMesh.ebo);
+	}
+	if (glMesh.bakedLightVbo != 0)
+	{
+		glDeleteBuffers(1, &glMesh.bakedLightVbo);
+		ResourceTracker::Release(ResourceCategory::Buffer, glMesh.bakedLightVbo);
+	}
+
+	glMesh.vao = 0;
+	glMesh.vbo = 0;
+	glMesh.ebo = 0;
+	glMesh.bakedLightVbo = 0;
+	glMesh.indexCount = 0;
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing an uploaded mesh.
+ ***********************************************************/
+void ParametricMeshes::DrawMesh(const GL_MESH& glMesh)
+{
+	DrawMeshRange(glMesh, 0, glMesh.indexCount);
+}
+
+/***********************************************************
+ *  DrawMeshRange()
+ *
+ *  This method is used for drawing a run of the triangles
+ *  of an uploaded mesh.
+ ***********************************************************/
+void ParametricMeshes::DrawMeshRange(const GL_MESH& glMesh, GLsizei firstIndex, GLsizei indexCount)
+{
+	glBindVertexArray(glMesh.vao);
+	glDrawElements(GL_TRIANGLES, indexCount, GL_UNSIGNED_INT, (void*)(firstIndex * sizeof(GLuint)));
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  LoadSphereLods()
+ *
+ *  This method is used for generating and uploading the
+ *  coarser levels of the sphere mesh.
+ ***********************************************************/
+void ParametricMeshes::LoadSphereLods(VertexFormat format)
+{
+	MESH_DATA mesh;
+
+	for (int lod = 1; lod < LOD_COUNT; lod++)
+	{
+		BuildSphere(g_SphereStacks[lod], g_SphereSlices[lod], mesh);
+		OptimizeAndUploadMesh("Sphere", lod, mesh, format, m_sphereLods[lod]);
+	}
+}
+
+/***********************************************************
+ *  LoadCylinderLods()
+ *
+ *  This method is used for generating and uploading the
+ *  coarser levels of the cylinder mesh.
+ ***********************************************************/
+void ParametricMeshes::LoadCylinderLods(VertexFormat format)
+{
+	MESH_DATA mesh;
+
+	for (int lod = 1; lod < LOD_COUNT; lod++)
+	{
+		BuildCylinder(g_CylinderSlices[lod], mesh);
+		OptimizeAndUploadMesh("Cylinder", lod, mesh, format, m_cylinderLods[lod]);
+	}
+}
+
+/***********************************************************
+ *  DrawSphereMesh()
+ *
+ *  This method is used for drawing a coarser sphere level.
+ ***********************************************************/
+void ParametricMeshes::DrawSphereMesh(int lod)
+{
+	DrawMesh(m_sphereLods[lod]);
+}
+
+/***********************************************************
+ *  DrawCylinderMesh()
+ *
+ *  This method is used for drawing a coarser cylinder level.
+ ***********************************************************/
+void ParametricMeshes::DrawCylinderMesh(int lod)
+{
+	DrawMesh(m_cylinderLods[lod]);
+}
+
+/***********************************************************
+ *  GetSphereDequantizeMatrix()
+ *
+ *  This method is used for getting the matrix that maps the
+ *  stored positions of a sphere level to object space.
+ ***********************************************************/
+const glm::mat4& ParametricMeshes::GetSphereDequantizeMatrix(int lod) const
+{
+	return(m_sphereLods[lod].dequantize);
+}
+
+/***********************************************************
+ *  GetCylinderDequantizeMatrix()
+ *
+ *  This method is used for getting the matrix that maps the
+ *  stored positions of a cylinder level to object space.
+ ***********************************************************/
+const glm::mat4& ParametricMeshes::GetCylinderDequantizeMatrix(int lod) const
+{
+	return(m_cylinderLods[lod].dequantize);
+}
@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////////
+// parametricmeshes.h
+// ============
+// generate the parametric basic meshes at several tessellation levels so
+// distant objects can be drawn with fewer vertices
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+#include <cstdint>
+
+enum class VertexFormat { //enum declaration for the vertex layout of an uploaded mesh
+	Float,		// 32 bytes - float position, normal and UV
+	Quantized	// 16 bytes - 16-bit normalized position, 10:10:10:2 normal, half UV
+};
+
+/***********************************************************
+ *  ParametricMeshes
+ *
+ *  This class contains the coarser levels of detail of the
+ *  sphere and cylinder meshes.  Level 0 is the full mesh
+ *  drawn by ShapeMeshes, levels 1 to LOD_COUNT - 1 are built
+ *  here with the same size, orientation and attribute
+ *  locations: position at 0, normal at 1 and UV at 2.  A
+ *  mesh with baked lighting also has its RGBA8 light color
+ *  per vertex at location 3, in a buffer of its own.
+ *
+ *  A quantized mesh stores its positions relative to its
+ *  bounds as normalized shorts, so the vertex fetch decodes
+ *  every attribute to the same floats the shader reads from
+ *  a float mesh.  Only the mapping from the bounds back to
+ *  object space is left, and it is folded into the model
+ *  matrix of each draw through GetDequantizeMatrix().
+ ***********************************************************/
+class ParametricMeshes
+{
+public:
+	// constructor
+	ParametricMeshes();
+	// destructor
+	~ParametricMeshes();
+
+	// number of levels of detail, including the ShapeMeshes level 0
+	static const int LOD_COUNT = 4;
+
+	// one interleaved vertex of a generated mesh
+	struct MESH_VERTEX
+	{
+		glm::vec3 position;
+		glm::vec3 normal;
+		glm::vec2 textureCoordinate;
+	};
+
+	// triangle list of a generated mesh
+	struct MESH_DATA
+	{
+		std::vector<MESH_VERTEX> vertices;
+		std::vector<GLuint> indices;
+		// RGBA8 baked light per vertex, or empty - filled in last,
+		// since the mesh optimizer does not reorder it
+		std::vector<uint32_t> bakedLight;
+	};
+
+	// one vertex of a quantized mesh
+	struct PACKED_VERTEX
+	{
+		// position in the mesh bounds, w is padding
+		int16_t position[4];
+		// GL_INT_2_10_10_10_REV normal
+		uint32_t normal;
+		// two half floats
+		uint32_t textureCoordinate;
+	};
+
+	// OpenGL objects of one uploaded mesh
+	struct GL_MESH
+	{
+		GLuint vao;
+		GLuint vbo;
+		GLuint ebo;
+		// baked light colors, 0 when the mesh has none
+		GLuint bakedLightVbo;
+		GLsizei indexCount;
+		// maps the stored positions to object space
+		glm::mat4 dequantize;
+	};
+
+	// generate a unit cube around the origin, one texture per face,
+	// with its faces split into the given cells along X, Y and Z
+	static void BuildBox(MESH_DATA& mesh, const glm::ivec3& cells = glm::ivec3(1));
+	// generate a 2x2 plane on the XZ plane facing up, split into
+	// xCells by zCells quads
+	static void BuildPlane(MESH_DATA& mesh, int xCells = 1, int zCells = 1);
+	// generate a unit sphere around the origin
+	static void BuildSphere(int stacks, int slices, MESH_DATA& mesh);
+	// generate a capped cylinder of radius 1 from y = 0 to y = 1
+	static void BuildCylinder(int slices, MESH_DATA& mesh);
+
+	// upload a generated mesh into new OpenGL buffers, which are
+	// tracked under ownerTag
+	static void UploadMesh(const MESH_DATA& mesh, VertexFormat format, const char* ownerTag, GL_MESH& glMesh);
+	// free the OpenGL buffers of an uploaded mesh
+	static void DeleteMesh(GL_MESH& glMesh);
+	// draw an uploaded mesh, or indexCount indices of it from firstIndex
+	static void DrawMesh(const GL_MESH& glMesh);
+	static void DrawMeshRange(const GL_MESH& glMesh, GLsizei firstIndex, GLsizei indexCount);
+
+private:
+	// levels 1 to LOD_COUNT - 1, index 0 is unused
+	GL_MESH m_sphereLods[LOD_COUNT];
+	GL_MESH m_cylinderLods[LOD_COUNT];
+
+	// append a flat face split into uCells by vCells quads
+	static void AddGrid(
+		const glm::vec3& corner,
+		const glm::vec3& uEdge,
+		const glm::vec3& vEdge,
+		int uCells,
+		int vCells,
+		MESH_DATA& mesh);
+	// run the mesh optimization stage, report it and upload the mesh
+	static void OptimizeAndUploadMesh(const char* name, int lod, MESH_DATA& mesh, VertexFormat format, GL_MESH& glMesh);
+
+public:
+	// generate and upload the coarser sphere levels
+	void LoadSphereLods(VertexFormat format = VertexFormat::Float);
+	// generate and upload the coarser cylinder levels
+	void LoadCylinderLods(VertexFormat format = VertexFormat::Float);
+
+	// matrix to append to the model matrix of a draw of a level,
+	// the identity for float meshes
+	const glm::mat4& GetSphereDequantizeMatrix(int lod) const;
+	const glm::mat4& GetCylinderDequantizeMatrix(int lod) const;
+
+	// draw a coarser level, lod must be 1 to LOD_COUNT - 1
+	void DrawSphereMesh(int lod);
+	void DrawCylinderMesh(int lod);
+};
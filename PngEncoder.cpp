@@ -0,0 +1,481 @@
+///////////////////////////////////////////////////////////////////////////////
+// pngencoder.cpp
+// ============
+// encode rendered images as PNG files without an external image library
+///////////////////////////////////////////////////////////////////////////////
+
+#include "PngEncoder.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	const uint8_t g_PngSignature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+
+	// LZ77 window and match limits of deflate
+	const int g_WindowSize = 32768;
+	const int g_MinMatch = 3;
+	const int g_MaxMatch = 258;
+	// earlier positions with the same hash tried for each match
+	const int g_MaxChain = 32;
+	const int g_HashBits = 15;
+
+	// first length of each deflate length code from 257, and its extra bits
+	const int g_LengthBase[29] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+		35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const int g_LengthExtraBits[29] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+		3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	// first distance of each deflate distance code, and its extra bits
+	const int g_DistanceBase[30] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+		257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const int g_DistanceExtraBits[30] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+		7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	// hash of the three bytes starting at pData
+	inline uint32_t HashBytes(const uint8_t* pData)
+	{
+		uint32_t value = ((uint32_t)pData[0] << 16) | ((uint32_t)pData[1] << 8) | pData[2];
+		return((value * 2654435761u) >> (32 - g_HashBits));
+	}
+
+	// predictor of the Paeth filter
+	inline int PaethPredictor(int left, int above, int aboveLeft)
+	{
+		int estimate = left + above - aboveLeft;
+		int leftDistance = abs(estimate - left);
+		int aboveDistance = abs(estimate - above);
+		int aboveLeftDistance = abs(estimate - aboveLeft);
+
+		if ((leftDistance <= aboveDistance) && (leftDistance <= aboveLeftDistance))
+		{
+			return(left);
+		}
+		return((aboveDistance <= aboveLeftDistance) ? above : aboveLeft);
+	}
+
+	// append a 32 bit value most significant byte first
+	void WriteBigEndian(std::vector<uint8_t>& bytes, uint32_t value)
+	{
+		bytes.push_back((uint8_t)(value >> 24));
+		bytes.push_back((uint8_t)(value >> 16));
+		bytes.push_back((uint8_t)(value >> 8));
+		bytes.push_back((uint8_t)value);
+	}
+}
+
+/***********************************************************
+ *  EncodePng()
+ *
+ *  This method is used for encoding an 8 bit RGB or RGBA
+ *  image into the bytes of a PNG file.
+ ***********************************************************/
+bool PngEncoder::EncodePng(
+	const uint8_t* pPixels,
+	int width,
+	int height,
+	int channels,
+	std::vector<uint8_t>& png)
+{
+	std::vector<uint8_t> header;
+	std::vector<uint8_t> filtered;
+	std::vector<uint8_t> compressed;
+
+	if ((NULL == pPixels) || (width <= 0) || (height <= 0) || ((channels != 3) && (channels != 4)))
+	{
+		return(false);
+	}
+
+	WriteBigEndian(header, (uint32_t)width);
+	WriteBigEndian(header, (uint32_t)height);
+	// 8 bits per channel, truecolor with or without alpha, then the
+	// default compression, filtering and no interlacing
+	header.push_back(8);
+	header.push_back((channels == 4) ? 6 : 2);
+	header.push_back(0);
+	header.push_back(0);
+	header.push_back(0);
+
+	FilterRows(pPixels, width, height, channels, filtered);
+	Compress(filtered, compressed);
+
+	png.assign(g_PngSignature, g_PngSignature + sizeof(g_PngSignature));
+	WriteChunk(png, "IHDR", header.data(), header.size());
+	WriteChunk(png, "IDAT", compressed.data(), compressed.size());
+	WriteChunk(png, "IEND", NULL, 0);
+
+	return(true);
+}
+
+/***********************************************************
+ *  WritePng()
+ *
+ *  This method is used for encoding an image and writing it
+ *  to a PNG file.
+ ***********************************************************/
+bool PngEncoder::WritePng(
+	const char* filename,
+	const uint8_t* pPixels,
+	int width,
+	int height,
+	int channels)
+{
+	std::vector<uint8_t> png;
+
+	if (EncodePng(pPixels, width, height, channels, png) == false)
+	{
+		std::cerr << "ERROR: Could not encode image:" << filename << std::endl;
+		return(false);
+	}
+
+	FILE* pFile = fopen(filename, "wb");
+	if (NULL == pFile)
+	{
+		std::cerr << "ERROR: Could not write image:" << filename << std::endl;
+		return(false);
+	}
+	bool bWritten = (fwrite(png.data(), 1, png.size(), pFile) == png.size());
+	bWritten = (fclose(pFile) == 0) && bWritten;
+
+	return(bWritten);
+}
+
+/***********************************************************
+ *  FilterRows()
+ *
+ *  This method is used for putting each row through the PNG
+ *  filter whose output has the smallest sum of differences,
+ *  which usually compresses best, behind its filter byte.
+ ***********************************************************/
+void PngEncoder::FilterRows(const uint8_t* pPixels, int width, int height, int channels, std::vector<uint8_t>& filtered)
+{
+	const size_t rowBytes = (size_t)width * channels;
+	std::vector<uint8_t> candidates[5];
+	std::vector<uint8_t> zeroRow(rowBytes, 0);
+
+	filtered.clear();
+	filtered.reserve((rowBytes + 1) * height);
+	for (int filter = 0; filter < 5; filter++)
+	{
+		candidates[filter].resize(rowBytes);
+	}
+
+	for (int y = 0; y < height; y++)
+	{
+		const uint8_t* pRow = pPixels + rowBytes * y;
+		const uint8_t* pAbove = (y > 0) ? (pRow - rowBytes) : zeroRow.data();
+		int bestFilter = 0;
+		uint64_t bestSum = UINT64_MAX;
+
+		for (int filter = 0; filter < 5; filter++)
+		{
+			uint8_t* pOut = candidates[filter].data();
+			uint64_t sum = 0;
+
+			for (size_t i = 0; i < rowBytes; i++)
+			{
+				int left = (i >= (size_t)channels) ? pRow[i - channels] : 0;
+				int aboveLeft = (i >= (size_t)channels) ? pAbove[i - channels] : 0;
+				int predicted = 0;
+
+				switch (filter)
+				{
+				case 1: predicted = left; break;
+				case 2: predicted = pAbove[i]; break;
+				case 3: predicted = (left + pAbove[i]) / 2; break;
+				case 4: predicted = PaethPredictor(left, pAbove[i], aboveLeft); break;
+				default: break;
+				}
+
+				pOut[i] = (uint8_t)(pRow[i] - predicted);
+				sum += (pOut[i] < 128) ? pOut[i] : (256 - pOut[i]);
+			}
+
+			if (sum < bestSum)
+			{
+				bestSum = sum;
+				bestFilter = filter;
+			}
+		}
+
+		filtered.push_back((uint8_t)bestFilter);
+		filtered.insert(filtered.end(), candidates[bestFilter].begin(), candidates[bestFilter].end());
+	}
+}
+
+/***********************************************************
+ *  Compress()
+ *
+ *  This method is used for compressing data into a zlib
+ *  stream made of one deflate block with the fixed Huffman
+ *  codes.  At each position the longest earlier match with
+ *  the same three byte hash is taken, or the byte is written
+ *  as a literal.
+ ***********************************************************/
+void PngEncoder::Compress(const std::vector<uint8_t>& data, std::vector<uint8_t>& compressed)
+{
+	const int size = (int)data.size();
+	const uint8_t* pData = data.data();
+	// newest position of each hash, and the previous position with
+	// the same hash for each position in the window
+	std::vector<int> head((size_t)1 << g_HashBits, -1);
+	std::vector<int> previous(g_WindowSize, -1);
+	BIT_WRITER writer;
+
+	compressed.clear();
+	compressed.reserve(data.size() / 2 + 64);
+	// deflate with a 32 KB window and no preset dictionary
+	compressed.push_back(0x78);
+	compressed.push_back(0x01);
+
+	writer.pBytes = &compressed;
+	writer.bitBuffer = 0;
+	writer.bitCount = 0;
+	// the final block, with the fixed codes
+	WriteBits(writer, 1, 1);
+	WriteBits(writer, 1, 2);
+
+	// add a position to the hash chains
+	auto insert = [&](int position)
+	{
+		if (position + g_MinMatch <= size)
+		{
+			uint32_t hash = HashBytes(pData + position);
+			previous[position & (g_WindowSize - 1)] = head[hash];
+			head[hash] = position;
+		}
+	};
+
+	int position = 0;
+	while (position < size)
+	{
+		int bestLength = 0;
+		int bestDistance = 0;
+
+		if (position + g_MinMatch <= size)
+		{
+			int maxLength = (size - position < g_MaxMatch) ? (size - position) : g_MaxMatch;
+			int candidate = head[HashBytes(pData + position)];
+
+			for (int chain = 0; (chain < g_MaxChain) && (candidate >= 0) && (position - candidate <= g_WindowSize); chain++)
+			{
+				int length = 0;
+				while ((length < maxLength) && (pData[candidate + length] == pData[position + length]))
+				{
+					length++;
+				}
+				if (length > bestLength)
+				{
+					bestLength = length;
+					bestDistance = position - candidate;
+					if (length == maxLength)
+					{
+						break;
+					}
+				}
+
+				// the slot may hold a newer position once the window wrapped
+				int next = previous[candidate & (g_WindowSize - 1)];
+				candidate = (next < candidate) ? next : -1;
+			}
+		}
+
+		if (bestLength >= g_MinMatch)
+		{
+			WriteMatch(writer, bestLength, bestDistance);
+			for (int i = 0; i < bestLength; i++)
+			{
+				insert(position + i);
+			}
+			position += bestLength;
+		}
+		else
+		{
+			WriteLiteral(writer, pData[position]);
+			insert(position);
+			position++;
+		}
+	}
+
+	// the end of block code, then the last partial byte
+	WriteCode(writer, 0, 7);
+	if (writer.bitCount > 0)
+	{
+		compressed.push_back((uint8_t)writer.bitBuffer);
+	}
+
+	uint32_t adler = Adler32(pData, data.size());
+	WriteBigEndian(compressed, adler);
+}
+
+/***********************************************************
+ *  WriteBits()
+ *
+ *  This method is used for appending the count low bits of
+ *  a value, least significant first.
+ ***********************************************************/
+void PngEncoder::WriteBits(BIT_WRITER& writer, uint32_t bits, int count)
+{
+	writer.bitBuffer |= bits << writer.bitCount;
+	writer.bitCount += count;
+	while (writer.bitCount >= 8)
+	{
+		writer.pBytes->push_back((uint8_t)writer.bitBuffer);
+		writer.bitBuffer >>= 8;
+		writer.bitCount -= 8;
+	}
+}
+
+/***********************************************************
+ *  WriteCode()
+ *
+ *  This method is used for appending a Huffman code, whose
+ *  bits deflate stores starting from the most significant.
+ ***********************************************************/
+void PngEncoder::WriteCode(BIT_WRITER& writer, uint32_t code, int length)
+{
+	uint32_t reversed = 0;
+
+	for (int i = 0; i < length; i++)
+	{
+		reversed = (reversed << 1) | ((code >> i) & 1);
+	}
+	WriteBits(writer, reversed, length);
+}
+
+/***********************************************************
+ *  WriteLiteral()
+ *
+ *  This method is used for appending the fixed code of a
+ *  literal byte.
+ ***********************************************************/
+void PngEncoder::WriteLiteral(BIT_WRITER& writer, int literal)
+{
+	if (literal < 144)
+	{
+		WriteCode(writer, 0x30 + literal, 8);
+	}
+	else
+	{
+		WriteCode(writer, 0x190 + (literal - 144), 9);
+	}
+}
+
+/***********************************************************
+ *  WriteMatch()
+ *
+ *  This method is used for appending the fixed codes of a
+ *  match length and distance with their extra bits.
+ ***********************************************************/
+void PngEncoder::WriteMatch(BIT_WRITER& writer, int length, int distance)
+{
+	int lengthCode = 28;
+	while (g_LengthBase[lengthCode] > length)
+	{
+		lengthCode--;
+	}
+	int symbol = 257 + lengthCode;
+	if (symbol < 280)
+	{
+		WriteCode(writer, symbol - 256, 7);
+	}
+	else
+	{
+		WriteCode(writer, 0xC0 + (symbol - 280), 8);
+	}
+	WriteBits(writer, length - g_LengthBase[lengthCode], g_LengthExtraBits[lengthCode]);
+
+	int distanceCode = 29;
+	while (g_DistanceBase[distanceCode] > distance)
+	{
+		distanceCode--;
+	}
+	WriteCode(writer, distanceCode, 5);
+	WriteBits(writer, distance - g_DistanceBase[distanceCode], g_DistanceExtraBits[distanceCode]);
+}
+
+/***********************************************************
+ *  Crc32()
+ *
+ *  This method is used for continuing the CRC of the chunks
+ *  over more data.
+ ***********************************************************/
+uint32_t PngEncoder::Crc32(const uint8_t* pData, size_t size, uint32_t crc)
+{
+	// the table is built once, by the first thread to get here
+	static const std::vector<uint32_t> table = []()
+	{
+		std::vector<uint32_t> entries(256);
+		for (uint32_t n = 0; n < 256; n++)
+		{
+			uint32_t value = n;
+			for (int bit = 0; bit < 8; bit++)
+			{
+				value = (value & 1) ? (0xEDB88320u ^ (value >> 1)) : (value >> 1);
+			}
+			entries[n] = value;
+		}
+		return(entries);
+	}();
+
+	crc = ~crc;
+	for (size_t i = 0; i < size; i++)
+	{
+		crc = table[(crc ^ pData[i]) & 0xFF] ^ (crc >> 8);
+	}
+	return(~crc);
+}
+
+/***********************************************************
+ *  Adler32()
+ *
+ *  This method is used for computing the checksum that ends
+ *  the zlib stream.
+ ***********************************************************/
+uint32_t PngEncoder::Adler32(const uint8_t* pData, size_t size)
+{
+	const uint32_t MODULUS = 65521;
+	uint32_t low = 1;
+	uint32_t high = 0;
+
+	while (size > 0)
+	{
+		// the sums cannot overflow within this many bytes
+		size_t count = (size < 5552) ? size : 5552;
+		size -= count;
+		while (count-- > 0)
+		{
+			low += *pData++;
+			high += low;
+		}
+		low %= MODULUS;
+		high %= MODULUS;
+	}
+
+	return((high << 16) | low);
+}
+
+/***********************************************************
+ *  WriteChunk()
+ *
+ *  This method is used for appending a PNG chunk: its data
+ *  length, type, data and the CRC of the type and data.
+ ***********************************************************/
+void PngEncoder::WriteChunk(std::vector<uint8_t>& png, const char* type, const uint8_t* pData, size_t size)
+{
+	size_t typeOffset = png.size() + 4;
+
+	WriteBigEndian(png, (uint32_t)size);
+	png.insert(png.end(), (const uint8_t*)type, (const uint8_t*)type + 4);
+	if (size > 0)
+	{
+		png.insert(png.end(), pData, pData + size);
+	}
+	WriteBigEndian(png, Crc32(png.data() + typeOffset, size + 4, 0));
+}
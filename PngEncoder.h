@@ -0,0 +1,67 @@
+///////////////////////////////////////////////////////////////////////////////
+// pngencoder.h
+// ============
+// encode rendered images as PNG files without an external image library
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  PngEncoder
+ *
+ *  This class contains a small PNG writer for 8 bit RGB and
+ *  RGBA images.  Each row gets the PNG filter that leaves
+ *  the smallest differences, and the filtered rows are
+ *  compressed with deflate using its fixed Huffman codes
+ *  and LZ77 matches found through a hash of the next three
+ *  bytes.  That gets close to zlib's level 1 on rendered
+ *  images while staying short.  Every method is thread safe,
+ *  so several images can be encoded at once.
+ ***********************************************************/
+class PngEncoder
+{
+public:
+	// encode a tightly packed image with its rows top to bottom
+	static bool EncodePng(
+		const uint8_t* pPixels,
+		int width,
+		int height,
+		int channels,
+		std::vector<uint8_t>& png);
+	// encode an image and write it to a file
+	static bool WritePng(
+		const char* filename,
+		const uint8_t* pPixels,
+		int width,
+		int height,
+		int channels);
+
+private:
+	// bits written least significant first, as deflate expects
+	struct BIT_WRITER
+	{
+		std::vector<uint8_t>* pBytes;
+		uint32_t bitBuffer;
+		int bitCount;
+	};
+
+	static void WriteBits(BIT_WRITER& writer, uint32_t bits, int count);
+	// write a Huffman code, which deflate stores most significant first
+	static void WriteCode(BIT_WRITER& writer, uint32_t code, int length);
+	static void WriteLiteral(BIT_WRITER& writer, int literal);
+	static void WriteMatch(BIT_WRITER& writer, int length, int distance);
+
+	// filter the rows of an image into the bytes to compress
+	static void FilterRows(const uint8_t* pPixels, int width, int height, int channels, std::vector<uint8_t>& filtered);
+	// wrap the deflate stream of the data in a zlib header and checksum
+	static void Compress(const std::vector<uint8_t>& data, std::vector<uint8_t>& compressed);
+
+	static uint32_t Crc32(const uint8_t* pData, size_t size, uint32_t crc);
+	static uint32_t Adler32(const uint8_t* pData, size_t size);
+	// append a chunk with its length and checksum
+	static void WriteChunk(std::vector<uint8_t>& png, const char* type, const uint8_t* pData, size_t size);
+};
@@ -0,0 +1,403 @@
+///////////////////////////////////////////////////////////////////////////////
+// resolutionscaler.cpp
+// ============
+// render the 3D scene into an offscreen target whose resolution follows
+// the measured frame time, then upscale it to the display framebuffer
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ResolutionScaler.h"
+#include "ResourceTracker.h"
+
+// GLFW library
+#include "GLFW/glfw3.h"
+
+#include <iostream>
+#include <cstring>
+
+// declaration of global variables
+namespace
+{
+	// measured frames between two scale changes
+	const int g_FramesPerAdjustment = 15;
+	// share of the budget below which the scale is raised
+	const double g_RaiseThreshold = 0.7;
+	// scale steps when lowering and raising the resolution
+	const float g_LowerFactor = 0.85f;
+	const float g_RaiseFactor = 1.05f;
+	// weight of the newest measurement in the smoothed time
+	const double g_SmoothingWeight = 0.2;
+	// GL_RENDERER names of rasterizers that run on the CPU
+	const char* const g_SoftwareRenderers[] = {
+		"llvmpipe", "softpipe", "SwiftShader", "Software", "GDI Generic" };
+}
+
+/***********************************************************
+ *  ResolutionScaler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ResolutionScaler::ResolutionScaler()
+{
+	m_framebufferID = 0;
+	m_colorBufferID = 0;
+	m_depthBufferID = 0;
+	m_storageWidth = 0;
+	m_storageHeight = 0;
+	m_sceneWidth = 0;
+	m_sceneHeight = 0;
+
+	for (int i = 0; i < QUERY_COUNT; i++)
+	{
+		m_timerQueries[i] = 0;
+		m_bQueryPending[i] = false;
+	}
+	m_nextQuery = 0;
+	m_bQueryActive = false;
+
+	m_scale = 1.0f;
+	m_minScale = 0.5f;
+	m_maxScale = 1.0f;
+	m_budgetMilliseconds = 1000.0 / 60.0;
+	m_bMeasureFrameTime = false;
+	m_lastBeginTime = 0.0;
+	m_idleSeconds = 0.0;
+	m_sceneMilliseconds = 0.0;
+	m_framesSinceChange = 0;
+	m_bEnabled = true;
+}
+
+/***********************************************************
+ *  ~ResolutionScaler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ResolutionScaler::~ResolutionScaler()
+{
+	Destroy();
+}
+
+/***********************************************************
+ *  Create()
+ *
+ *  This method is used for creating the offscreen framebuffer
+ *  objects and the timer queries.  The attachments are sized
+ *  on the first BeginScene().
+ ***********************************************************/
+bool ResolutionScaler::Create()
+{
+	glGenFramebuffers(1, &m_framebufferID);
+	glGenRenderbuffers(1, &m_colorBufferID);
+	glGenRenderbuffers(1, &m_depthBufferID);
+	glGenQueries(QUERY_COUNT, m_timerQueries);
+	ResourceTracker::Allocate(ResourceCategory::Framebuffer, m_framebufferID, 0, "Dynamic resolution");
+	ResourceTracker::Allocate(ResourceCategory::Renderbuffer, m_colorBufferID, 0, "Dynamic resolution");
+	ResourceTracker::Allocate(ResourceCategory::Renderbuffer, m_depthBufferID, 0, "Dynamic resolution");
+
+	// a software rasterizer draws when the frame is flushed, after
+	// the timer query has ended, so its frame time is used instead
+	const char* renderer = (const char*)glGetString(GL_RENDERER);
+	m_bMeasureFrameTime = false;
+	for (const char* softwareRenderer : g_SoftwareRenderers)
+	{
+		if ((renderer != NULL) && (strstr(renderer, softwareRenderer) != NULL))
+		{
+			m_bMeasureFrameTime = true;
+		}
+	}
+	std::cout << "INFO: Dynamic resolution measures "
+		<< (m_bMeasureFrameTime ? "the frame time" : "the scene GPU time") << std::endl;
+
+	return(m_framebufferID != 0);
+}
+
+/***********************************************************
+ *  Destroy()
+ *
+ *  This method is used for freeing the offscreen framebuffer
+ *  objects and the timer queries.
+ ***********************************************************/
+void ResolutionScaler::Destroy()
+{
+	if (m_framebufferID != 0)
+	{
+		glDeleteFramebuffers(1, &m_framebufferID);
+		glDeleteRenderbuffers(1, &m_colorBufferID);
+		glDeleteRenderbuffers(1, &m_depthBufferID);
+		glDeleteQueries(QUERY_COUNT, m_timerQueries);
+		ResourceTracker::Release(ResourceCategory::Framebuffer, m_framebufferID);
+		ResourceTracker::Release(ResourceCategory::Renderbuffer, m_colorBufferID);
+		ResourceTracker::Release(ResourceCategory::Renderbuffer, m_depthBufferID);
+	}
+
+	m_framebufferID = 0;
+	m_colorBufferID = 0;
+	m_depthBufferID = 0;
+	m_storageWidth = 0;
+	m_storageHeight = 0;
+	for (int i = 0; i < QUERY_COUNT; i++)
+	{
+		m_timerQueries[i] = 0;
+		m_bQueryPending[i] = false;
+	}
+}
+
+/***********************************************************
+ *  SetBudget()
+ *
+ *  This method is used for setting the GPU time allowed for
+ *  the scene pass and the range the scale may move within.
+ ***********************************************************/
+void ResolutionScaler::SetBudget(double budgetMilliseconds, float minScale, float maxScale)
+{
+	m_budgetMilliseconds = budgetMilliseconds;
+	m_minScale = minScale;
+	m_maxScale = maxScale;
+
+	if (m_scale < m_minScale)
+		m_scale = m_minScale;
+	if (m_scale > m_maxScale)
+		m_scale = m_maxScale;
+}
+
+/***********************************************************
+ *  SetEnabled()
+ *
+ *  This method is used for turning the dynamic resolution on
+ *  or off.
+ ***********************************************************/
+void ResolutionScaler::SetEnabled(bool bEnabled)
+{
+	m_bEnabled = bEnabled;
+}
+
+/***********************************************************
+ *  RecordIdleTime()
+ *
+ *  This method is used for adding the time the on-demand
+ *  render loop spent blocked, so it is not mistaken for a
+ *  slow frame.
+ ***********************************************************/
+void ResolutionScaler::RecordIdleTime(double seconds)
+{
+	m_idleSeconds += seconds;
+}
+
+/***********************************************************
+ *  AllocateStorage()
+ *
+ *  This method is used for sizing the offscreen attachments
+ *  to the display framebuffer, the largest scene they hold.
+ ***********************************************************/
+void ResolutionScaler::AllocateStorage(int width, int height)
+{
+	m_storageWidth = width;
+	m_storageHeight = height;
+
+	glBindRenderbuffer(GL_RENDERBUFFER, m_colorBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, m_depthBufferID);
+	glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+	glBindRenderbuffer(GL_RENDERBUFFER, 0);
+	// both formats take 4 bytes per pixel
+	ResourceTracker::Resize(ResourceCategory::Renderbuffer, m_colorBufferID, (size_t)width * height * 4);
+	ResourceTracker::Resize(ResourceCategory::Renderbuffer, m_depthBufferID, (size_t)width * height * 4);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, m_colorBufferID);
+	glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, m_depthBufferID);
+	if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+	{
+		std::cout << "Offscreen scene framebuffer is incomplete, dynamic resolution disabled" << std::endl;
+		m_bEnabled = false;
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+/***********************************************************
+ *  AddMeasurement()
+ *
+ *  This method is used for folding the time of one frame into
+ *  the smoothed scene time.
+ ***********************************************************/
+void ResolutionScaler::AddMeasurement(double milliseconds)
+{
+	m_sceneMilliseconds = (m_sceneMilliseconds == 0.0) ? milliseconds :
+		(m_sceneMilliseconds * (1.0 - g_SmoothingWeight)) + (milliseconds * g_SmoothingWeight);
+	m_framesSinceChange++;
+}
+
+/***********************************************************
+ *  UpdateScale()
+ *
+ *  This method is used for collecting the measurements that
+ *  have finished, without waiting on the others, and moving
+ *  the scale toward the frame time budget.
+ ***********************************************************/
+void ResolutionScaler::UpdateScale()
+{
+	if (m_bMeasureFrameTime)
+	{
+		double now = glfwGetTime();
+		if (m_lastBeginTime > 0.0)
+		{
+			AddMeasurement((now - m_lastBeginTime - m_idleSeconds) * 1000.0);
+		}
+		m_lastBeginTime = now;
+		m_idleSeconds = 0.0;
+	}
+
+	for (int i = 0; i < QUERY_COUNT; i++)
+	{
+		if (m_bQueryPending[i] == false)
+		{
+			continue;
+		}
+
+		GLint bAvailable = 0;
+		glGetQueryObjectiv(m_timerQueries[i], GL_QUERY_RESULT_AVAILABLE, &bAvailable);
+		if (bAvailable == 0)
+		{
+			continue;
+		}
+
+		GLuint64 nanoseconds = 0;
+		glGetQueryObjectui64v(m_timerQueries[i], GL_QUERY_RESULT, &nanoseconds);
+		m_bQueryPending[i] = false;
+
+		AddMeasurement(nanoseconds / 1000000.0);
+	}
+
+	if (m_framesSinceChange < g_FramesPerAdjustment)
+	{
+		return;
+	}
+
+	// the pixel work scales with the square of the scale, so the
+	// steps are kept small and the raise threshold well below 1
+	float newScale = m_scale;
+	if (m_sceneMilliseconds > m_budgetMilliseconds)
+	{
+		newScale = m_scale * g_LowerFactor;
+	}
+	else if (m_sceneMilliseconds < m_budgetMilliseconds * g_RaiseThreshold)
+	{
+		newScale = m_scale * g_RaiseFactor;
+	}
+
+	if (newScale < m_minScale)
+		newScale = m_minScale;
+	if (newScale > m_maxScale)
+		newScale = m_maxScale;
+
+	if (newScale != m_scale)
+	{
+		std::cout << "INFO: Render scale:" << newScale << ", measured ms:" << m_sceneMilliseconds
+			<< ", budget ms:" << m_budgetMilliseconds << std::endl;
+		m_scale = newScale;
+		m_framesSinceChange = 0;
+	}
+}
+
+/***********************************************************
+ *  BeginScene()
+ *
+ *  This method is used for binding the offscreen target at
+ *  the current scale of the display framebuffer size and
+ *  starting the GPU timer of the scene pass.
+ ***********************************************************/
+void ResolutionScaler::BeginScene(int framebufferWidth, int framebufferHeight)
+{
+	// a minimized window still gets a valid, if tiny, target
+	if (framebufferWidth < 1)
+		framebufferWidth = 1;
+	if (framebufferHeight < 1)
+		framebufferHeight = 1;
+
+	if ((m_framebufferID == 0) || (m_bEnabled == false))
+	{
+		m_sceneWidth = framebufferWidth;
+		m_sceneHeight = framebufferHeight;
+		glBindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(0, 0, m_sceneWidth, m_sceneHeight);
+		return;
+	}
+
+	if ((framebufferWidth != m_storageWidth) || (framebufferHeight != m_storageHeight))
+	{
+		AllocateStorage(framebufferWidth, framebufferHeight);
+	}
+
+	UpdateScale();
+
+	m_sceneWidth = (int)(framebufferWidth * m_scale + 0.5f);
+	m_sceneHeight = (int)(framebufferHeight * m_scale + 0.5f);
+	if (m_sceneWidth < 1)
+		m_sceneWidth = 1;
+	if (m_sceneHeight < 1)
+		m_sceneHeight = 1;
+
+	// reuse the oldest query unless its result was never read
+	m_bQueryActive = (m_bMeasureFrameTime == false) && (m_bQueryPending[m_nextQuery] == false);
+	if (m_bQueryActive)
+	{
+		glBeginQuery(GL_TIME_ELAPSED, m_timerQueries[m_nextQuery]);
+	}
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebufferID);
+	glViewport(0, 0, m_sceneWidth, m_sceneHeight);
+}
+
+/***********************************************************
+ *  EndScene()
+ *
+ *  This method is used for stopping the GPU timer and
+ *  stretching the scaled scene over the whole display
+ *  framebuffer with linear filtering.
+ ***********************************************************/
+void ResolutionScaler::EndScene()
+{
+	if ((m_framebufferID == 0) || (m_bEnabled == false))
+	{
+		return;
+	}
+
+	if (m_bQueryActive)
+	{
+		glEndQuery(GL_TIME_ELAPSED);
+		m_bQueryPending[m_nextQuery] = true;
+		m_nextQuery = (m_nextQuery + 1) % QUERY_COUNT;
+	}
+
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, m_framebufferID);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+	glBlitFramebuffer(
+		0, 0, m_sceneWidth, m_sceneHeight,
+		0, 0, m_storageWidth, m_storageHeight,
+		GL_COLOR_BUFFER_BIT,
+		((m_sceneWidth == m_storageWidth) && (m_sceneHeight == m_storageHeight)) ? GL_NEAREST : GL_LINEAR);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(0, 0, m_storageWidth, m_storageHeight);
+}
+
+/***********************************************************
+ *  GetScale()
+ *
+ *  This method is used for getting the current render scale.
+ ***********************************************************/
+float ResolutionScaler::GetScale() const
+{
+	return(m_scale);
+}
+
+/***********************************************************
+ *  GetSceneSize()
+ *
+ *  This method is used for getting the size of the target
+ *  the scene is being drawn into, so it can be split into
+ *  several viewports.
+ ***********************************************************/
+void ResolutionScaler::GetSceneSize(int& width, int& height) const
+{
+	width = m_sceneWidth;
+	height = m_sceneHeight;
+}
@@ -0,0 +1,100 @@
+///////////////////////////////////////////////////////////////////////////////
+// resolutionscaler.h
+// ============
+// render the 3D scene into an offscreen target whose resolution follows
+// the measured frame time, then upscale it to the display framebuffer
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  ResolutionScaler
+ *
+ *  This class contains the offscreen framebuffer the scene is
+ *  drawn into.  Its storage matches the display framebuffer,
+ *  and the scene is drawn into a scaled corner of it, so a
+ *  new scale never reallocates anything.  The GPU time of the
+ *  scene pass is measured with timer queries, or the whole
+ *  frame time on software rasterizers, where the queries only
+ *  cover recording the commands.  The scale is lowered when
+ *  that time exceeds the budget and raised when it is
+ *  comfortably below.
+ ***********************************************************/
+class ResolutionScaler
+{
+public:
+	// constructor
+	ResolutionScaler();
+	// destructor
+	~ResolutionScaler();
+
+private:
+	// offscreen framebuffer and its attachments
+	GLuint m_framebufferID;
+	GLuint m_colorBufferID;
+	GLuint m_depthBufferID;
+	// size of the attachments and of the display framebuffer
+	int m_storageWidth;
+	int m_storageHeight;
+	// size of the scaled scene of the current frame
+	int m_sceneWidth;
+	int m_sceneHeight;
+
+	// timer queries for the last frames, read back once available
+	static const int QUERY_COUNT = 4;
+	GLuint m_timerQueries[QUERY_COUNT];
+	bool m_bQueryPending[QUERY_COUNT];
+	int m_nextQuery;
+	// set while a query is timing the current scene pass
+	bool m_bQueryActive;
+
+	// current scale, its limits and the frame time budget
+	float m_scale;
+	float m_minScale;
+	float m_maxScale;
+	double m_budgetMilliseconds;
+	// measure the frame time on the CPU instead of with queries
+	bool m_bMeasureFrameTime;
+	// glfwGetTime() of the last BeginScene() and the idle time since
+	double m_lastBeginTime;
+	double m_idleSeconds;
+	// smoothed time of the scene pass
+	double m_sceneMilliseconds;
+	// frames measured since the scale last changed
+	int m_framesSinceChange;
+	bool m_bEnabled;
+
+	// (re)allocate the attachments for a display framebuffer size
+	void AllocateStorage(int width, int height);
+	// add a measured frame to the smoothed scene time
+	void AddMeasurement(double milliseconds);
+	// collect the finished measurements and adapt the scale
+	void UpdateScale();
+
+public:
+	// create the offscreen framebuffer and the timer queries
+	bool Create();
+	// free the offscreen framebuffer and the timer queries
+	void Destroy();
+
+	// set the frame time budget and the allowed scale range
+	void SetBudget(double budgetMilliseconds, float minScale, float maxScale);
+	// turn the scaling on or off - when off the scene is drawn
+	// straight into the display framebuffer
+	void SetEnabled(bool bEnabled);
+	// leave time the render loop spent blocked waiting for events
+	// out of the measured frame time
+	void RecordIdleTime(double seconds);
+
+	// bind the offscreen target at the scaled size of the display
+	// framebuffer, ready for clearing and drawing the scene
+	void BeginScene(int framebufferWidth, int framebufferHeight);
+	// upscale the scene into the display framebuffer
+	void EndScene();
+
+	float GetScale() const;
+	// size in pixels of the target bound by the last BeginScene()
+	void GetSceneSize(int& width, int& height) const;
+};
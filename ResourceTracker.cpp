@@ -0,0 +1,305 @@
+///////////////////////////////////////////////////////////////////////////////
+// resourcetracker.cpp
+// ============
+// account for the GPU and CPU memory held by the textures, buffers, shader
+// programs and long lived blocks of the application, and report what is
+// still allocated at shutdown
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ResourceTracker.h"
+
+#include <chrono>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+
+// declaration of global variables
+namespace
+{
+	const int g_CategoryCount = (int)ResourceCategory::HostMemory + 1;
+	const char* const g_CategoryNames[g_CategoryCount] =
+	{
+		"texture", "buffer", "vertex array", "renderbuffer", "framebuffer", "program", "host memory"
+	};
+
+	// one live resource
+	struct RESOURCE_RECORD
+	{
+		size_t bytes;
+		std::string ownerTag;
+		std::chrono::steady_clock::time_point allocatedTime;
+	};
+
+	// every live resource and the totals, guarded by the mutex
+	struct RESOURCE_REGISTRY
+	{
+		std::mutex mutex;
+		std::map<std::pair<int, uintptr_t>, RESOURCE_RECORD> records;
+		ResourceTracker::RESOURCE_TOTALS totals[g_CategoryCount];
+		std::chrono::steady_clock::time_point startTime;
+		std::chrono::steady_clock::time_point lastReportTime;
+
+		RESOURCE_REGISTRY() : totals()
+		{
+			startTime = std::chrono::steady_clock::now();
+			lastReportTime = startTime;
+		}
+	};
+
+	// the registry is built on first use, so owners created during
+	// static initialization can already report to it
+	RESOURCE_REGISTRY& GetRegistry()
+	{
+		static RESOURCE_REGISTRY registry;
+		return(registry);
+	}
+
+	// seconds between two times
+	double GetSeconds(std::chrono::steady_clock::time_point from, std::chrono::steady_clock::time_point to)
+	{
+		return(std::chrono::duration<double>(to - from).count());
+	}
+
+	// change the live bytes of a category and follow its peak
+	void AddLiveBytes(ResourceTracker::RESOURCE_TOTALS& totals, size_t oldBytes, size_t newBytes)
+	{
+		totals.liveBytes = totals.liveBytes - oldBytes + newBytes;
+		if (totals.liveBytes > totals.peakBytes)
+		{
+			totals.peakBytes = totals.liveBytes;
+		}
+	}
+}
+
+/***********************************************************
+ *  Allocate()
+ *
+ *  This method is used for recording a resource its owner
+ *  just created.  A handle that is already tracked only gets
+ *  its new size, since OpenGL hands out the same name again
+ *  once it has been deleted.
+ ***********************************************************/
+void ResourceTracker::Allocate(ResourceCategory category, uintptr_t handle, size_t bytes, const char* ownerTag)
+{
+	RESOURCE_REGISTRY& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	RESOURCE_TOTALS& totals = registry.totals[(int)category];
+	RESOURCE_RECORD& record = registry.records[std::make_pair((int)category, handle)];
+
+	if (record.ownerTag.empty())
+	{
+		record.bytes = 0;
+		record.ownerTag = (NULL != ownerTag) ? ownerTag : "unknown";
+		record.allocatedTime = std::chrono::steady_clock::now();
+		totals.liveCount++;
+		totals.allocations++;
+	}
+
+	AddLiveBytes(totals, record.bytes, bytes);
+	record.bytes = bytes;
+}
+
+/***********************************************************
+ *  Resize()
+ *
+ *  This method is used for setting the size of a tracked
+ *  resource whose storage changed, such as a texture whose
+ *  resident mip levels changed.
+ ***********************************************************/
+void ResourceTracker::Resize(ResourceCategory category, uintptr_t handle, size_t bytes)
+{
+	RESOURCE_REGISTRY& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	auto found = registry.records.find(std::make_pair((int)category, handle));
+
+	if (found == registry.records.end())
+	{
+		std::cerr << "ERROR: Resized untracked " << g_CategoryNames[(int)category] << " " << handle << std::endl;
+		return;
+	}
+
+	AddLiveBytes(registry.totals[(int)category], found->second.bytes, bytes);
+	found->second.bytes = bytes;
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used for forgetting a resource its owner
+ *  just freed and adding its lifetime to the totals.
+ ***********************************************************/
+void ResourceTracker::Release(ResourceCategory category, uintptr_t handle)
+{
+	RESOURCE_REGISTRY& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	auto found = registry.records.find(std::make_pair((int)category, handle));
+
+	if (found == registry.records.end())
+	{
+		std::cerr << "ERROR: Released untracked " << g_CategoryNames[(int)category] << " " << handle << std::endl;
+		return;
+	}
+
+	RESOURCE_TOTALS& totals = registry.totals[(int)category];
+	AddLiveBytes(totals, found->second.bytes, 0);
+	totals.liveCount--;
+	totals.releases++;
+	totals.releasedLifetimeSeconds += GetSeconds(found->second.allocatedTime, std::chrono::steady_clock::now());
+	registry.records.erase(found);
+}
+
+/***********************************************************
+ *  GetTotals()
+ *
+ *  This method is used for getting the totals of a category.
+ ***********************************************************/
+ResourceTracker::RESOURCE_TOTALS ResourceTracker::GetTotals(ResourceCategory category)
+{
+	RESOURCE_REGISTRY& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+
+	return(registry.totals[(int)category]);
+}
+
+/***********************************************************
+ *  GetTotalBytes()
+ *
+ *  This method is used for getting the live bytes of every
+ *  category together.
+ ***********************************************************/
+size_t ResourceTracker::GetTotalBytes()
+{
+	RESOURCE_REGISTRY& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	size_t bytes = 0;
+
+	for (int i = 0; i < g_CategoryCount; i++)
+	{
+		bytes += registry.totals[i].liveBytes;
+	}
+
+	return(bytes);
+}
+
+/***********************************************************
+ *  GetCategoryName()
+ *
+ *  This method is used for getting the printed name of a
+ *  category.
+ ***********************************************************/
+const char* ResourceTracker::GetCategoryName(ResourceCategory category)
+{
+	return(g_CategoryNames[(int)category]);
+}
+
+/***********************************************************
+ *  Dump()
+ *
+ *  This method is used for printing the live, peak and
+ *  lifetime totals of each category in use, then the live
+ *  bytes held by each owner.
+ ***********************************************************/
+void ResourceTracker::Dump()
+{
+	RESOURCE_REGISTRY& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	std::map<std::string, std::pair<size_t, size_t>> owners;
+	size_t liveBytes = 0;
+
+	for (int i = 0; i < g_CategoryCount; i++)
+	{
+		liveBytes += registry.totals[i].liveBytes;
+	}
+	std::cout << "INFO: Resources, " << registry.records.size() << " live, "
+		<< (liveBytes / 1024) << " KB" << std::endl;
+
+	for (int i = 0; i < g_CategoryCount; i++)
+	{
+		const RESOURCE_TOTALS& totals = registry.totals[i];
+		if (totals.allocations == 0)
+		{
+			continue;
+		}
+
+		std::cout << "INFO:   " << g_CategoryNames[i]
+			<< ": live:" << totals.liveCount
+			<< ", KB:" << (totals.liveBytes / 1024)
+			<< ", peak KB:" << (totals.peakBytes / 1024)
+			<< ", allocated:" << totals.allocations
+			<< ", released:" << totals.releases;
+		if (totals.releases > 0)
+		{
+			std::cout << ", average lifetime s:" << (totals.releasedLifetimeSeconds / totals.releases);
+		}
+		std::cout << std::endl;
+	}
+
+	for (const auto& entry : registry.records)
+	{
+		std::pair<size_t, size_t>& owner = owners[entry.second.ownerTag];
+		owner.first++;
+		owner.second += entry.second.bytes;
+	}
+	for (const auto& owner : owners)
+	{
+		std::cout << "INFO:   owner " << owner.first
+			<< ": resources:" << owner.second.first
+			<< ", KB:" << (owner.second.second / 1024) << std::endl;
+	}
+}
+
+/***********************************************************
+ *  ReportPeriodically()
+ *
+ *  This method is used for dumping the totals each time
+ *  intervalSeconds have passed since the last report.
+ ***********************************************************/
+void ResourceTracker::ReportPeriodically(double intervalSeconds)
+{
+	RESOURCE_REGISTRY& registry = GetRegistry();
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	{
+		std::lock_guard<std::mutex> lock(registry.mutex);
+		if (GetSeconds(registry.lastReportTime, now) < intervalSeconds)
+		{
+			return;
+		}
+		registry.lastReportTime = now;
+	}
+
+	Dump();
+}
+
+/***********************************************************
+ *  ReportLeaks()
+ *
+ *  This method is used for printing each resource that was
+ *  never released, with its owner, size and age, once the
+ *  owners have all been destroyed at shutdown.
+ ***********************************************************/
+size_t ResourceTracker::ReportLeaks()
+{
+	RESOURCE_REGISTRY& registry = GetRegistry();
+	std::lock_guard<std::mutex> lock(registry.mutex);
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+	for (const auto& entry : registry.records)
+	{
+		const RESOURCE_RECORD& record = entry.second;
+		std::cerr << "ERROR: Leaked " << g_CategoryNames[entry.first.first] << " " << entry.first.second
+			<< " of " << record.ownerTag
+			<< ", bytes:" << record.bytes
+			<< ", allocated at s:" << GetSeconds(registry.startTime, record.allocatedTime)
+			<< ", alive s:" << GetSeconds(record.allocatedTime, now) << std::endl;
+	}
+
+	if (registry.records.size() == 0)
+	{
+		std::cout << "INFO: No resources leaked" << std::endl;
+	}
+
+	return(registry.records.size());
+}
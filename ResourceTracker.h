@@ -0,0 +1,74 @@
+///////////////////////////////////////////////////////////////////////////////
+// resourcetracker.h
+// ============
+// account for the GPU and CPU memory held by the textures, buffers, shader
+// programs and long lived blocks of the application, and report what is
+// still allocated at shutdown
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// kinds of tracked resources
+enum class ResourceCategory
+{
+	Texture,
+	Buffer,
+	VertexArray,
+	Renderbuffer,
+	Framebuffer,
+	Program,
+	HostMemory
+};
+
+/***********************************************************
+ *  ResourceTracker
+ *
+ *  This class contains the record of every live resource,
+ *  keyed by its category and handle - the OpenGL name, or
+ *  the address for host memory - with its size in bytes,
+ *  the tag of its owner and the time it was allocated.  The
+ *  owners report each allocation, size change and release,
+ *  and the totals per category are kept up to date for
+ *  querying at any time.  Every method is thread safe.
+ *
+ *  The sizes are estimates of what the driver holds, e.g.
+ *  4 bytes per RGB texel, and objects without storage such
+ *  as vertex arrays count 0 bytes.
+ ***********************************************************/
+class ResourceTracker
+{
+public:
+	// live and lifetime totals of one category
+	struct RESOURCE_TOTALS
+	{
+		size_t liveCount;
+		size_t liveBytes;
+		size_t peakBytes;
+		size_t allocations;
+		size_t releases;
+		// seconds the released resources were alive, summed
+		double releasedLifetimeSeconds;
+	};
+
+	// record a new resource, or the new size of a tracked one
+	static void Allocate(ResourceCategory category, uintptr_t handle, size_t bytes, const char* ownerTag);
+	// set the size of a tracked resource
+	static void Resize(ResourceCategory category, uintptr_t handle, size_t bytes);
+	// forget a released resource
+	static void Release(ResourceCategory category, uintptr_t handle);
+
+	static RESOURCE_TOTALS GetTotals(ResourceCategory category);
+	// live bytes of every category
+	static size_t GetTotalBytes();
+	static const char* GetCategoryName(ResourceCategory category);
+
+	// print the totals per category and the live bytes per owner
+	static void Dump();
+	// call every frame to Dump() once each intervalSeconds
+	static void ReportPeriodically(double intervalSeconds);
+	// print every resource still allocated, returns their number
+	static size_t ReportLeaks();
+};
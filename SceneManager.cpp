@@ -14,17 +14,105 @@
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 #endif
+#include "MeshOptimizer.h"
 
 #include <glm/gtx/transform.hpp>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
 // declaration of global variables
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
+	constexpr StringId g_ModelName = "model"_id;
+	constexpr StringId g_ColorValueName = "objectColor"_id;
+	constexpr StringId g_TextureValueName = "objectTexture"_id;
+	constexpr StringId g_UseTextureName = "bUseTexture"_id;
+	constexpr StringId g_UseLightingName = "bUseLighting"_id;
+	constexpr StringId g_InstanceIndexName = "instanceIndex"_id;
+	constexpr StringId g_UseBakedLightingName = "bUseBakedLighting"_id;
+	constexpr StringId g_UVScaleName = "UVscale"_id;
+	constexpr StringId g_MaterialAmbientColorName = "material.ambientColor"_id;
+	constexpr StringId g_MaterialAmbientStrengthName = "material.ambientStrength"_id;
+	constexpr StringId g_MaterialDiffuseColorName = "material.diffuseColor"_id;
+	constexpr StringId g_MaterialSpecularColorName = "material.specularColor"_id;
+	constexpr StringId g_MaterialShininessName = "material.shininess"_id;
+	const char* g_InstanceBlockName = "InstanceBlock";
+
+	// uniforms set for every draw, their locations are looked up
+	// once when the scene is prepared
+	const char* const g_DrawUniformNames[] = {
+		"model",
+		"objectColor",
+		"objectTexture",
+		"bUseTexture",
+		"bUseLighting",
+		"instanceIndex",
+		"bUseBakedLighting",
+		"UVscale",
+		"material.ambientColor",
+		"material.ambientStrength",
+		"material.diffuseColor",
+		"material.specularColor",
+		"material.shininess"
+	};
+	// shader storage binding point of the instance block
+	const GLuint g_InstanceBlockBinding = 0;
+
+	// number of scene objects handled by each draw list job
+	const size_t g_DrawListGrainSize = 256;
+	// number of animated objects moved by each job
+	const size_t g_AnimatedObjectGrainSize = 256;
+
+	// smallest projected diameter in pixels drawn with each level of
+	// detail, the last level is used below the others
+	const float g_LodMinimumPixels[ParametricMeshes::LOD_COUNT] = { 160.0f, 60.0f, 20.0f, 0.0f };
+	// share of a threshold the size must move past to change level
+	const float g_LodHysteresis = 0.15f;
+	// vertex layout of the generated levels of detail
+	const VertexFormat g_LodVertexFormat = VertexFormat::Quantized;
+
+	// fewest static objects worth merging into a batch
+	const size_t g_MinimumStaticBatchObjects = 2;
+	// vertex layout of the merged static batches
+	const VertexFormat g_StaticVertexFormat = VertexFormat::Quantized;
+	// tessellation of the spheres and cylinders in the static batches
+	const int g_StaticSphereStacks = 18;
+	const int g_StaticSphereSlices = 36;
+	const int g_StaticCylinderSlices = 36;
+	// file keeping the baked lighting of the static batches
+	const char* g_StaticLightingCacheName = "StaticLighting.cache";
+	// most cells a box or plane edge is split into for baking
+	const int g_MaxBakeCellsPerEdge = 64;
+	// sort key mesh bits of the static batches, after the shapes
+	const uint64_t g_StaticBatchSortKey = 0xF;
+
+	// frames drawn before RenderScene() must stop allocating
+	const unsigned int g_SteadyStateFrames = 3;
+
+	// GPU memory the streamed textures may use unless set otherwise
+	const size_t g_DefaultTextureBudget = 64 * 1024 * 1024;
+
+	// starting root cell and smallest cell of the spatial index
+	const float g_SpatialIndexHalfSize = 16.0f;
+	const float g_SpatialIndexMinHalfSize = 1.0f;
+
+	// projected size in pixels of the largest side of a box, using
+	// the clip space w of its center, which is the view distance
+	// or 1 for an orthographic view
+	float GetProjectedSize(const BOUNDING_BOX& bounds, const glm::mat4& viewProjection, float pixelsPerUnit)
+	{
+		glm::vec3 center = (bounds.minXYZ + bounds.maxXYZ) * 0.5f;
+		glm::vec3 extent = bounds.maxXYZ - bounds.minXYZ;
+		float diameter = std::max(extent.x, std::max(extent.y, extent.z));
+		float w = (viewProjection * glm::vec4(center, 1.0f)).w;
+
+		return(diameter * pixelsPerUnit / std::max(w, 0.1f));
+	}
 }
 
 /***********************************************************
@@ -36,6 +124,18 @@ SceneManager::SceneManager(ShaderManager* pShaderManager)
 {
 	m_pShaderManager = pShaderManager;
 	m_basicMeshes = new ShapeMeshes();
+	m_lodMeshes = NULL;
+	m_pJobSystem = NULL;
+	m_pSpatialIndex = new LooseOctree(glm::vec3(0.0f), g_SpatialIndexHalfSize, g_SpatialIndexMinHalfSize);
+	m_pPickingHierarchy = new BoundingVolumeHierarchy();
+	m_pTextureStreamer = new TextureStreamer(g_DefaultTextureBudget);
+	m_bPickingBoundsMoved = false;
+	m_bInstanceBlockSupported = false;
+	m_bBakedLightingSupported = false;
+	m_pLightBaker = new StaticLightBaker(g_StaticLightingCacheName);
+	m_pAnimation = new AnimationSystem();
+	m_loadedTextures = 0;
+	m_renderedFrames = 0;
 
 }
 
@@ -49,17 +149,31 @@ SceneManager::~SceneManager()
 	m_pShaderManager = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	DestroyStaticBatches();
+	delete m_lodMeshes;
+	m_lodMeshes = NULL;
+	delete m_pSpatialIndex;
+	m_pSpatialIndex = NULL;
+	delete m_pPickingHierarchy;
+	m_pPickingHierarchy = NULL;
+	DestroyGLTextures();
+	delete m_pTextureStreamer;
+	m_pTextureStreamer = NULL;
+	delete m_pLightBaker;
+	m_pLightBaker = NULL;
+	delete m_pAnimation;
+	m_pAnimation = NULL;
 }
 
 /***********************************************************
  *  CreateGLTexture()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  This method is used for loading textures from image files
+ *  and handing them to the texture streamer, which uploads
+ *  their coarse mipmaps into the next available texture slot
+ *  and streams in the finer ones as they are needed.
  ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+bool SceneManager::CreateGLTexture(const char* filename, const char* tag)
 {
 	int width = 0;
 	int height = 0;
@@ -82,38 +196,28 @@ bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
 	{
 		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
 
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
+		// only RGB and RGBA images are handled - RGBA supports transparency
+		if ((colorChannels != 3) && (colorChannels != 4))
 		{
 			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+			stbi_image_free(image);
 			return false;
 		}
 
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
+		// the streamer keeps the file name to read the finer mipmaps again
+		textureID = m_pTextureStreamer->AddTexture(filename, image, width, height, colorChannels);
 
 		// free the image data from local memory
 		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
+		if (textureID == 0)
+		{
+			std::cout << "Could not create texture for image:" << filename << std::endl;
+			return false;
+		}
 
 		// register the loaded texture and associate it with the special tag string
 		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
+		m_textureIDs[m_loadedTextures].tag = StringId::Register(tag);
 		m_loadedTextures++;
 
 		return true;
@@ -155,10 +259,8 @@ void SceneManager::LoadSceneTextures()
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
-	for (int i = 0; i < m_loadedTextures; i++)
-	{
-		glGenTextures(1, &m_textureIDs[i].ID);
-	}
+	m_pTextureStreamer->DestroyTextures();
+	m_loadedTextures = 0;
 }
 
 /***********************************************************
@@ -167,7 +269,7 @@ void SceneManager::DestroyGLTextures()
  *  This method is used for getting an ID for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+int SceneManager::FindTextureID(StringId tag)
 {
 	int textureID = -1;
 	int index = 0;
@@ -175,7 +277,7 @@ int SceneManager::FindTextureID(std::string tag)
 
 	while ((index < m_loadedTextures) && (bFound == false))
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
+		if (m_textureIDs[index].tag == tag)
 		{
 			textureID = m_textureIDs[index].ID;
 			bFound = true;
@@ -193,7 +295,7 @@ int SceneManager::FindTextureID(std::string tag)
  *  This method is used for getting a slot index for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::FindTextureSlot(StringId tag) const
 {
 	int textureSlot = -1;
 	int index = 0;
@@ -201,7 +303,7 @@ int SceneManager::FindTextureSlot(std::string tag)
 
 	while ((index < m_loadedTextures) && (bFound == false))
 	{
-		if (m_textureIDs[index].tag.compare(tag) == 0)
+		if (m_textureIDs[index].tag == tag)
 		{
 			textureSlot = index;
 			bFound = true;
@@ -219,7 +321,7 @@ int SceneManager::FindTextureSlot(std::string tag)
  *  This method is used for getting a material from the previously
  *  defined materials list that is associated with the passed in tag.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+bool SceneManager::FindMaterial(StringId tag, OBJECT_MATERIAL& material)
 {
 	if (m_objectMaterials.size() == 0)
 	{
@@ -230,7 +332,7 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 	bool bFound = false;
 	while ((index < m_objectMaterials.size()) && (bFound == false))
 	{
-		if (m_objectMaterials[index].tag.compare(tag) == 0)
+		if (m_objectMaterials[index].tag == tag)
 		{
 			bFound = true;
 			material.ambientColor = m_objectMaterials[index].ambientColor;
@@ -245,16 +347,35 @@ bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
 		}
 	}
 
-	return(true);
+	return(bFound);
 }
 
 /***********************************************************
- *  SetTransformations()
+ *  FindMaterialIndex()
  *
- *  This method is used for setting the transform buffer
- *  using the passed in transformation values.
+ *  This method is used for getting the index of a previously
+ *  defined material, or -1 when no material has the tag.
  ***********************************************************/
-void SceneManager::SetTransformations(
+int SceneManager::FindMaterialIndex(StringId tag) const
+{
+	for (int index = 0; index < (int)m_objectMaterials.size(); index++)
+	{
+		if (m_objectMaterials[index].tag == tag)
+		{
+			return(index);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  BuildModelMatrix()
+ *
+ *  This method is used for composing the model matrix from
+ *  the passed in transformation values.
+ ***********************************************************/
+glm::mat4 SceneManager::BuildModelMatrix(
 	glm::vec3 scaleXYZ,
 	float XrotationDegrees,
 	float YrotationDegrees,
@@ -262,7 +383,6 @@ void SceneManager::SetTransformations(
 	glm::vec3 positionXYZ)
 {
 	// variables for this method
-	glm::mat4 modelView;
 	glm::mat4 scale;
 	glm::mat4 rotationX;
 	glm::mat4 rotationY;
@@ -278,11 +398,321 @@ void SceneManager::SetTransformations(
 	// set the translation value in the transform buffer
 	translation = glm::translate(positionXYZ);
 
-	modelView = translation * rotationX * rotationY * rotationZ * scale;
+	return(translation * rotationX * rotationY * rotationZ * scale);
+}
+
+/***********************************************************
+ *  GetShapeBounds()
+ *
+ *  This method is used for getting the object space bounds
+ *  of the basic meshes drawn by ShapeMeshes.
+ ***********************************************************/
+BOUNDING_BOX SceneManager::GetShapeBounds(ShapeType shape)
+{
+	BOUNDING_BOX bounds;
+
+	switch (shape)
+	{
+	case ShapeType::Box:
+		bounds.minXYZ = glm::vec3(-0.5f, -0.5f, -0.5f);
+		bounds.maxXYZ = glm::vec3(0.5f, 0.5f, 0.5f);
+		break;
+	case ShapeType::Plane:
+		bounds.minXYZ = glm::vec3(-1.0f, 0.0f, -1.0f);
+		bounds.maxXYZ = glm::vec3(1.0f, 0.0f, 1.0f);
+		break;
+	case ShapeType::Sphere:
+		bounds.minXYZ = glm::vec3(-1.0f, -1.0f, -1.0f);
+		bounds.maxXYZ = glm::vec3(1.0f, 1.0f, 1.0f);
+		break;
+	case ShapeType::Cylinder:
+	default:
+		bounds.minXYZ = glm::vec3(-1.0f, 0.0f, -1.0f);
+		bounds.maxXYZ = glm::vec3(1.0f, 1.0f, 1.0f);
+		break;
+	}
+
+	return(bounds);
+}
+
+/***********************************************************
+ *  GetObjectBounds()
+ *
+ *  This method is used for getting the world space bounds
+ *  of a scene object from its transformation values.
+ ***********************************************************/
+BOUNDING_BOX SceneManager::GetObjectBounds(const SCENE_OBJECT& object)
+{
+	glm::mat4 model = BuildModelMatrix(
+		object.scaleXYZ,
+		object.XrotationDegrees,
+		object.YrotationDegrees,
+		object.ZrotationDegrees,
+		object.positionXYZ);
+
+	return(TransformBoundingBox(GetShapeBounds(object.shape), model));
+}
+
+/***********************************************************
+ *  IntersectRayShape()
+ *
+ *  This method is used for intersecting a ray in the object
+ *  space of a basic mesh with the analytic surface the mesh
+ *  approximates - the unit box, the 2x2 plane, the unit
+ *  sphere and the capped unit cylinder standing on y = 0.
+ *  The distance is in units of the direction, and 0 when the
+ *  ray starts inside the shape.
+ ***********************************************************/
+bool SceneManager::IntersectRayShape(
+	ShapeType shape,
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float maxDistance,
+	float& distance)
+{
+	float closest = std::numeric_limits<float>::max();
+
+	switch (shape)
+	{
+	case ShapeType::Box:
+	{
+		glm::vec3 inverseDirection;
+		for (int axis = 0; axis < 3; axis++)
+		{
+			inverseDirection[axis] = (direction[axis] != 0.0f) ?
+				(1.0f / direction[axis]) : std::numeric_limits<float>::infinity();
+		}
+		float entry = 0.0f;
+		if (IntersectRayBox(origin, inverseDirection, maxDistance, GetShapeBounds(shape), entry))
+		{
+			closest = entry;
+		}
+		break;
+	}
+	case ShapeType::Plane:
+	{
+		if (direction.y != 0.0f)
+		{
+			float t = -origin.y / direction.y;
+			glm::vec3 hit = origin + (direction * t);
+			if ((t >= 0.0f) && (std::fabs(hit.x) <= 1.0f) && (std::fabs(hit.z) <= 1.0f))
+			{
+				closest = t;
+			}
+		}
+		break;
+	}
+	case ShapeType::Sphere:
+	{
+		float a = glm::dot(direction, direction);
+		float b = glm::dot(origin, direction);
+		float c = glm::dot(origin, origin) - 1.0f;
+		float discriminant = (b * b) - (a * c);
+		if ((a > 0.0f) && (discriminant >= 0.0f))
+		{
+			float root = std::sqrt(discriminant);
+			float tFar = (-b + root) / a;
+			if (tFar >= 0.0f)
+			{
+				closest = std::fmax((-b - root) / a, 0.0f);
+			}
+		}
+		break;
+	}
+	case ShapeType::Cylinder:
+	default:
+	{
+		// from inside the volume the ray hits right away
+		if ((origin.y >= 0.0f) && (origin.y <= 1.0f) &&
+			(((origin.x * origin.x) + (origin.z * origin.z)) <= 1.0f))
+		{
+			closest = 0.0f;
+			break;
+		}
+
+		// the curved side between the caps
+		float a = (direction.x * direction.x) + (direction.z * direction.z);
+		float b = (origin.x * direction.x) + (origin.z * direction.z);
+		float c = (origin.x * origin.x) + (origin.z * origin.z) - 1.0f;
+		float discriminant = (b * b) - (a * c);
+		if ((a > 0.0f) && (discriminant >= 0.0f))
+		{
+			float t = (-b - std::sqrt(discriminant)) / a;
+			float y = origin.y + (direction.y * t);
+			if ((t >= 0.0f) && (y >= 0.0f) && (y <= 1.0f))
+			{
+				closest = t;
+			}
+		}
+
+		// the caps at both ends
+		if (direction.y != 0.0f)
+		{
+			for (int cap = 0; cap < 2; cap++)
+			{
+				float t = ((float)cap - origin.y) / direction.y;
+				glm::vec3 hit = origin + (direction * t);
+				if ((t >= 0.0f) && (t < closest) &&
+					(((hit.x * hit.x) + (hit.z * hit.z)) <= 1.0f))
+				{
+					closest = t;
+				}
+			}
+		}
+		break;
+	}
+	}
+
+	if (closest > maxDistance)
+	{
+		return(false);
+	}
+
+	distance = closest;
+	return(true);
+}
+
+/***********************************************************
+ *  IntersectRayObject()
+ *
+ *  This method is used for intersecting a world space ray
+ *  with a scene object by moving the ray into the object
+ *  space of its mesh.  The direction is transformed without
+ *  being normalized, so the distance stays the world one.
+ ***********************************************************/
+bool SceneManager::IntersectRayObject(
+	size_t index,
+	const glm::vec3& origin,
+	const glm::vec3& direction,
+	float maxDistance,
+	float& distance) const
+{
+	const SCENE_OBJECT& object = m_sceneObjects[index];
+	glm::mat4 inverseModel = glm::inverse(BuildModelMatrix(
+		object.scaleXYZ,
+		object.XrotationDegrees,
+		object.YrotationDegrees,
+		object.ZrotationDegrees,
+		object.positionXYZ));
+
+	glm::vec3 objectOrigin = glm::vec3(inverseModel * glm::vec4(origin, 1.0f));
+	glm::vec3 objectDirection = glm::vec3(inverseModel * glm::vec4(direction, 0.0f));
+
+	return(IntersectRayShape(object.shape, objectOrigin, objectDirection, maxDistance, distance));
+}
+
+/***********************************************************
+ *  SelectLod()
+ *
+ *  This method is used for picking the level of detail of
+ *  an object from its projected diameter in pixels.  Moving
+ *  to another level needs the size to pass the threshold by
+ *  the hysteresis margin, so an object hovering around a
+ *  threshold does not pop back and forth every frame.
+ ***********************************************************/
+int SceneManager::SelectLod(float pixelSize, int previousLod)
+{
+	int lod = previousLod;
+
+	while ((lod < ParametricMeshes::LOD_COUNT - 1) &&
+		(pixelSize < g_LodMinimumPixels[lod] * (1.0f - g_LodHysteresis)))
+	{
+		lod++;
+	}
+	while ((lod > 0) &&
+		(pixelSize > g_LodMinimumPixels[lod - 1] * (1.0f + g_LodHysteresis)))
+	{
+		lod--;
+	}
+
+	return(lod);
+}
+
+/***********************************************************
+ *  BuildShapeMesh()
+ *
+ *  This method is used for generating the mesh data of a
+ *  basic shape at full detail, for merging into the static
+ *  batches.  The cells only split boxes and planes, whose
+ *  faces otherwise have vertices at their corners alone.
+ ***********************************************************/
+void SceneManager::BuildShapeMesh(ShapeType shape, ParametricMeshes::MESH_DATA& mesh, const glm::ivec3& cells)
+{
+	switch (shape)
+	{
+	case ShapeType::Box:
+		ParametricMeshes::BuildBox(mesh, cells);
+		break;
+	case ShapeType::Plane:
+		ParametricMeshes::BuildPlane(mesh, cells.x, cells.z);
+		break;
+	case ShapeType::Sphere:
+		ParametricMeshes::BuildSphere(g_StaticSphereStacks, g_StaticSphereSlices, mesh);
+		break;
+	case ShapeType::Cylinder:
+	default:
+		ParametricMeshes::BuildCylinder(g_StaticCylinderSlices, mesh);
+		break;
+	}
+}
+
+/***********************************************************
+ *  GetBakeCells()
+ *
+ *  This method is used for working out how finely the faces
+ *  of a box or plane must be split for the light baked at
+ *  their vertices to show its falloff across them, from the
+ *  size of the object along each axis.
+ ***********************************************************/
+glm::ivec3 SceneManager::GetBakeCells(const SCENE_OBJECT& object, float vertexSpacing)
+{
+	glm::vec3 size = glm::abs(object.scaleXYZ);
+	glm::ivec3 cells(1);
+
+	if ((object.shape != ShapeType::Box) && (object.shape != ShapeType::Plane))
+	{
+		return(cells);
+	}
+
+	// the plane spans -1 to 1, the box -0.5 to 0.5
+	if (object.shape == ShapeType::Plane)
+	{
+		size *= 2.0f;
+	}
+	for (int axis = 0; axis < 3; axis++)
+	{
+		float count = std::ceil(size[axis] / vertexSpacing);
+		cells[axis] = (count < (float)g_MaxBakeCellsPerEdge) ? std::max((int)count, 1) : g_MaxBakeCellsPerEdge;
+	}
+
+	return(cells);
+}
+
+/***********************************************************
+ *  SetTransformations()
+ *
+ *  This method is used for setting the transform buffer
+ *  using the passed in transformation values.
+ ***********************************************************/
+void SceneManager::SetTransformations(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	glm::mat4 modelView;
+
+	modelView = BuildModelMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
 
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
+		m_uniforms.SetMat4(g_ModelName, modelView);
 	}
 }
 
@@ -308,8 +738,8 @@ void SceneManager::SetShaderColor(
 
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
+		m_uniforms.SetInt(g_UseTextureName, false);
+		m_uniforms.SetVec4(g_ColorValueName, currentColor);
 	}
 }
 
@@ -320,15 +750,31 @@ void SceneManager::SetShaderColor(
  *  associated with the passed in ID into the shader.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
-	std::string textureTag)
+	StringId textureTag)
 {
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
+		m_uniforms.SetInt(g_UseTextureName, true);
 
 		int textureID = -1;
 		textureID = FindTextureSlot(textureTag);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+		m_uniforms.SetInt(g_TextureValueName, textureID);
+	}
+}
+
+/***********************************************************
+ *  SetShaderTextureSlot()
+ *
+ *  This method is used for setting an already resolved
+ *  texture slot into the shader.
+ ***********************************************************/
+void SceneManager::SetShaderTextureSlot(
+	int textureSlot)
+{
+	if (NULL != m_pShaderManager)
+	{
+		m_uniforms.SetInt(g_UseTextureName, true);
+		m_uniforms.SetInt(g_TextureValueName, textureSlot);
 	}
 }
 
@@ -342,7 +788,7 @@ void SceneManager::SetTextureUVScale(float u, float v)
 {
 	if (NULL != m_pShaderManager)
 	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
+		m_uniforms.SetVec2(g_UVScaleName, glm::vec2(u, v));
 	}
 }
 
@@ -353,7 +799,7 @@ void SceneManager::SetTextureUVScale(float u, float v)
  *  into the shader.
  ***********************************************************/
 void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+	StringId materialTag)
 {
 	if (m_objectMaterials.size() > 0)
 	{
@@ -363,13 +809,103 @@ void SceneManager::SetShaderMaterial(
 		bReturn = FindMaterial(materialTag, material);
 		if (bReturn == true)
 		{
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
+			SetShaderMaterial(material);
+		}
+	}
+}
+
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for passing the values of an already
+ *  found material into the shader.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	const OBJECT_MATERIAL& material)
+{
+	if (NULL != m_pShaderManager)
+	{
+		m_uniforms.SetVec3(g_MaterialAmbientColorName, material.ambientColor);
+		m_uniforms.SetFloat(g_MaterialAmbientStrengthName, material.ambientStrength);
+		m_uniforms.SetVec3(g_MaterialDiffuseColorName, material.diffuseColor);
+		m_uniforms.SetVec3(g_MaterialSpecularColorName, material.specularColor);
+		m_uniforms.SetFloat(g_MaterialShininessName, material.shininess);
+	}
+}
+
+/***********************************************************
+ *  RunMicroBenchmarks()
+ *
+ *  This method is used for timing the methods called for
+ *  each drawn object.  The lookups cycle through every
+ *  loaded tag plus one that is missing, which walks the
+ *  whole list, and the transformations change every call.
+ ***********************************************************/
+void SceneManager::RunMicroBenchmarks(MicroBenchmark& benchmark)
+{
+	const char* const BENCHMARK_MATERIALS[] = { "wood", "metal", "glass", "plastic", "stone", "cloth", "rubber", "paper" };
+	std::vector<StringId> textureTags;
+	std::vector<StringId> materialTags;
+	bool bBenchmarkMaterials = m_objectMaterials.empty();
+
+	// a scene without materials gets a typical list for the
+	// duration of the benchmark, so the lookups have work to do
+	if (bBenchmarkMaterials)
+	{
+		for (const char* name : BENCHMARK_MATERIALS)
+		{
+			OBJECT_MATERIAL material;
+			material.ambientStrength = 0.2f;
+			material.ambientColor = glm::vec3(0.3f);
+			material.diffuseColor = glm::vec3(0.6f);
+			material.specularColor = glm::vec3(0.4f);
+			material.shininess = 16.0f;
+			material.tag = StringId(name);
+			m_objectMaterials.push_back(material);
 		}
 	}
+
+	for (int i = 0; i < m_loadedTextures; i++)
+	{
+		textureTags.push_back(m_textureIDs[i].tag);
+	}
+	textureTags.push_back("missing"_id);
+	for (const OBJECT_MATERIAL& material : m_objectMaterials)
+	{
+		materialTags.push_back(material.tag);
+	}
+	materialTags.push_back("missing"_id);
+
+	benchmark.Run("SceneManager::SetTransformations", [&](size_t i)
+	{
+		float angle = (float)(i % 360);
+		SetTransformations(
+			glm::vec3(1.0f + (i % 8) * 0.125f),
+			angle,
+			angle * 0.5f,
+			0.0f,
+			glm::vec3((float)(i % 16), 0.0f, -(float)(i % 32)));
+	});
+	benchmark.Run("SceneManager::FindTextureSlot", [&](size_t i)
+	{
+		benchmark.Consume(FindTextureSlot(textureTags[i % textureTags.size()]));
+	});
+	benchmark.Run("SceneManager::FindMaterial", [&](size_t i)
+	{
+		OBJECT_MATERIAL material;
+		material.shininess = 0.0f;
+		FindMaterial(materialTags[i % materialTags.size()], material);
+		benchmark.Consume(material.shininess);
+	});
+	benchmark.Run("SceneManager::SetShaderMaterial", [&](size_t i)
+	{
+		SetShaderMaterial(materialTags[i % materialTags.size()]);
+	});
+
+	if (bBenchmarkMaterials)
+	{
+		m_objectMaterials.clear();
+	}
 }
 
 /**************************************************************/
@@ -392,134 +928,1178 @@ void SceneManager::PrepareScene()
 	
 	
 	LoadSceneTextures();
+	LoadShaderInputs();
 	// only one instance of a particular mesh needs to be
 	// loaded in memory no matter how many times it is drawn
 	// in the rendered 3D scene
 	//Added necessary shape meshes for objects needed
-	m_basicMeshes = new ShapeMeshes();
 	m_basicMeshes->LoadBoxMesh();
 	m_basicMeshes->LoadPlaneMesh();
 	m_basicMeshes->LoadSphereMesh();
 	m_basicMeshes->LoadCylinderMesh();
-	m_basicMeshes->LoadPlaneMesh();
+
+	// coarser levels of the parametric shapes for distant objects
+	m_lodMeshes = new ParametricMeshes();
+	m_lodMeshes->LoadSphereLods(g_LodVertexFormat);
+	m_lodMeshes->LoadCylinderLods(g_LodVertexFormat);
+
+	DefineSceneObjects();
+	BuildStaticBatches();
 }
 
 /***********************************************************
- *  RenderScene()
+ *  LoadShaderInputs()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for looking up the locations of the
+ *  per-draw uniforms in the active shader program, and for
+ *  checking whether it declares the instance block and the
+ *  baked lighting switch.
  ***********************************************************/
-void SceneManager::RenderScene()
+void SceneManager::LoadShaderInputs()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
+	m_uniforms.Load(g_DrawUniformNames, sizeof(g_DrawUniformNames) / sizeof(g_DrawUniformNames[0]));
+
+	// check whether the active shader can read the per-instance data
+	// streamed through the instance ring buffer
+	GLint programID = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+	m_bInstanceBlockSupported = (programID != 0) &&
+		(glGetProgramResourceIndex(programID, GL_SHADER_STORAGE_BLOCK, g_InstanceBlockName) != GL_INVALID_INDEX);
+	if (m_bInstanceBlockSupported)
+	{
+		glShaderStorageBlockBinding(programID,
+			glGetProgramResourceIndex(programID, GL_SHADER_STORAGE_BLOCK, g_InstanceBlockName),
+			g_InstanceBlockBinding);
+	}
 
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	// set the XYZ scale for the mesh
+	// the point light is only baked into the static batches when
+	// the shader reads the baked vertex colors, otherwise it stays
+	// lit per fragment like the other objects
+	m_bBakedLightingSupported = (m_uniforms.GetLocation(g_UseBakedLightingName) != -1);
+	if (m_bBakedLightingSupported == false)
+	{
+		std::cout << "INFO: Shader has no baked lighting input, the point light stays dynamic" << std::endl;
+	}
+}
 
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
+/***********************************************************
+ *  ReloadShaderInputs()
+ *
+ *  This method is used for looking up the shader inputs of
+ *  a relinked program.  The static batches stay as they are,
+ *  so a batch baked for an earlier program is lit per
+ *  fragment when the new one has no baked lighting switch,
+ *  and a program that gains it only gets baked batches once
+ *  the scene is prepared again.
+ ***********************************************************/
+bool SceneManager::ReloadShaderInputs()
+{
+	bool bInstanceBlockSupported = m_bInstanceBlockSupported;
 
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
+	LoadShaderInputs();
+	// the driver finishes a new program on its first draws, so the
+	// warm up frames start over before allocations are checked
+	m_renderedFrames = 0;
 
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+	return(m_bInstanceBlockSupported == bInstanceBlockSupported);
+}
 
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+/***********************************************************
+ *  BuildStaticBatches()
+ *
+ *  This method is used for merging the static objects into
+ *  batches drawn with one call each.  Objects only share a
+ *  batch when they use the same texture, material and, when
+ *  untextured, color, since those are set per draw.  Their
+ *  vertices are transformed to world space with the UV scale
+ *  applied, and each object keeps its range of indices and
+ *  world bounds so it is still culled on its own.  When the
+ *  shader takes baked lighting, every static object is
+ *  batched, even alone, so the point light can be baked into
+ *  its world space vertices, and the faces of boxes and
+ *  planes are split finely enough for the vertices to hold
+ *  the falloff of the light.
+ ***********************************************************/
+void SceneManager::BuildStaticBatches()
+{
+	DestroyStaticBatches();
+	m_objectBatches.assign(m_sceneObjects.size(), -1);
+
+	size_t minimumObjects = m_bBakedLightingSupported ? 1 : g_MinimumStaticBatchObjects;
+	size_t bakedBatches = 0;
+	double bakeSeconds = 0.0;
+	if (m_bBakedLightingSupported)
+	{
+		m_pLightBaker->LoadCache();
+	}
+
+	// group the static objects by their appearance
+	std::vector<std::vector<size_t>> groups;
+	for (size_t index = 0; index < m_sceneObjects.size(); index++)
+	{
+		const SCENE_OBJECT& object = m_sceneObjects[index];
+		if (object.bStatic == false)
+		{
+			continue;
+		}
+
+		size_t group = 0;
+		for (; group < groups.size(); group++)
+		{
+			const SCENE_OBJECT& first = m_sceneObjects[groups[group][0]];
+			if ((first.textureTag == object.textureTag) &&
+				(first.materialTag == object.materialTag) &&
+				((object.textureTag.IsEmpty() == false) || (first.color == object.color)))
+			{
+				break;
+			}
+		}
+		if (group == groups.size())
+		{
+			groups.push_back(std::vector<size_t>());
+		}
+		groups[group].push_back(index);
+	}
+
+	// each basic shape is generated and optimized once, and each
+	// split of a box or plane the baking asks for once more
+	ParametricMeshes::MESH_DATA shapeMeshes[4];
+	for (int shape = 0; shape < 4; shape++)
+	{
+		BuildShapeMesh((ShapeType)shape, shapeMeshes[shape]);
+		MeshOptimizer::OptimizeMesh(shapeMeshes[shape]);
+	}
+	std::unordered_map<uint64_t, ParametricMeshes::MESH_DATA> splitMeshes;
+	float vertexSpacing = StaticLightBaker::GetVertexSpacing(ViewManager::GetScenePointLight());
+
+	size_t mergedObjects = 0;
+	for (const std::vector<size_t>& group : groups)
+	{
+		if (group.size() < minimumObjects)
+		{
+			continue;
+		}
+
+		const SCENE_OBJECT& first = m_sceneObjects[group[0]];
+		STATIC_BATCH batch;
+		ParametricMeshes::MESH_DATA merged;
+
+		batch.textureSlot = first.textureTag.IsEmpty() ? -1 : FindTextureSlot(first.textureTag);
+		batch.materialIndex = first.materialTag.IsEmpty() ? -1 : FindMaterialIndex(first.materialTag);
+		batch.color = first.color;
+		batch.bBakedLight = m_bBakedLightingSupported;
+
+		for (size_t index : group)
+		{
+			const SCENE_OBJECT& object = m_sceneObjects[index];
+			const ParametricMeshes::MESH_DATA* pShapeMesh = &shapeMeshes[(int)object.shape];
+			glm::ivec3 cells = batch.bBakedLight ? GetBakeCells(object, vertexSpacing) : glm::ivec3(1);
+			if (cells != glm::ivec3(1))
+			{
+				uint64_t key = ((uint64_t)object.shape << 48) | ((uint64_t)cells.x << 32) | ((uint64_t)cells.y << 16) | (uint64_t)cells.z;
+				auto found = splitMeshes.find(key);
+				if (found == splitMeshes.end())
+				{
+					found = splitMeshes.emplace(key, ParametricMeshes::MESH_DATA()).first;
+					BuildShapeMesh(object.shape, found->second, cells);
+					MeshOptimizer::OptimizeMesh(found->second);
+				}
+				pShapeMesh = &found->second;
+			}
+			const ParametricMeshes::MESH_DATA& shapeMesh = *pShapeMesh;
+			glm::mat4 model = BuildModelMatrix(
+				object.scaleXYZ,
+				object.XrotationDegrees,
+				object.YrotationDegrees,
+				object.ZrotationDegrees,
+				object.positionXYZ);
+			glm::mat3 normalMatrix = glm::transpose(glm::inverse(glm::mat3(model)));
+			GLuint firstVertex = (GLuint)merged.vertices.size();
+			STATIC_RANGE range;
+
+			range.objectIndex = index;
+			range.worldBounds = TransformBoundingBox(GetShapeBounds(object.shape), model);
+			range.firstIndex = (GLsizei)merged.indices.size();
+			range.indexCount = (GLsizei)shapeMesh.indices.size();
+
+			for (const ParametricMeshes::MESH_VERTEX& vertex : shapeMesh.vertices)
+			{
+				ParametricMeshes::MESH_VERTEX worldVertex;
+				worldVertex.position = glm::vec3(model * glm::vec4(vertex.position, 1.0f));
+				worldVertex.normal = glm::normalize(normalMatrix * vertex.normal);
+				worldVertex.textureCoordinate = vertex.textureCoordinate * object.UVscale;
+				merged.vertices.push_back(worldVertex);
+			}
+			for (GLuint shapeIndex : shapeMesh.indices)
+			{
+				merged.indices.push_back(firstVertex + shapeIndex);
+			}
+
+			batch.ranges.push_back(range);
+			m_objectBatches[index] = (int)m_staticBatches.size();
+		}
+
+		if (batch.bBakedLight)
+		{
+			auto bakeStart = std::chrono::steady_clock::now();
+			if (m_pLightBaker->BakeVertices(ViewManager::GetScenePointLight(), merged.vertices, m_pJobSystem, merged.bakedLight) == false)
+			{
+				bakedBatches++;
+			}
+			bakeSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - bakeStart).count();
+		}
+
+		ParametricMeshes::UploadMesh(merged, g_StaticVertexFormat, "Static batch", batch.mesh);
+		m_staticBatches.push_back(batch);
+		mergedObjects += group.size();
+	}
 
-	SetShaderColor(1, 1, 1, 1);
+	std::cout << "INFO: Static batches: " << m_staticBatches.size() << " merging "
+		<< mergedObjects << " of " << m_sceneObjects.size() << " objects" << std::endl;
 
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
+	if (m_bBakedLightingSupported)
+	{
+		std::cout << "INFO: Static lighting: " << bakedBatches << " batches baked, "
+			<< (m_staticBatches.size() - bakedBatches) << " read from cache in "
+			<< bakeSeconds * 1000.0 << " ms" << std::endl;
+		m_pLightBaker->SaveCache();
+	}
+}
+
+/***********************************************************
+ *  DestroyStaticBatches()
+ *
+ *  This method is used for freeing the merged static batches.
+ ***********************************************************/
+void SceneManager::DestroyStaticBatches()
+{
+	for (STATIC_BATCH& batch : m_staticBatches)
+	{
+		ParametricMeshes::DeleteMesh(batch.mesh);
+	}
+	m_staticBatches.clear();
+	m_objectBatches.assign(m_sceneObjects.size(), -1);
+}
+
+/***********************************************************
+ *  IsInstanceBlockSupported()
+ *
+ *  This method is used for checking whether the loaded
+ *  shader declares the instance block.
+ ***********************************************************/
+bool SceneManager::IsInstanceBlockSupported() const
+{
+	return(m_bInstanceBlockSupported);
+}
+
+/***********************************************************
+ *  DefineSceneObjects()
+ *
+ *  This method is used for defining the objects of the 3D
+ *  scene once, so each frame only needs to update, cull and
+ *  draw them
+ ***********************************************************/
+void SceneManager::DefineSceneObjects()
+{
+	SCENE_OBJECT object;
+
+	m_sceneObjects.clear();
+	m_objectLods.clear();
+	m_objectBatches.clear();
+	m_objectBounds.clear();
+	m_pSpatialIndex->Clear();
+	m_pAnimation->Clear();
+
+	// only the reactor moves once it is placed
+	object.bStatic = true;
+
+	/*** Set the transformations and the color or texture of ***/
+	/*** each object before adding it to the scene.  This    ***/
+	/*** same ordering of code should be used for all the    ***/
+	/*** basic 3D shapes.                                    ***/
+	/***********************************************************/
+	object.shape = ShapeType::Plane;
+	// set the XYZ scale for the mesh
+	object.scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
+	// set the XYZ rotation for the mesh
+	object.XrotationDegrees = 0.0f;
+	object.YrotationDegrees = 0.0f;
+	object.ZrotationDegrees = 0.0f;
+	// set the XYZ position for the mesh
+	object.positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+	object.color = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
+	object.textureTag = "";
+	object.UVscale = glm::vec2(1.0f, 1.0f);
+	object.materialTag = "";
+	AddSceneObject(object);
 
 	//Chris K Code begins
 
 	//Placard Base
-	scaleXYZ = glm::vec3(2.0f, 0.3f, 1.0f); //Positioned low and wide to simulate placement
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-	positionXYZ = glm::vec3(0.0f, 0.5f, -1.0f); //Slightly lifted from floor plane
-
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderTexture("darkwood"); //replaced color with texture model
-	SetTextureUVScale(2.0f, 2.0f); //tiling
-	SetTransformations(glm::vec3(1.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.0f));
-	m_basicMeshes->DrawBoxMesh();
+	object.shape = ShapeType::Box;
+	object.scaleXYZ = glm::vec3(1.0f); //drawn with the unit transform that followed the texture setup
+	object.positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
+	object.textureTag = "darkwood"; //replaced color with texture model
+	object.UVscale = glm::vec2(2.0f, 2.0f); //tiling
+	AddSceneObject(object);
 
 	//Display back panel
-	scaleXYZ = glm::vec3(2.0f, 2.0f, 0.1f); // Tall and thin
-	positionXYZ = glm::vec3(0.0f, 1.4f, -0.2f); // Rises up from the base
-	SetShaderTexture("backplate");
-	SetTextureUVScale(2.0f, 2.0f); //tiling
-	SetTransformations(glm::vec3(1.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 2.0f));
-	//SetShaderColor(0.7f, 0.7f, 0.7f, 1.0f); // Light gray color values
-
-	m_basicMeshes->DrawBoxMesh();
+	object.scaleXYZ = glm::vec3(1.0f);
+	object.positionXYZ = glm::vec3(0.0f, 0.0f, 2.0f);
+	object.textureTag = "backplate";
+	AddSceneObject(object);
 
 	//Placard display name plate
-	scaleXYZ = glm::vec3(1.2f, 0.3f, 0.05f); // Thin and centered
-	positionXYZ = glm::vec3(0.0f, 1.0f, -0.1f); // On the front face of base
+	object.scaleXYZ = glm::vec3(1.2f, 0.3f, 0.05f); // Thin and centered
+	object.positionXYZ = glm::vec3(0.0f, 1.0f, -0.1f); // On the front face of base
+	object.color = glm::vec4(1.0f, 0.0f, 0.0f, 1.0f); //Chose red to simulate difference from base
+	object.textureTag = "";
+	AddSceneObject(object);
+
+	object.shape = ShapeType::Cylinder;
+	object.scaleXYZ = glm::vec3(1.2f, 0.1f, 1.2f);
+	object.positionXYZ = glm::vec3(1.1f, 0.1f, 1.8f);
+	object.color = glm::vec4(0.36f, 0.25f, 0.2f, 1.0f); //Brown tone for base of reactor stand
+	AddSceneObject(object);
+
+	// the reactor ring and its cap turn opposite ways, and the
+	// plasma core pulses in size and brightness
+	object.bStatic = false;
+
+	object.scaleXYZ = glm::vec3(1.0f, 0.15f, 1.0f);
+	object.positionXYZ = glm::vec3(1.1f, 0.2f, 1.8f);
+	object.textureTag = "reactor_tex";
+	AddSceneObject(object);
+	const AnimationSystem::KEYFRAME ringSpin[] = {
+		{ 0.0f, glm::vec4(0.0f, 0.0f, 0.0f, 0.0f) },
+		{ 8.0f, glm::vec4(0.0f, 360.0f, 0.0f, 0.0f) } };
+	AddAnimationTrack(m_sceneObjects.size() - 1, AnimationChannel::Rotation, ringSpin, 2, true);
+
+	object.scaleXYZ = glm::vec3(0.7f, 0.2f, 0.7f);
+	object.positionXYZ = glm::vec3(1.1f, 0.3f, 1.8f);
+	object.color = glm::vec4(0.3f, 0.3f, 0.3f, 1.0f); //Dark gray metal
+	object.textureTag = "";
+	AddSceneObject(object);
+	const AnimationSystem::KEYFRAME capSpin[] = {
+		{ 0.0f, glm::vec4(0.0f, 0.0f, 0.0f, 0.0f) },
+		{ 12.0f, glm::vec4(0.0f, -360.0f, 0.0f, 0.0f) } };
+	AddAnimationTrack(m_sceneObjects.size() - 1, AnimationChannel::Rotation, capSpin, 2, true);
+
+	object.shape = ShapeType::Sphere; //Plasma core for reactor energy
+	object.scaleXYZ = glm::vec3(0.35f, 0.35f, 0.35f);
+	object.positionXYZ = glm::vec3(1.1f, 0.5f, 1.8f);
+	object.color = glm::vec4(0.0f, 0.8f, 1.0f, 1.0f); //Arc blue glow
+	AddSceneObject(object);
+	const AnimationSystem::KEYFRAME corePulse[] = {
+		{ 0.0f, glm::vec4(0.35f, 0.35f, 0.35f, 0.0f) },
+		{ 0.75f, glm::vec4(0.4f, 0.4f, 0.4f, 0.0f) },
+		{ 1.5f, glm::vec4(0.35f, 0.35f, 0.35f, 0.0f) } };
+	const AnimationSystem::KEYFRAME coreGlow[] = {
+		{ 0.0f, glm::vec4(0.0f, 0.8f, 1.0f, 1.0f) },
+		{ 0.75f, glm::vec4(0.5f, 0.95f, 1.0f, 1.0f) },
+		{ 1.5f, glm::vec4(0.0f, 0.8f, 1.0f, 1.0f) } };
+	AddAnimationTrack(m_sceneObjects.size() - 1, AnimationChannel::Scale, corePulse, 3, true);
+	AddAnimationTrack(m_sceneObjects.size() - 1, AnimationChannel::Color, coreGlow, 3, true);
+
+	object.bStatic = true;
+
+	object.scaleXYZ = glm::vec3(0.3f, 0.25f, 0.3f); //Red helmet dome (top part of the helmet)
+	object.positionXYZ = glm::vec3(1.6f, 0.45f, 0.4f);
+	object.color = glm::vec4(0.8f, 0.0f, 0.0f, 1.0f);  //Iron Man red
+	AddSceneObject(object);
+
+	object.shape = ShapeType::Box;
+	object.scaleXYZ = glm::vec3(0.2f, 0.25f, 0.01f); //Gold faceplate (front panel)
+	object.positionXYZ = glm::vec3(1.6f, 0.46f, 0.69f);
+	object.color = glm::vec4(0.83f, 0.69f, 0.22f, 1.0f);  //Gold tone
+	AddSceneObject(object);
+
+	object.scaleXYZ = glm::vec3(0.05f, 0.2f, 0.2f); //Side panels (helmet sides using box)
+	object.positionXYZ = glm::vec3(1.8f, 0.46f, 0.4f);
+	object.color = glm::vec4(0.8f, 0.0f, 0.0f, 1.0f);  //Red color
+	AddSceneObject(object);
+
+	object.positionXYZ = glm::vec3(1.4f, 0.46f, 0.4f);
+	AddSceneObject(object);
+
+	object.shape = ShapeType::Cylinder; //Chin/jaw guard using cylinder segment
+	object.scaleXYZ = glm::vec3(0.2f, 0.05f, 0.2f);
+	object.XrotationDegrees = 90.0f;
+	object.positionXYZ = glm::vec3(1.65f, 0.3f, 0.55f);
+	object.color = glm::vec4(0.2f, 0.2f, 0.2f, 1.0f);  //Metallic gray color
+	AddSceneObject(object);
+}
 
-	SetTransformations(scaleXYZ, XrotationDegrees, YrotationDegrees, ZrotationDegrees, positionXYZ);
-	SetShaderColor(1.0f, 0.0f, 0.0f, 1.0f); //Chose red to simulate difference from base
-	m_basicMeshes->DrawBoxMesh();
+/***********************************************************
+ *  AddSceneObject()
+ *
+ *  This method is used for adding an object to the 3D scene.
+ ***********************************************************/
+void SceneManager::AddSceneObject(const SCENE_OBJECT& object)
+{
+	BOUNDING_BOX bounds = GetObjectBounds(object);
 
-	SetTransformations(glm::vec3(1.2f, 0.1f, 1.2f), 0.0f, 0.0f, 0.0f, glm::vec3(1.1f, 0.1f, 1.8f));
-	SetShaderColor(0.36f, 0.25f, 0.2f, 1.0f); //Brown tone for base of reactor stand
-	m_basicMeshes->DrawCylinderMesh();
+	m_pSpatialIndex->Insert((uint32_t)m_sceneObjects.size(), bounds);
+	m_objectBounds.push_back(bounds);
+	m_sceneObjects.push_back(object);
+	m_objectLods.push_back(0);
+	m_objectBatches.push_back(-1);
+}
 
-	SetTransformations(
-		glm::vec3(1.0f, 0.15f, 1.0f), 0.0f, 0.0f, 0.0f, glm::vec3(1.1f, 0.2f, 1.8f));
-	SetShaderTexture("reactor_tex");   
-	m_basicMeshes->DrawCylinderMesh();
+/***********************************************************
+ *  AddAnimationTrack()
+ *
+ *  This method is used for animating one channel of a scene
+ *  object with keyframes.  Static objects are merged into
+ *  batches and never move, so they cannot be animated.
+ ***********************************************************/
+int SceneManager::AddAnimationTrack(
+	size_t index,
+	AnimationChannel channel,
+	const AnimationSystem::KEYFRAME* pKeys,
+	size_t keyCount,
+	bool bLoop)
+{
+	if ((index >= m_sceneObjects.size()) || m_sceneObjects[index].bStatic)
+	{
+		std::cerr << "ERROR: Scene object " << index << " is not a dynamic object and cannot be animated" << std::endl;
+		return(-1);
+	}
 
-	SetTransformations(glm::vec3(0.7f, 0.2f, 0.7f), 0.0f, 0.0f, 0.0f, glm::vec3(1.1f, 0.3f, 1.8f));
-	SetShaderColor(0.3f, 0.3f, 0.3f, 1.0f); //Dark gray metal
-	m_basicMeshes->DrawCylinderMesh();
+	return(m_pAnimation->AddTrack((uint32_t)index, channel, pKeys, keyCount, bLoop));
+}
 
-	SetTransformations(glm::vec3(0.35f, 0.35f, 0.35f),0.0f, 0.0f, 0.0f,glm::vec3(1.1f, 0.5f, 1.8f));
-	SetShaderColor(0.0f, 0.8f, 1.0f, 1.0f); //Arc blue glow
-	m_basicMeshes->DrawSphereMesh(); //Plasma core for reactor energy
+/***********************************************************
+ *  UpdateAnimations()
+ *
+ *  This method is used for playing the animation tracks.
+ *  All tracks are evaluated together, then the poses are
+ *  written into their objects and the new bounds computed,
+ *  spread over the job system, and only the animated objects
+ *  are moved in the spatial index - the rest of the scene is
+ *  not touched.
+ ***********************************************************/
+bool SceneManager::UpdateAnimations(double seconds)
+{
+	if (m_pAnimation->GetTrackCount() == 0)
+	{
+		return(false);
+	}
 
-	
-	SetTransformations(glm::vec3(0.3f, 0.25f, 0.3f), 0.0f, 0.0f, 0.0f, glm::vec3(1.6f, 0.45f, 0.4f)); //Red helmet dome (top part of the helmet)
-	SetShaderColor(0.8f, 0.0f, 0.0f, 1.0f);  //Iron Man red
-	m_basicMeshes->DrawSphereMesh();
+	m_pAnimation->Evaluate(seconds, m_pJobSystem);
 
-	
-	SetTransformations(glm::vec3(0.2f, 0.25f, 0.01f), 0.0f, 0.0f, 0.0f, glm::vec3(1.6f, 0.46f, 0.69f)); //Gold faceplate (front panel)
-	SetShaderColor(0.83f, 0.69f, 0.22f, 1.0f);  //Gold tone
-	m_basicMeshes->DrawBoxMesh();
+	const std::vector<AnimationSystem::OBJECT_POSE>& poses = m_pAnimation->GetPoses();
+	auto applyRange = [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			const AnimationSystem::OBJECT_POSE& pose = poses[i];
+			SCENE_OBJECT& object = m_sceneObjects[pose.objectIndex];
+
+			if (pose.bChannels[(int)AnimationChannel::Translation])
+			{
+				object.positionXYZ = glm::vec3(pose.values[(int)AnimationChannel::Translation]);
+			}
+			if (pose.bChannels[(int)AnimationChannel::Rotation])
+			{
+				object.XrotationDegrees = pose.values[(int)AnimationChannel::Rotation].x;
+				object.YrotationDegrees = pose.values[(int)AnimationChannel::Rotation].y;
+				object.ZrotationDegrees = pose.values[(int)AnimationChannel::Rotation].z;
+			}
+			if (pose.bChannels[(int)AnimationChannel::Scale])
+			{
+				object.scaleXYZ = glm::vec3(pose.values[(int)AnimationChannel::Scale]);
+			}
+			if (pose.bChannels[(int)AnimationChannel::Color])
+			{
+				object.color = pose.values[(int)AnimationChannel::Color];
+			}
+
+			m_objectBounds[pose.objectIndex] = GetObjectBounds(object);
+		}
+	};
 
-	
-	SetTransformations(glm::vec3(0.05f, 0.2f, 0.2f), 0.0f, 0.0f, 0.0f, glm::vec3(1.8f, 0.46f, 0.4f)); //Side panels (helmet sides using box)
-	SetShaderColor(0.8f, 0.0f, 0.0f, 1.0f);  //Red color
-	m_basicMeshes->DrawBoxMesh();
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor(poses.size(), g_AnimatedObjectGrainSize, applyRange);
+	}
+	else
+	{
+		applyRange(0, poses.size());
+	}
 
-	SetTransformations(glm::vec3(0.05f, 0.2f, 0.2f), 0.0f, 0.0f, 0.0f, glm::vec3(1.4f, 0.46f, 0.4f));
-	SetShaderColor(0.8f, 0.0f, 0.0f, 1.0f);  //Red color
-	m_basicMeshes->DrawBoxMesh();
+	for (const AnimationSystem::OBJECT_POSE& pose : poses)
+	{
+		m_pSpatialIndex->Update(pose.objectIndex, m_objectBounds[pose.objectIndex]);
+	}
+	m_bPickingBoundsMoved = true;
 
-	
-	SetTransformations(glm::vec3(0.2f, 0.05f, 0.2f), 90.0f, 0.0f, 0.0f, glm::vec3(1.65f, 0.3f, 0.55f)); //Chin/jaw guard using cylinder segment
-	SetShaderColor(0.2f, 0.2f, 0.2f, 1.0f);  //Metallic gray color
-	m_basicMeshes->DrawCylinderMesh();
+	return(true);
+}
 
+/***********************************************************
+ *  MoveSceneObject()
+ *
+ *  This method is used for setting the transformation values
+ *  of a dynamic scene object and moving it in the spatial
+ *  index.  Static objects may be merged into a batch, so they
+ *  are left where they are.
+ ***********************************************************/
+void SceneManager::MoveSceneObject(
+	size_t index,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	if ((index >= m_sceneObjects.size()) || m_sceneObjects[index].bStatic)
+	{
+		return;
+	}
+
+	SCENE_OBJECT& object = m_sceneObjects[index];
+	object.scaleXYZ = scaleXYZ;
+	object.XrotationDegrees = XrotationDegrees;
+	object.YrotationDegrees = YrotationDegrees;
+	object.ZrotationDegrees = ZrotationDegrees;
+	object.positionXYZ = positionXYZ;
+
+	m_objectBounds[index] = GetObjectBounds(object);
+	m_pSpatialIndex->Update((uint32_t)index, m_objectBounds[index]);
+	m_bPickingBoundsMoved = true;
+}
+
+/***********************************************************
+ *  GetSpatialIndex()
+ *
+ *  This method is used for getting the spatial index over
+ *  the world bounds of the scene objects.
+ ***********************************************************/
+const LooseOctree& SceneManager::GetSpatialIndex() const
+{
+	return(*m_pSpatialIndex);
+}
+
+/***********************************************************
+ *  PickObject()
+ *
+ *  This method is used for finding the closest scene object
+ *  under a point of the view.  The point is unprojected to a
+ *  ray from the near plane to the far plane, the bounding
+ *  volume hierarchy narrows the objects down to the few whose
+ *  bounds the ray passes through, and the exact surface of
+ *  those decides the hit.  The hierarchy is rebuilt when the
+ *  number of objects changed, and refit when they only moved.
+ ***********************************************************/
+bool SceneManager::PickObject(
+	const VIEW_STATE& viewState,
+	float ndcX,
+	float ndcY,
+	PICK_RESULT& result)
+{
+	auto start = std::chrono::steady_clock::now();
+
+	result.objectIndex = -1;
+	result.distance = 0.0f;
+	result.positionXYZ = glm::vec3(0.0f);
+
+	if (m_pPickingHierarchy->GetObjectCount() != m_objectBounds.size())
+	{
+		m_pPickingHierarchy->Build(m_objectBounds.data(), m_objectBounds.size());
+		m_bPickingBoundsMoved = false;
+	}
+	else if (m_bPickingBoundsMoved)
+	{
+		m_pPickingHierarchy->Refit(m_objectBounds.data());
+		m_bPickingBoundsMoved = false;
+	}
+
+	// the point on the near and the far plane
+	glm::mat4 inverseViewProjection = glm::inverse(viewState.projection * viewState.view);
+	glm::vec4 nearPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, -1.0f, 1.0f);
+	glm::vec4 farPoint = inverseViewProjection * glm::vec4(ndcX, ndcY, 1.0f, 1.0f);
+	glm::vec3 origin = glm::vec3(nearPoint) / nearPoint.w;
+	glm::vec3 direction = (glm::vec3(farPoint) / farPoint.w) - origin;
+	float maxDistance = glm::length(direction);
+
+	if (maxDistance > 0.0f)
+	{
+		direction = direction / maxDistance;
+
+		float distance = 0.0f;
+		int objectIndex = m_pPickingHierarchy->IntersectRay(origin, direction, maxDistance,
+			[&](uint32_t index, float closestDistance, float& hitDistance)
+			{
+				return(IntersectRayObject(index, origin, direction, closestDistance, hitDistance));
+			},
+			distance);
+
+		if (objectIndex >= 0)
+		{
+			result.objectIndex = objectIndex;
+			result.distance = distance;
+			result.positionXYZ = origin + (direction * distance);
+		}
+	}
+
+	result.microseconds = std::chrono::duration<double, std::micro>(
+		std::chrono::steady_clock::now() - start).count();
+
+	return(result.objectIndex >= 0);
+}
+
+/***********************************************************
+ *  SetTextureBudget()
+ *
+ *  This method is used for setting the GPU memory the
+ *  streamed textures may use.
+ ***********************************************************/
+void SceneManager::SetTextureBudget(size_t budgetBytes)
+{
+	m_pTextureStreamer->SetBudget(budgetBytes);
+}
+
+/***********************************************************
+ *  UpdateTextureStreaming()
+ *
+ *  This method is used for uploading the texture levels the
+ *  streamer finished loading and starting the loads and
+ *  evictions the last draw lists call for.
+ ***********************************************************/
+void SceneManager::UpdateTextureStreaming()
+{
+	m_pTextureStreamer->Update();
+}
+
+/***********************************************************
+ *  IsStreamingTextures()
+ *
+ *  This method is used for telling whether the streamer is
+ *  still loading levels the draw lists asked for.
+ ***********************************************************/
+bool SceneManager::IsStreamingTextures() const
+{
+	return(m_pTextureStreamer->IsLoading());
+}
+
+/***********************************************************
+ *  GetTextureFilenames()
+ *
+ *  This method is used for getting the image files of the
+ *  loaded textures, so they can be watched for edits.
+ ***********************************************************/
+void SceneManager::GetTextureFilenames(std::vector<std::string>& filenames) const
+{
+	filenames.clear();
+	for (int i = 0; i < m_pTextureStreamer->GetTextureCount(); i++)
+	{
+		filenames.push_back(m_pTextureStreamer->GetFilename(i));
+	}
+}
+
+/***********************************************************
+ *  ReloadTexture()
+ *
+ *  This method is used for loading an edited image file into
+ *  the texture made from it.  The texture keeps its ID and
+ *  slot, so the scene objects using it need no change, and
+ *  the old image stays when the new one cannot be read.
+ ***********************************************************/
+bool SceneManager::ReloadTexture(const char* filename)
+{
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+
+	int textureIndex = m_pTextureStreamer->FindTexture(filename);
+	if (textureIndex < 0)
+	{
+		return(false);
+	}
+
+	stbi_set_flip_vertically_on_load(true);
+	unsigned char* image = stbi_load(
+		filename,
+		&width,
+		&height,
+		&colorChannels,
+		0);
+	if (NULL == image)
+	{
+		std::cerr << "ERROR: Could not reload image:" << filename << std::endl;
+		return(false);
+	}
+
+	bool bReloaded = m_pTextureStreamer->ReloadTexture(textureIndex, image, width, height, colorChannels);
+	stbi_image_free(image);
+	if (bReloaded == false)
+	{
+		std::cerr << "ERROR: Could not reload image:" << filename << std::endl;
+		return(false);
+	}
+
+	std::cout << "INFO: Reloaded texture " << filename << ", width:" << width
+		<< ", height:" << height << ", channels:" << colorChannels << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  SetJobSystem()
+ *
+ *  This method is used for setting the job system used to
+ *  build the draw lists in parallel.
+ ***********************************************************/
+void SceneManager::SetJobSystem(JobSystem* pJobSystem)
+{
+	m_pJobSystem = pJobSystem;
+}
+
+/***********************************************************
+ *  BuildDrawList()
+ *
+ *  This method is used for building the draw list of a
+ *  single view, which is a view set of one.
+ ***********************************************************/
+size_t SceneManager::BuildDrawList(
+	const VIEW_STATE& viewState,
+	FrameArena& frameArena,
+	DRAW_LIST& drawList,
+	INSTANCE_DATA* pInstances,
+	size_t maxInstances) const
+{
+	return(BuildDrawLists(&viewState, 1, frameArena, &drawList, pInstances, maxInstances));
+}
+
+/***********************************************************
+ *  BuildDrawLists()
+ *
+ *  This method is used for updating the transformations of
+ *  the scene objects, culling them against the view frustums
+ *  and sorting the visible ones to minimize state changes.
+ *  It does not call OpenGL, so it runs on the scene update
+ *  thread while the previous frame is being submitted.  One
+ *  walk of the spatial index culls the objects against every
+ *  view, giving each visible object a mask of the views it
+ *  is in, and the visible ones are split into ranges handled
+ *  by the job system.  Each object is updated and its
+ *  per-instance data written once, however many views see
+ *  it, and each range appends its draws to a shared list by
+ *  reserving space with one atomic add.  Spheres and
+ *  cylinders get a level of detail from their largest
+ *  projected size over the views.  The sort keys of the
+ *  shared list do not depend on the view, so it is sorted
+ *  once, and each view, in parallel, copies out the draws in
+ *  its mask in that order.  The objects of the static
+ *  batches are culled one by one per view, and each run of
+ *  visible neighbours in a batch becomes a single draw,
+ *  merged into the view's list by its sort key.  The draw
+ *  lists are taken from the frame arena, so building a frame
+ *  does not touch the heap.
+ ***********************************************************/
+size_t SceneManager::BuildDrawLists(
+	const VIEW_STATE* pViews,
+	size_t viewCount,
+	FrameArena& frameArena,
+	DRAW_LIST* pDrawLists,
+	INSTANCE_DATA* pInstances,
+	size_t maxInstances) const
+{
+	const int MAX_VIEWS = LooseOctree::MAX_QUERY_FRUSTUMS;
+	glm::mat4 viewProjections[MAX_VIEWS];
+	FRUSTUM frustums[MAX_VIEWS];
+	// pixels per world unit at a clip space w of 1
+	float pixelsPerUnit[MAX_VIEWS];
+	// static batch runs of each view, before they are merged
+	DRAW_COMMAND* pViewRuns[MAX_VIEWS];
+	std::atomic<size_t> drawCount(0);
+
+	// position of a draw of the shared list in sorted order
+	struct SORT_ENTRY
+	{
+		uint64_t sortKey;
+		uint32_t command;
+	};
+
+	size_t staticRangeCount = 0;
+	for (const STATIC_BATCH& batch : m_staticBatches)
+	{
+		staticRangeCount += batch.ranges.size();
+	}
+
+	// the views share one walk of the spatial index
+	viewCount = std::min(viewCount, (size_t)MAX_VIEWS);
+	for (size_t view = 0; view < viewCount; view++)
+	{
+		viewProjections[view] = pViews[view].projection * pViews[view].view;
+		frustums[view] = ExtractFrustum(viewProjections[view]);
+		pixelsPerUnit[view] = pViews[view].projection[1][1] * pViews[view].viewportHeight * 0.5f;
+
+		// every object adds at most one draw, alone or in a run of a batch
+		pDrawLists[view].pCommands = frameArena.AllocateArray<DRAW_COMMAND>(m_sceneObjects.size());
+		pDrawLists[view].count = 0;
+		pViewRuns[view] = frameArena.AllocateArray<DRAW_COMMAND>(staticRangeCount);
+	}
+
+	// the static batches take the first instance slots, one per batch
+	// shared by all of its runs in every view, and the objects the
+	// next ones - objects past the end of the region fall back to
+	// the uniforms
+	size_t instanceLimit = (NULL != pInstances) ? maxInstances : 0;
+	std::atomic<size_t> instanceCount(m_staticBatches.size());
+
+	auto writeInstance = [&](size_t slot, const glm::mat4& model, const glm::vec4& color, const glm::vec2& UVscale, int textureSlot)
+	{
+		INSTANCE_DATA& instance = pInstances[slot];
+
+		instance.model = model;
+		instance.color = color;
+		instance.UVscaleAndTexture = glm::vec4(
+			UVscale.x,
+			UVscale.y,
+			(textureSlot >= 0) ? 1.0f : 0.0f,
+			0.0f);
+	};
+
+	for (size_t batchIndex = 0; (batchIndex < m_staticBatches.size()) && (batchIndex < instanceLimit); batchIndex++)
+	{
+		const STATIC_BATCH& batch = m_staticBatches[batchIndex];
+		writeInstance(batchIndex, batch.mesh.dequantize, batch.color, glm::vec2(1.0f, 1.0f), batch.textureSlot);
+	}
+
+	// only the objects the spatial index finds in a view are updated
+	uint32_t* pCandidates = frameArena.AllocateArray<uint32_t>(m_sceneObjects.size());
+	uint32_t* pViewMasks = frameArena.AllocateArray<uint32_t>(m_sceneObjects.size());
+	size_t candidateCount = m_pSpatialIndex->QueryFrustums(frustums, (int)viewCount, pCandidates, pViewMasks);
+
+	// draws of the objects seen by any view, with their view masks
+	DRAW_COMMAND* pShared = frameArena.AllocateArray<DRAW_COMMAND>(candidateCount);
+	uint32_t* pSharedMasks = frameArena.AllocateArray<uint32_t>(candidateCount);
+	SORT_ENTRY* pOrder = frameArena.AllocateArray<SORT_ENTRY>(candidateCount);
+
+	auto buildRange = [&](size_t begin, size_t end)
+	{
+		DRAW_COMMAND visible[g_DrawListGrainSize];
+		uint32_t visibleMasks[g_DrawListGrainSize];
+		size_t visibleCount = 0;
+
+		for (size_t candidate = begin; candidate < end; candidate++)
+		{
+			size_t index = pCandidates[candidate];
+			const SCENE_OBJECT& object = m_sceneObjects[index];
+			DRAW_COMMAND& command = visible[visibleCount];
+
+			// merged objects are drawn with their static batch
+			if (m_objectBatches[index] >= 0)
+			{
+				continue;
+			}
+
+			command.model = BuildModelMatrix(
+				object.scaleXYZ,
+				object.XrotationDegrees,
+				object.YrotationDegrees,
+				object.ZrotationDegrees,
+				object.positionXYZ);
+
+			BOUNDING_BOX worldBounds = TransformBoundingBox(GetShapeBounds(object.shape), command.model);
+
+			command.shape = object.shape;
+			command.staticBatch = -1;
+			command.firstIndex = 0;
+			command.indexCount = 0;
+			command.color = object.color;
+			command.textureSlot = object.textureTag.IsEmpty() ? -1 : FindTextureSlot(object.textureTag);
+			command.UVscale = object.UVscale;
+			command.materialIndex = object.materialTag.IsEmpty() ? -1 : FindMaterialIndex(object.materialTag);
+
+			// the projected size picks the level of detail of the mesh
+			// and the mip level the texture needs, repeated UV scale times -
+			// the views share both, so the largest size over them is used
+			command.lod = 0;
+			bool bLodShape = (object.shape == ShapeType::Sphere) || (object.shape == ShapeType::Cylinder);
+			float pixelSize = 0.0f;
+			if (bLodShape || (command.textureSlot >= 0))
+			{
+				for (size_t view = 0; view < viewCount; view++)
+				{
+					if (pViewMasks[candidate] & ((uint32_t)1 << view))
+					{
+						pixelSize = std::max(pixelSize, GetProjectedSize(worldBounds, viewProjections[view], pixelsPerUnit[view]));
+					}
+				}
+			}
+			if (command.textureSlot >= 0)
+			{
+				m_pTextureStreamer->RequestSize(command.textureSlot,
+					pixelSize / std::max(object.UVscale.x, object.UVscale.y));
+			}
+			if (bLodShape)
+			{
+				command.lod = SelectLod(pixelSize, m_objectLods[index]);
+				m_objectLods[index] = (uint8_t)command.lod;
+
+				// a quantized level stores its positions relative to its bounds
+				if ((command.lod > 0) && (NULL != m_lodMeshes))
+				{
+					command.model = command.model * ((object.shape == ShapeType::Sphere) ?
+						m_lodMeshes->GetSphereDequantizeMatrix(command.lod) :
+						m_lodMeshes->GetCylinderDequantizeMatrix(command.lod));
+				}
+			}
+
+			// group by texture then by mesh and level of detail, keeping
+			// the defined order of the objects within each group
+			command.sortKey =
+				((uint64_t)(command.textureSlot + 1) << 40) |
+				((uint64_t)command.shape << 36) |
+				((uint64_t)command.lod << 32) |
+				(uint64_t)index;
+
+			visibleMasks[visibleCount] = pViewMasks[candidate];
+			visibleCount++;
+		}
+
+		// one instance slot per object, written once for all the views
+		size_t firstInstance = instanceCount.fetch_add(visibleCount, std::memory_order_relaxed);
+		for (size_t i = 0; i < visibleCount; i++)
+		{
+			DRAW_COMMAND& command = visible[i];
+			size_t slot = firstInstance + i;
+
+			command.instanceIndex = (slot < instanceLimit) ? (int)slot : -1;
+			if (command.instanceIndex >= 0)
+			{
+				writeInstance(slot, command.model, command.color, command.UVscale, command.textureSlot);
+			}
+		}
+
+		// reserve room for the visible objects of this range and copy them
+		size_t first = drawCount.fetch_add(visibleCount, std::memory_order_relaxed);
+		for (size_t i = 0; i < visibleCount; i++)
+		{
+			pShared[first + i] = visible[i];
+			pSharedMasks[first + i] = visibleMasks[i];
+			pOrder[first + i].sortKey = visible[i].sortKey;
+			pOrder[first + i].command = (uint32_t)(first + i);
+		}
+	};
+
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor(candidateCount, g_DrawListGrainSize, buildRange);
+	}
+	else
+	{
+		for (size_t begin = 0; begin < candidateCount; begin += g_DrawListGrainSize)
+		{
+			buildRange(begin, std::min(begin + g_DrawListGrainSize, candidateCount));
+		}
+	}
+
+	// the ranges finish in any order, the sort keys restore a stable one
+	size_t sharedCount = drawCount.load();
+	std::sort(pOrder, pOrder + sharedCount,
+		[](const SORT_ENTRY& a, const SORT_ENTRY& b) { return a.sortKey < b.sortKey; });
+
+	// only the static batch culling and picking the draws out of
+	// the shared list are done per view
+	auto finishViews = [&](size_t begin, size_t end)
+	{
+		for (size_t view = begin; view < end; view++)
+		{
+			DRAW_LIST& drawList = pDrawLists[view];
+			DRAW_COMMAND* pRuns = pViewRuns[view];
+			size_t runCount = 0;
+
+			// one draw per run of visible objects in each static batch
+			for (size_t batchIndex = 0; batchIndex < m_staticBatches.size(); batchIndex++)
+			{
+				const STATIC_BATCH& batch = m_staticBatches[batchIndex];
+				bool bRunOpen = false;
+
+				for (const STATIC_RANGE& range : batch.ranges)
+				{
+					if (IsBoxInFrustum(frustums[view], range.worldBounds) == false)
+					{
+						bRunOpen = false;
+						continue;
+					}
+
+					if (batch.textureSlot >= 0)
+					{
+						const glm::vec2& UVscale = m_sceneObjects[range.objectIndex].UVscale;
+						m_pTextureStreamer->RequestSize(batch.textureSlot,
+							GetProjectedSize(range.worldBounds, viewProjections[view], pixelsPerUnit[view]) / std::max(UVscale.x, UVscale.y));
+					}
+
+					if (bRunOpen)
+					{
+						pRuns[runCount - 1].indexCount += range.indexCount;
+						continue;
+					}
+
+					DRAW_COMMAND command;
+					command.shape = m_sceneObjects[range.objectIndex].shape;
+					command.model = batch.mesh.dequantize;
+					command.color = batch.color;
+					command.textureSlot = batch.textureSlot;
+					command.UVscale = glm::vec2(1.0f, 1.0f);
+					command.materialIndex = batch.materialIndex;
+					command.lod = 0;
+					command.staticBatch = (int)batchIndex;
+					command.firstIndex = range.firstIndex;
+					command.indexCount = range.indexCount;
+					command.instanceIndex = (batchIndex < instanceLimit) ? (int)batchIndex : -1;
+					command.sortKey =
+						((uint64_t)(command.textureSlot + 1) << 40) |
+						(g_StaticBatchSortKey << 36) |
+						(uint64_t)range.objectIndex;
+					pRuns[runCount++] = command;
+					bRunOpen = true;
+				}
+			}
+			std::sort(pRuns, pRuns + runCount,
+				[](const DRAW_COMMAND& a, const DRAW_COMMAND& b) { return a.sortKey < b.sortKey; });
+
+			// merge the runs into the shared draws this view sees
+			uint32_t viewBit = (uint32_t)1 << view;
+			size_t run = 0;
+			for (size_t i = 0; i < sharedCount; i++)
+			{
+				const SORT_ENTRY& entry = pOrder[i];
+				if ((pSharedMasks[entry.command] & viewBit) == 0)
+				{
+					continue;
+				}
+				while ((run < runCount) && (pRuns[run].sortKey < entry.sortKey))
+				{
+					drawList.pCommands[drawList.count++] = pRuns[run++];
+				}
+				drawList.pCommands[drawList.count++] = pShared[entry.command];
+			}
+			while (run < runCount)
+			{
+				drawList.pCommands[drawList.count++] = pRuns[run++];
+			}
+		}
+	};
+
+	if (NULL != m_pJobSystem)
+	{
+		m_pJobSystem->ParallelFor(viewCount, 1, finishViews);
+	}
+	else
+	{
+		finishViews(0, viewCount);
+	}
+
+	return(std::min(instanceCount.load(), instanceLimit));
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  submitting the transformations and drawing the basic
+ *  3D shapes of a previously built draw list.  The draws
+ *  given an instance slot read their transformation, color
+ *  and UV scale from the bound instance block, so only the
+ *  instance index is set for them.
+ ***********************************************************/
+void SceneManager::RenderScene(
+	const DRAW_LIST& drawList)
+{
+	// once warmed up, submitting a frame must not touch the heap
+	HeapAllocationCheck allocationCheck("RenderScene", m_renderedFrames >= g_SteadyStateFrames);
+	m_renderedFrames++;
+
+	int boundTextureSlot = -1;
+	// the baked lighting switch is only set when it changes
+	int bakedLighting = -1;
+
+	for (size_t index = 0; index < drawList.count; index++)
+	{
+		const DRAW_COMMAND& command = drawList.pCommands[index];
+
+		if (command.instanceIndex >= 0)
+		{
+			m_uniforms.SetInt(g_InstanceIndexName, command.instanceIndex);
+
+			// the draws are sorted by texture, so the sampler only
+			// changes between groups
+			if ((command.textureSlot >= 0) && (command.textureSlot != boundTextureSlot))
+			{
+				m_uniforms.SetInt(g_TextureValueName, command.textureSlot);
+				boundTextureSlot = command.textureSlot;
+			}
+		}
+		else
+		{
+			if (m_bInstanceBlockSupported)
+			{
+				m_uniforms.SetInt(g_InstanceIndexName, -1);
+			}
+
+			if (NULL != m_pShaderManager)
+			{
+				m_uniforms.SetMat4(g_ModelName, command.model);
+			}
+
+			if (command.textureSlot >= 0)
+			{
+				SetShaderTextureSlot(command.textureSlot);
+				SetTextureUVScale(command.UVscale.x, command.UVscale.y);
+			}
+			else
+			{
+				SetShaderColor(command.color.r, command.color.g, command.color.b, command.color.a);
+			}
+			boundTextureSlot = -1;
+		}
+
+		if (command.materialIndex >= 0)
+		{
+			SetShaderMaterial(m_objectMaterials[command.materialIndex]);
+		}
+
+		if (m_bBakedLightingSupported)
+		{
+			int bBaked = ((command.staticBatch >= 0) && m_staticBatches[command.staticBatch].bBakedLight) ? 1 : 0;
+			if (bBaked != bakedLighting)
+			{
+				m_uniforms.SetInt(g_UseBakedLightingName, bBaked);
+				bakedLighting = bBaked;
+			}
+		}
+
+		if (command.staticBatch >= 0)
+		{
+			ParametricMeshes::DrawMeshRange(m_staticBatches[command.staticBatch].mesh,
+				command.firstIndex, command.indexCount);
+			continue;
+		}
+
+		switch (command.shape)
+		{
+		case ShapeType::Box:
+			m_basicMeshes->DrawBoxMesh();
+			break;
+		case ShapeType::Plane:
+			m_basicMeshes->DrawPlaneMesh();
+			break;
+		case ShapeType::Sphere:
+			if (command.lod > 0)
+				m_lodMeshes->DrawSphereMesh(command.lod);
+			else
+				m_basicMeshes->DrawSphereMesh();
+			break;
+		case ShapeType::Cylinder:
+			if (command.lod > 0)
+				m_lodMeshes->DrawCylinderMesh(command.lod);
+			else
+				m_basicMeshes->DrawCylinderMesh();
+			break;
+		}
+	}
 }
\ No newline at end of file
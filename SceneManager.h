@@ -11,9 +11,31 @@
 
 #include "ShaderManager.h"
 #include "ShapeMeshes.h"
+#include "ParametricMeshes.h"
+#include "ViewManager.h"
+#include "BoundingVolumes.h"
+#include "LooseOctree.h"
+#include "BoundingVolumeHierarchy.h"
+#include "TextureStreamer.h"
+#include "JobSystem.h"
+#include "InstanceRingBuffer.h"
+#include "StringId.h"
+#include "ShaderUniforms.h"
+#include "FrameArena.h"
+#include "MicroBenchmark.h"
+#include "StaticLightBaker.h"
+#include "AnimationSystem.h"
 
 #include <string>
 #include <vector>
+#include <cstdint>
+
+enum class ShapeType { //enum declaration for the basic mesh drawn by a scene object
+	Box,
+	Plane,
+	Sphere,
+	Cylinder
+};
 /***********************************************************
  *  SceneManager
  *
@@ -30,7 +52,7 @@ public:
 
 	struct TEXTURE_INFO
 	{
-		std::string tag;
+		StringId tag;
 		uint32_t ID;
 	};
 
@@ -41,32 +63,203 @@ public:
 		glm::vec3 diffuseColor;
 		glm::vec3 specularColor;
 		float shininess;
-		std::string tag;
+		StringId tag;
+	};
+
+	// one object of the 3D scene, defined once in PrepareScene()
+	struct SCENE_OBJECT
+	{
+		ShapeType shape;
+		glm::vec3 scaleXYZ;
+		float XrotationDegrees;
+		float YrotationDegrees;
+		float ZrotationDegrees;
+		glm::vec3 positionXYZ;
+		glm::vec4 color;
+		StringId textureTag;
+		glm::vec2 UVscale;
+		StringId materialTag;
+		// true when the object never moves after PrepareScene(), so
+		// it can be merged with others that look the same
+		bool bStatic;
+	};
+
+	// fully resolved draw of one scene object for one frame
+	struct DRAW_COMMAND
+	{
+		uint64_t sortKey;
+		ShapeType shape;
+		glm::mat4 model;
+		glm::vec4 color;
+		int textureSlot;
+		glm::vec2 UVscale;
+		int materialIndex;
+		// level of detail of the mesh, 0 is the full ShapeMeshes mesh
+		int lod;
+		// static batch drawn instead of the shape, or -1, and the run
+		// of its indices holding the visible objects
+		int staticBatch;
+		GLsizei firstIndex;
+		GLsizei indexCount;
+		// slot of its per-instance data in the instance block, or -1
+		// when it is drawn with the per-object uniforms
+		int instanceIndex;
+	};
+
+	// draw commands of one frame, allocated from a frame arena and
+	// valid until that arena is reset
+	struct DRAW_LIST
+	{
+		DRAW_COMMAND* pCommands;
+		size_t count;
+	};
+
+	// closest scene object under a point of the view
+	struct PICK_RESULT
+	{
+		// index of the object hit, or -1
+		int objectIndex;
+		// distance from the near plane along the ray and the world
+		// position of the hit
+		float distance;
+		glm::vec3 positionXYZ;
+		// time taken by the pick
+		double microseconds;
 	};
 
 private:
+	// one object inside a static batch
+	struct STATIC_RANGE
+	{
+		size_t objectIndex;
+		BOUNDING_BOX worldBounds;
+		GLsizei firstIndex;
+		GLsizei indexCount;
+	};
+
+	// pre-transformed static objects sharing texture, material and
+	// color, merged into one mesh with a range per object for culling
+	struct STATIC_BATCH
+	{
+		ParametricMeshes::GL_MESH mesh;
+		int textureSlot;
+		int materialIndex;
+		glm::vec4 color;
+		std::vector<STATIC_RANGE> ranges;
+		// true when the point light is baked into the vertices
+		bool bBakedLight;
+	};
+
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
 	// pointer to basic shapes object
 	ShapeMeshes* m_basicMeshes;
+	// pointer to the coarser levels of detail of the basic shapes
+	ParametricMeshes* m_lodMeshes;
+	// pointer to job system object used for building draw lists
+	JobSystem* m_pJobSystem;
+	// pointer to the spatial index over the world bounds of the
+	// scene objects, keyed by their index
+	LooseOctree* m_pSpatialIndex;
+	// pointer to the hierarchy over the same bounds used for picking,
+	// built on the first pick and refit after objects have moved
+	BoundingVolumeHierarchy* m_pPickingHierarchy;
+	// world space bounds of each scene object
+	std::vector<BOUNDING_BOX> m_objectBounds;
+	// true when objects moved since the picking hierarchy was fit
+	bool m_bPickingBoundsMoved;
+	// pointer to the texture streamer holding the loaded textures
+	// and the mip levels resident for them
+	TextureStreamer* m_pTextureStreamer;
+	// true when the shader reads per-instance data from the
+	// instance block instead of the per-object uniforms
+	bool m_bInstanceBlockSupported;
+	// true when the shader can take the point light from the baked
+	// vertex colors of the static batches
+	bool m_bBakedLightingSupported;
+	// pointer to the baker of the static batch lighting
+	StaticLightBaker* m_pLightBaker;
+	// pointer to the keyframe tracks of the dynamic objects
+	AnimationSystem* m_pAnimation;
 	// total number of loaded textures
 	int m_loadedTextures;
 	// loaded textures info
 	TEXTURE_INFO m_textureIDs[16];
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
+	// defined scene objects
+	std::vector<SCENE_OBJECT> m_sceneObjects;
+	// level of detail each scene object was last drawn with, kept
+	// so a level only changes once the size moved past a margin -
+	// each draw list job only touches the entries of its own range
+	mutable std::vector<uint8_t> m_objectLods;
+	// merged static objects, and the batch of each scene object or -1
+	std::vector<STATIC_BATCH> m_staticBatches;
+	std::vector<int> m_objectBatches;
+	// locations of the per-draw uniforms, so drawing an object
+	// needs no uniform lookups by name
+	ShaderUniforms m_uniforms;
+	// number of RenderScene() calls, the first ones may still allocate
+	unsigned int m_renderedFrames;
 
 	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
+	bool CreateGLTexture(const char* filename, const char* tag);
 	// bind loaded OpenGL textures to slots in memory
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
 	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
+	int FindTextureID(StringId tag);
+	int FindTextureSlot(StringId tag) const;
 	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	bool FindMaterial(StringId tag, OBJECT_MATERIAL& material);
+	int FindMaterialIndex(StringId tag) const;
+
+	// compose the model matrix from the transformation values
+	static glm::mat4 BuildModelMatrix(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// get the object space bounds of a basic mesh
+	static BOUNDING_BOX GetShapeBounds(ShapeType shape);
+	// get the world space bounds of a scene object
+	static BOUNDING_BOX GetObjectBounds(const SCENE_OBJECT& object);
+	// intersect an object space ray with the exact surface of a
+	// basic mesh, giving the ray parameter of the closest hit
+	static bool IntersectRayShape(
+		ShapeType shape,
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float maxDistance,
+		float& distance);
+	// intersect a world space ray with the exact surface of a
+	// scene object
+	bool IntersectRayObject(
+		size_t index,
+		const glm::vec3& origin,
+		const glm::vec3& direction,
+		float maxDistance,
+		float& distance) const;
+	// pick the level of detail for a projected size in pixels
+	static int SelectLod(float pixelSize, int previousLod);
+	// generate the full detail mesh data of a basic shape, with the
+	// faces of a box or plane split into the given cells along X, Y
+	// and Z
+	static void BuildShapeMesh(ShapeType shape, ParametricMeshes::MESH_DATA& mesh, const glm::ivec3& cells = glm::ivec3(1));
+	// cells along X, Y and Z that keep the flat faces of an object
+	// within vertexSpacing of a baked vertex
+	static glm::ivec3 GetBakeCells(const SCENE_OBJECT& object, float vertexSpacing);
+
+	// look up the per-draw uniforms and check which optional inputs
+	// the active shader program has
+	void LoadShaderInputs();
+
+	// merge the static objects that look the same into batches
+	void BuildStaticBatches();
+	// free the merged static batches
+	void DestroyStaticBatches();
 
 	// set the transformation values 
 	// into the transform buffer
@@ -86,7 +279,9 @@ private:
 
 	// set the texture data into the shader
 	void SetShaderTexture(
-		std::string textureTag);
+		StringId textureTag);
+	void SetShaderTextureSlot(
+		int textureSlot);
 
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
@@ -94,14 +289,102 @@ private:
 
 	// set the object material into the shader
 	void SetShaderMaterial(
-		std::string materialTag);
+		StringId materialTag);
+	void SetShaderMaterial(
+		const OBJECT_MATERIAL& material);
 
 public:
 
 	// The following methods are for the students to 
 	// customize for their own 3D scene
 	void PrepareScene();
-	void RenderScene();
+	void DefineSceneObjects();
 	void LoadSceneTextures();
+
+	// add an object to the 3D scene
+	void AddSceneObject(const SCENE_OBJECT& object);
+	// add a keyframe track to a dynamic scene object, returns the
+	// track index or -1 when the object cannot be animated
+	int AddAnimationTrack(
+		size_t index,
+		AnimationChannel channel,
+		const AnimationSystem::KEYFRAME* pKeys,
+		size_t keyCount,
+		bool bLoop);
+	// evaluate the animation tracks at a time in seconds and move the
+	// animated objects - not safe to call while a draw list is being
+	// built, returns false when nothing is animated
+	bool UpdateAnimations(double seconds);
+	// set new transformation values for a dynamic scene object -
+	// not safe to call while a draw list is being built
+	void MoveSceneObject(
+		size_t index,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// get the spatial index over the scene objects
+	const LooseOctree& GetSpatialIndex() const;
+	// find the closest scene object under a point of the view, given
+	// in normalized device coordinates - call on the thread that
+	// defines and moves the scene objects
+	bool PickObject(
+		const VIEW_STATE& viewState,
+		float ndcX,
+		float ndcY,
+		PICK_RESULT& result);
+	// set the GPU memory the streamed textures may use
+	void SetTextureBudget(size_t budgetBytes);
+	// upload the streamed texture levels and follow the sizes the
+	// last draw lists asked for - call once per frame on the GL thread
+	void UpdateTextureStreaming();
+	// true while texture levels asked for are still loading
+	bool IsStreamingTextures() const;
+	// get the image files of the loaded textures
+	void GetTextureFilenames(std::vector<std::string>& filenames) const;
+	// decode an edited image file again into the texture loaded from
+	// it, returns false when it is not a scene texture or cannot be read
+	bool ReloadTexture(const char* filename);
+	// set the job system used to spread the draw list building
+	// over several cores, or NULL to build on a single thread
+	void SetJobSystem(JobSystem* pJobSystem);
+
+	// true when the loaded shader declares the instance block
+	bool IsInstanceBlockSupported() const;
+	// look up the shader inputs again after the active program was
+	// relinked - returns false when the new program changed whether
+	// it has the instance block, which the frames are built around
+	bool ReloadShaderInputs();
+
+	// update, cull and sort the scene objects into a draw list taken
+	// from frameArena and write the per-instance data of up to
+	// maxInstances draws - safe to call from the scene update thread,
+	// returns the number of instance slots written
+	size_t BuildDrawList(
+		const VIEW_STATE& viewState,
+		FrameArena& frameArena,
+		DRAW_LIST& drawList,
+		INSTANCE_DATA* pInstances = NULL,
+		size_t maxInstances = 0) const;
+	// build one draw list per view for up to 32 views drawn in the
+	// same frame - the objects are updated, culled coarsely and given
+	// their per-instance data once, and only the frustum tests and
+	// the sort are repeated per view
+	size_t BuildDrawLists(
+		const VIEW_STATE* pViews,
+		size_t viewCount,
+		FrameArena& frameArena,
+		DRAW_LIST* pDrawLists,
+		INSTANCE_DATA* pInstances = NULL,
+		size_t maxInstances = 0) const;
+	// submit a previously built draw list to OpenGL, reading the
+	// draws that have an instance slot from the bound instance block
+	void RenderScene(
+		const DRAW_LIST& drawList);
+
+	// time the per-draw shader and lookup methods on the prepared
+	// scene - needs the shader program active
+	void RunMicroBenchmarks(MicroBenchmark& benchmark);
 };
 extern SceneManager* g_pSceneManager;
\ No newline at end of file
@@ -0,0 +1,123 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderuniforms.cpp
+// ============
+// keep the locations of the uniforms set every frame so they are not looked
+// up by name while drawing
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderUniforms.h"
+
+#include <glm/gtc/type_ptr.hpp>
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for looking up the locations of the
+ *  named uniforms in the active shader program.
+ ***********************************************************/
+void ShaderUniforms::Load(const char* const* names, size_t count)
+{
+	GLint programID = 0;
+	glGetIntegerv(GL_CURRENT_PROGRAM, &programID);
+
+	m_locations.clear();
+	for (size_t index = 0; index < count; index++)
+	{
+		UNIFORM_LOCATION uniform;
+		uniform.name = StringId::Register(names[index]);
+		uniform.location = (programID != 0) ? glGetUniformLocation(programID, names[index]) : -1;
+		m_locations.push_back(uniform);
+	}
+}
+
+/***********************************************************
+ *  IsLoaded()
+ *
+ *  This method is used for checking whether the locations
+ *  have been looked up.
+ ***********************************************************/
+bool ShaderUniforms::IsLoaded() const
+{
+	return(m_locations.size() > 0);
+}
+
+/***********************************************************
+ *  GetLocation()
+ *
+ *  This method is used for getting the location of a loaded
+ *  uniform, or -1 so the value is ignored when the shader
+ *  does not use it.
+ ***********************************************************/
+GLint ShaderUniforms::GetLocation(StringId name) const
+{
+	for (const UNIFORM_LOCATION& uniform : m_locations)
+	{
+		if (uniform.name == name)
+		{
+			return(uniform.location);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  SetInt()
+ *
+ *  This method is used for setting an int, bool or sampler
+ *  uniform.
+ ***********************************************************/
+void ShaderUniforms::SetInt(StringId name, int value) const
+{
+	glUniform1i(GetLocation(name), value);
+}
+
+/***********************************************************
+ *  SetFloat()
+ *
+ *  This method is used for setting a float uniform.
+ ***********************************************************/
+void ShaderUniforms::SetFloat(StringId name, float value) const
+{
+	glUniform1f(GetLocation(name), value);
+}
+
+/***********************************************************
+ *  SetVec2()
+ *
+ *  This method is used for setting a vec2 uniform.
+ ***********************************************************/
+void ShaderUniforms::SetVec2(StringId name, const glm::vec2& value) const
+{
+	glUniform2fv(GetLocation(name), 1, glm::value_ptr(value));
+}
+
+/***********************************************************
+ *  SetVec3()
+ *
+ *  This method is used for setting a vec3 uniform.
+ ***********************************************************/
+void ShaderUniforms::SetVec3(StringId name, const glm::vec3& value) const
+{
+	glUniform3fv(GetLocation(name), 1, glm::value_ptr(value));
+}
+
+/***********************************************************
+ *  SetVec4()
+ *
+ *  This method is used for setting a vec4 uniform.
+ ***********************************************************/
+void ShaderUniforms::SetVec4(StringId name, const glm::vec4& value) const
+{
+	glUniform4fv(GetLocation(name), 1, glm::value_ptr(value));
+}
+
+/***********************************************************
+ *  SetMat4()
+ *
+ *  This method is used for setting a mat4 uniform.
+ ***********************************************************/
+void ShaderUniforms::SetMat4(StringId name, const glm::mat4& value) const
+{
+	glUniformMatrix4fv(GetLocation(name), 1, GL_FALSE, glm::value_ptr(value));
+}
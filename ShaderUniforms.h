@@ -0,0 +1,56 @@
+///////////////////////////////////////////////////////////////////////////////
+// shaderuniforms.h
+// ============
+// keep the locations of the uniforms set every frame so they are not looked
+// up by name while drawing
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "StringId.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstddef>
+#include <vector>
+
+/***********************************************************
+ *  ShaderUniforms
+ *
+ *  This class contains the locations of a set of uniforms in
+ *  the shader program that was active when they were loaded.
+ *  The setters take the hashed name and call OpenGL directly,
+ *  so unlike the ShaderManager setters they build no strings.
+ *  A uniform the shader does not use has location -1, which
+ *  OpenGL ignores.
+ ***********************************************************/
+class ShaderUniforms
+{
+public:
+	// location of one uniform
+	struct UNIFORM_LOCATION
+	{
+		StringId name;
+		GLint location;
+	};
+
+private:
+	std::vector<UNIFORM_LOCATION> m_locations;
+
+public:
+	// look up the locations of the named uniforms in the active program
+	void Load(const char* const* names, size_t count);
+	// true once Load() has been called
+	bool IsLoaded() const;
+	// get a loaded location, or -1
+	GLint GetLocation(StringId name) const;
+
+	// set a uniform of the active program
+	void SetInt(StringId name, int value) const;
+	void SetFloat(StringId name, float value) const;
+	void SetVec2(StringId name, const glm::vec2& value) const;
+	void SetVec3(StringId name, const glm::vec3& value) const;
+	void SetVec4(StringId name, const glm::vec4& value) const;
+	void SetMat4(StringId name, const glm::mat4& value) const;
+};
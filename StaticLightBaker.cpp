@@ -0,0 +1,288 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticlightbaker.cpp
+// ============
+// bake the light of the fixed point light into the vertices of the static
+// objects once, and keep the results on disk for the next runs
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StaticLightBaker.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <limits>
+
+// declaration of global variables
+namespace
+{
+	// "SLBK" and the layout version of the cache file, raise the
+	// version whenever BakeVertex() changes its results
+	const uint32_t g_CacheMagic = 0x4B424C53;
+	const uint32_t g_CacheVersion = 1;
+
+	// number of vertices lit by each bake job
+	const size_t g_BakeGrainSize = 1024;
+	// baked vertices across the distance over which the light
+	// falls to half, which keeps the interpolation between them
+	// close to the light at every point of a face
+	const float g_VerticesPerHalfFalloff = 8.0f;
+
+	// 64-bit FNV-1a over a block of bytes
+	uint64_t HashBytes(uint64_t hash, const void* pData, size_t size)
+	{
+		const uint8_t* pBytes = (const uint8_t*)pData;
+		for (size_t i = 0; i < size; i++)
+		{
+			hash ^= pBytes[i];
+			hash *= 0x100000001B3ull;
+		}
+		return(hash);
+	}
+
+	// scale a 0 to 1 value to a byte
+	uint32_t ToByte(float value)
+	{
+		return((uint32_t)(glm::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f));
+	}
+}
+
+/***********************************************************
+ *  StaticLightBaker()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+StaticLightBaker::StaticLightBaker(const char* cacheFilename)
+{
+	m_cacheFilename = cacheFilename;
+	m_bChanged = false;
+}
+
+/***********************************************************
+ *  LoadCache()
+ *
+ *  This method is used for reading the bakes of an earlier
+ *  run.  A file with another magic or version is ignored, so
+ *  everything is baked again.
+ ***********************************************************/
+bool StaticLightBaker::LoadCache()
+{
+	m_entries.clear();
+	m_bChanged = false;
+
+	FILE* pFile = fopen(m_cacheFilename.c_str(), "rb");
+	if (NULL == pFile)
+	{
+		return(false);
+	}
+
+	uint32_t header[3] = { 0, 0, 0 };
+	bool bValid = (fread(header, sizeof(uint32_t), 3, pFile) == 3) &&
+		(header[0] == g_CacheMagic) &&
+		(header[1] == g_CacheVersion);
+
+	for (uint32_t entry = 0; bValid && (entry < header[2]); entry++)
+	{
+		uint64_t key = 0;
+		uint32_t count = 0;
+		bValid = (fread(&key, sizeof(key), 1, pFile) == 1) &&
+			(fread(&count, sizeof(count), 1, pFile) == 1);
+		if (bValid)
+		{
+			CACHE_ENTRY& cached = m_entries[key];
+			cached.colors.resize(count);
+			cached.bUsed = false;
+			bValid = (fread(cached.colors.data(), sizeof(uint32_t), count, pFile) == count);
+		}
+	}
+	fclose(pFile);
+
+	if (bValid == false)
+	{
+		std::cerr << "ERROR: Ignoring the static lighting cache:" << m_cacheFilename << std::endl;
+		m_entries.clear();
+		m_bChanged = true;
+		return(false);
+	}
+
+	std::cout << "INFO: Static lighting cache holds " << m_entries.size() << " bakes" << std::endl;
+	return(true);
+}
+
+/***********************************************************
+ *  SaveCache()
+ *
+ *  This method is used for writing the bakes used by this
+ *  run, which drops the ones of meshes that no longer exist.
+ ***********************************************************/
+bool StaticLightBaker::SaveCache()
+{
+	size_t usedCount = 0;
+	for (const auto& entry : m_entries)
+	{
+		if (entry.second.bUsed)
+			usedCount++;
+	}
+
+	// nothing to do when the file already holds exactly these bakes
+	if ((m_bChanged == false) && (usedCount == m_entries.size()))
+	{
+		return(true);
+	}
+
+	FILE* pFile = fopen(m_cacheFilename.c_str(), "wb");
+	if (NULL == pFile)
+	{
+		std::cerr << "ERROR: Could not write the static lighting cache:" << m_cacheFilename << std::endl;
+		return(false);
+	}
+
+	uint32_t header[3] = { g_CacheMagic, g_CacheVersion, (uint32_t)usedCount };
+	bool bWritten = (fwrite(header, sizeof(uint32_t), 3, pFile) == 3);
+	for (const auto& entry : m_entries)
+	{
+		if (entry.second.bUsed == false)
+			continue;
+
+		uint32_t count = (uint32_t)entry.second.colors.size();
+		bWritten = bWritten &&
+			(fwrite(&entry.first, sizeof(entry.first), 1, pFile) == 1) &&
+			(fwrite(&count, sizeof(count), 1, pFile) == 1) &&
+			(fwrite(entry.second.colors.data(), sizeof(uint32_t), count, pFile) == count);
+	}
+	bWritten = (fclose(pFile) == 0) && bWritten;
+
+	if (bWritten == false)
+	{
+		std::cerr << "ERROR: Could not write the static lighting cache:" << m_cacheFilename << std::endl;
+		return(false);
+	}
+
+	m_bChanged = false;
+	return(true);
+}
+
+/***********************************************************
+ *  BakeVertices()
+ *
+ *  This method is used for getting the baked light of a
+ *  mesh, from the cache when the same mesh was lit by the
+ *  same light before, otherwise by lighting its vertices on
+ *  the job system.
+ ***********************************************************/
+bool StaticLightBaker::BakeVertices(
+	const POINT_LIGHT& light,
+	const std::vector<ParametricMeshes::MESH_VERTEX>& vertices,
+	JobSystem* pJobSystem,
+	std::vector<uint32_t>& bakedLight)
+{
+	uint64_t key = HashBake(light, vertices);
+
+	auto found = m_entries.find(key);
+	if ((found != m_entries.end()) && (found->second.colors.size() == vertices.size()))
+	{
+		found->second.bUsed = true;
+		bakedLight = found->second.colors;
+		return(true);
+	}
+
+	bakedLight.resize(vertices.size());
+	auto bakeRange = [&](size_t begin, size_t end)
+	{
+		for (size_t i = begin; i < end; i++)
+		{
+			bakedLight[i] = BakeVertex(light, vertices[i]);
+		}
+	};
+	if (NULL != pJobSystem)
+	{
+		pJobSystem->ParallelFor(vertices.size(), g_BakeGrainSize, bakeRange);
+	}
+	else
+	{
+		bakeRange(0, vertices.size());
+	}
+
+	CACHE_ENTRY& cached = m_entries[key];
+	cached.colors = bakedLight;
+	cached.bUsed = true;
+	m_bChanged = true;
+
+	return(false);
+}
+
+/***********************************************************
+ *  GetVertexSpacing()
+ *
+ *  This method is used for getting how far apart the baked
+ *  vertices of a flat face may be, from the distance at
+ *  which the attenuation of the light falls to half of its
+ *  value at the light.  A light without falloff needs no
+ *  vertices inside the faces.
+ ***********************************************************/
+float StaticLightBaker::GetVertexSpacing(const POINT_LIGHT& light)
+{
+	float halfDistance = std::numeric_limits<float>::max();
+
+	// solve constant + linear * d + quadratic * d^2 = 2 * constant
+	if (light.quadratic > 0.0f)
+	{
+		halfDistance = (sqrtf(light.linear * light.linear + 4.0f * light.quadratic * light.constant) - light.linear) /
+			(2.0f * light.quadratic);
+	}
+	else if (light.linear > 0.0f)
+	{
+		halfDistance = light.constant / light.linear;
+	}
+
+	return(halfDistance / g_VerticesPerHalfFalloff);
+}
+
+/***********************************************************
+ *  HashBake()
+ *
+ *  This method is used for hashing the light and the vertex
+ *  positions and normals, which are all a bake depends on.
+ ***********************************************************/
+uint64_t StaticLightBaker::HashBake(const POINT_LIGHT& light, const std::vector<ParametricMeshes::MESH_VERTEX>& vertices)
+{
+	uint64_t hash = 0xCBF29CE484222325ull;
+
+	hash = HashBytes(hash, &g_CacheVersion, sizeof(g_CacheVersion));
+	hash = HashBytes(hash, &light.position, sizeof(light.position));
+	hash = HashBytes(hash, &light.ambient, sizeof(light.ambient));
+	hash = HashBytes(hash, &light.diffuse, sizeof(light.diffuse));
+	hash = HashBytes(hash, &light.constant, sizeof(light.constant));
+	hash = HashBytes(hash, &light.linear, sizeof(light.linear));
+	hash = HashBytes(hash, &light.quadratic, sizeof(light.quadratic));
+	for (const ParametricMeshes::MESH_VERTEX& vertex : vertices)
+	{
+		hash = HashBytes(hash, &vertex.position, sizeof(vertex.position));
+		hash = HashBytes(hash, &vertex.normal, sizeof(vertex.normal));
+	}
+
+	return(hash);
+}
+
+/***********************************************************
+ *  BakeVertex()
+ *
+ *  This method is used for lighting one world space vertex
+ *  with the Lambert term and the distance attenuation the
+ *  shader uses for the point light.  The constant term of
+ *  the attenuation is at least 1 for the scene light, so
+ *  both fit in a byte.
+ ***********************************************************/
+uint32_t StaticLightBaker::BakeVertex(const POINT_LIGHT& light, const ParametricMeshes::MESH_VERTEX& vertex)
+{
+	glm::vec3 toLight = light.position - vertex.position;
+	float distance = glm::length(toLight);
+	float attenuation = 1.0f / (light.constant + light.linear * distance + light.quadratic * distance * distance);
+	float lambert = (distance > 0.0f) ? std::max(glm::dot(vertex.normal, toLight / distance), 0.0f) : 1.0f;
+	glm::vec3 diffuse = light.diffuse * lambert * attenuation;
+
+	return(ToByte(diffuse.r) |
+		(ToByte(diffuse.g) << 8) |
+		(ToByte(diffuse.b) << 16) |
+		(ToByte(attenuation) << 24));
+}
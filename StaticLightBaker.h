@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticlightbaker.h
+// ============
+// bake the light of the fixed point light into the vertices of the static
+// objects once, and keep the results on disk for the next runs
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "ParametricMeshes.h"
+#include "ViewManager.h"
+#include "JobSystem.h"
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/***********************************************************
+ *  StaticLightBaker
+ *
+ *  This class contains the baked point light of the static
+ *  batches.  Each world space vertex gets the diffuse light
+ *  it receives in RGB and the distance attenuation in alpha,
+ *  so the shader can rebuild the ambient term from it and
+ *  only evaluates the camera spotlight per fragment.  A bake
+ *  is keyed by a hash of the light and of the vertex
+ *  positions and normals, so a scene edit only bakes the
+ *  batches it changed, and the bakes used by a run are saved
+ *  to the cache file for the next one.
+ ***********************************************************/
+class StaticLightBaker
+{
+public:
+	// constructor
+	StaticLightBaker(const char* cacheFilename);
+
+	// read the bakes saved by an earlier run, returns false when
+	// there is no usable cache file
+	bool LoadCache();
+	// write the bakes used since LoadCache() when any of them is
+	// new, returns false when the file cannot be written
+	bool SaveCache();
+
+	// fill bakedLight with an RGBA8 color per world space vertex,
+	// returns true when it was read from the cache
+	bool BakeVertices(
+		const POINT_LIGHT& light,
+		const std::vector<ParametricMeshes::MESH_VERTEX>& vertices,
+		JobSystem* pJobSystem,
+		std::vector<uint32_t>& bakedLight);
+
+	// largest distance between baked vertices that still follows
+	// the falloff of the light across a flat face
+	static float GetVertexSpacing(const POINT_LIGHT& light);
+	// light one world space vertex
+	static uint32_t BakeVertex(const POINT_LIGHT& light, const ParametricMeshes::MESH_VERTEX& vertex);
+
+private:
+	// one baked mesh of the cache
+	struct CACHE_ENTRY
+	{
+		std::vector<uint32_t> colors;
+		// true when a batch of this run uses it
+		bool bUsed;
+	};
+
+	std::string m_cacheFilename;
+	std::unordered_map<uint64_t, CACHE_ENTRY> m_entries;
+	// true when the file no longer matches the used entries
+	bool m_bChanged;
+
+	// hash of everything a bake depends on
+	static uint64_t HashBake(const POINT_LIGHT& light, const std::vector<ParametricMeshes::MESH_VERTEX>& vertices);
+};
@@ -0,0 +1,192 @@
+///////////////////////////////////////////////////////////////////////////////
+// staticlightbakertest.cpp
+// ============
+// check that the light baked into the split faces of the static boxes and
+// planes follows the point light inside the faces, not only at the corners
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StaticLightBaker.h"
+#include "ParametricMeshes.h"
+#include "ViewManager.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+// declaration of global variables
+namespace
+{
+	// largest difference allowed between an interpolated and an
+	// exact channel, in bytes - the bake is rounded to bytes and
+	// the light is not linear between the vertices
+	const int MAX_CHANNEL_ERROR = 3;
+
+	// a static object of the test, split the way the scene splits it
+	struct TEST_FACE
+	{
+		const char* name;
+		bool bBox;
+		glm::vec3 scale;
+		glm::vec3 position;
+		// points on a face of the object, away from its vertices
+		std::vector<glm::vec3> points;
+	};
+}
+
+/***********************************************************
+ *	BuildWorldMesh()
+ *
+ *  This function is used to generate a box or plane split
+ *  into cells no wider than the vertex spacing of the light,
+ *  and move it to world space with its scale and position.
+ ***********************************************************/
+void BuildWorldMesh(const TEST_FACE& face, float vertexSpacing, ParametricMeshes::MESH_DATA& mesh)
+{
+	glm::vec3 size = face.bBox ? face.scale : face.scale * 2.0f;
+	glm::ivec3 cells(1);
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		cells[axis] = std::max((int)std::ceil(size[axis] / vertexSpacing), 1);
+	}
+
+	if (face.bBox)
+	{
+		ParametricMeshes::BuildBox(mesh, cells);
+	}
+	else
+	{
+		ParametricMeshes::BuildPlane(mesh, cells.x, cells.z);
+	}
+
+	for (ParametricMeshes::MESH_VERTEX& vertex : mesh.vertices)
+	{
+		vertex.position = vertex.position * face.scale + face.position;
+	}
+}
+
+/***********************************************************
+ *	InterpolateBakedLight()
+ *
+ *  This function is used to find the triangle of a mesh
+ *  holding a point and blend the baked colors of its corners
+ *  with the barycentric weights of the point, the way the
+ *  rasterizer does.  It returns false when no triangle of
+ *  the mesh holds the point.
+ ***********************************************************/
+bool InterpolateBakedLight(
+	const ParametricMeshes::MESH_DATA& mesh,
+	const glm::vec3& point,
+	float channels[4])
+{
+	for (size_t i = 0; i + 2 < mesh.indices.size(); i += 3)
+	{
+		const glm::vec3& a = mesh.vertices[mesh.indices[i]].position;
+		const glm::vec3& b = mesh.vertices[mesh.indices[i + 1]].position;
+		const glm::vec3& c = mesh.vertices[mesh.indices[i + 2]].position;
+		glm::vec3 normal = glm::cross(b - a, c - a);
+		float area = glm::dot(normal, normal);
+
+		// skip the triangles of the other faces
+		if ((area <= 0.0f) || (std::fabs(glm::dot(point - a, normal)) > 1.0e-4f * std::sqrt(area)))
+		{
+			continue;
+		}
+
+		float weightB = glm::dot(glm::cross(point - a, c - a), normal) / area;
+		float weightC = glm::dot(glm::cross(b - a, point - a), normal) / area;
+		float weightA = 1.0f - weightB - weightC;
+		if ((weightA < -1.0e-5f) || (weightB < -1.0e-5f) || (weightC < -1.0e-5f))
+		{
+			continue;
+		}
+
+		const float weights[3] = { weightA, weightB, weightC };
+		for (int channel = 0; channel < 4; channel++)
+		{
+			channels[channel] = 0.0f;
+			for (int corner = 0; corner < 3; corner++)
+			{
+				uint32_t color = mesh.bakedLight[mesh.indices[i + corner]];
+				channels[channel] += weights[corner] * (float)((color >> (channel * 8)) & 0xFF);
+			}
+		}
+		return(true);
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *	main()
+ *
+ *  This function is used to bake the scene light into the
+ *  floor and a panel next to the light, and compare the
+ *  light interpolated at points inside their faces with the
+ *  light computed at those points.  It returns a failure
+ *  when any channel is further off than MAX_CHANNEL_ERROR.
+ ***********************************************************/
+int main()
+{
+	const POINT_LIGHT& light = ViewManager::GetScenePointLight();
+	float vertexSpacing = StaticLightBaker::GetVertexSpacing(light);
+	StaticLightBaker baker("StaticLightBakerTest.cache");
+	bool bPassed = true;
+
+	// the floor of the scene, with points under the light, in
+	// the pool around it and far away, and a thin panel beside
+	// the light with points on its front face
+	const TEST_FACE faces[] = {
+		{ "floor", false, glm::vec3(20.0f, 1.0f, 10.0f), glm::vec3(0.0f),
+			{ light.position * glm::vec3(1.0f, 0.0f, 1.0f) + glm::vec3(0.013f, 0.0f, 0.029f),
+			glm::vec3(3.37f, 0.0f, 1.21f), glm::vec3(0.71f, 0.0f, 3.93f),
+			glm::vec3(-6.53f, 0.0f, -4.17f), glm::vec3(17.3f, 0.0f, 8.9f) } },
+		{ "panel", true, glm::vec3(4.0f, 3.0f, 0.2f), glm::vec3(2.0f, 1.5f, 0.0f),
+			{ glm::vec3(2.07f, 1.93f, 0.1f), glm::vec3(0.61f, 0.47f, 0.1f), glm::vec3(3.71f, 2.83f, 0.1f) } }
+	};
+
+	std::cout << "INFO: Baked vertex spacing:" << vertexSpacing << std::endl;
+
+	for (const TEST_FACE& face : faces)
+	{
+		ParametricMeshes::MESH_DATA mesh;
+		BuildWorldMesh(face, vertexSpacing, mesh);
+		baker.BakeVertices(light, mesh.vertices, NULL, mesh.bakedLight);
+
+		for (const glm::vec3& point : face.points)
+		{
+			float interpolated[4];
+			if (InterpolateBakedLight(mesh, point, interpolated) == false)
+			{
+				std::cerr << "ERROR: No triangle of the " << face.name << " holds (" << point.x << ", "
+					<< point.y << ", " << point.z << ")" << std::endl;
+				bPassed = false;
+				continue;
+			}
+
+			// the points are on the top of the floor and the front of the panel
+			glm::vec3 normal = face.bBox ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+			uint32_t exact = StaticLightBaker::BakeVertex(light, { point, normal, glm::vec2(0.0f) });
+			for (int channel = 0; channel < 4; channel++)
+			{
+				float expected = (float)((exact >> (channel * 8)) & 0xFF);
+				if (std::fabs(interpolated[channel] - expected) > (float)MAX_CHANNEL_ERROR)
+				{
+					std::cerr << "ERROR: The " << face.name << " at (" << point.x << ", " << point.y << ", "
+						<< point.z << ") has " << interpolated[channel] << " in channel " << channel
+						<< " instead of " << expected << std::endl;
+					bPassed = false;
+				}
+			}
+		}
+	}
+
+	if (bPassed)
+	{
+		std::cout << "INFO: The baked light matches the point light inside the faces" << std::endl;
+	}
+
+	return(bPassed ? EXIT_SUCCESS : EXIT_FAILURE);
+}
@@ -0,0 +1,101 @@
+///////////////////////////////////////////////////////////////////////////////
+// stringid.cpp
+// ============
+// identify texture, material and uniform tags by a hash of their name that
+// is computed at compile time for string literals
+///////////////////////////////////////////////////////////////////////////////
+
+#include "StringId.h"
+
+#ifndef NDEBUG
+#include <cassert>
+#include <iostream>
+#include <mutex>
+#include <unordered_map>
+#endif
+
+// declaration of global variables
+namespace
+{
+#ifndef NDEBUG
+	// names of the registered IDs, for the collision check and
+	// the reverse lookup
+	std::mutex g_NamesMutex;
+	std::unordered_map<uint32_t, std::string>& GetNames()
+	{
+		static std::unordered_map<uint32_t, std::string> names;
+		return(names);
+	}
+#endif
+}
+
+/***********************************************************
+ *  Register()
+ *
+ *  This method is used for hashing a name known only at run
+ *  time.  Debug builds record the name and stop when another
+ *  name already produced the same hash.
+ ***********************************************************/
+StringId StringId::Register(const char* name)
+{
+	StringId id(name);
+
+#ifndef NDEBUG
+	if (id.IsEmpty() == false)
+	{
+		std::lock_guard<std::mutex> lock(g_NamesMutex);
+		std::unordered_map<uint32_t, std::string>& names = GetNames();
+		std::unordered_map<uint32_t, std::string>::iterator found = names.find(id.m_hash);
+
+		if (found == names.end())
+		{
+			names.emplace(id.m_hash, name);
+		}
+		else if (found->second != name)
+		{
+			std::cerr << "ERROR: StringId collision between \"" << found->second
+				<< "\" and \"" << name << "\"" << std::endl;
+			assert(false);
+		}
+	}
+#endif
+
+	return(id);
+}
+
+/***********************************************************
+ *  Register()
+ *
+ *  This method is used for hashing a run time std::string.
+ ***********************************************************/
+StringId StringId::Register(const std::string& name)
+{
+	return(Register(name.c_str()));
+}
+
+/***********************************************************
+ *  GetString()
+ *
+ *  This method is used for getting the name of a registered
+ *  ID back, for messages and debugging.
+ ***********************************************************/
+const char* StringId::GetString() const
+{
+	if (IsEmpty())
+	{
+		return("");
+	}
+
+#ifndef NDEBUG
+	std::lock_guard<std::mutex> lock(g_NamesMutex);
+	std::unordered_map<uint32_t, std::string>& names = GetNames();
+	std::unordered_map<uint32_t, std::string>::const_iterator found = names.find(m_hash);
+	if (found != names.end())
+	{
+		// the map never removes names, so the pointer stays valid
+		return(found->second.c_str());
+	}
+#endif
+
+	return("<unknown>");
+}
@@ -0,0 +1,75 @@
+///////////////////////////////////////////////////////////////////////////////
+// stringid.h
+// ============
+// identify texture, material and uniform tags by a hash of their name that
+// is computed at compile time for string literals
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/***********************************************************
+ *  StringId
+ *
+ *  This class contains the 32-bit FNV-1a hash of a tag name.
+ *  Constructing one from a string literal is constexpr, so a
+ *  call like SetShaderTexture("darkwood") passes an integer
+ *  and lookups compare integers instead of characters.  The
+ *  empty string hashes to 0, the same as a default StringId.
+ *
+ *  Names that are only known at run time go through
+ *  Register(), which in debug builds also records the name,
+ *  reports two names sharing a hash, and lets GetString()
+ *  turn an ID back into its name for diagnostics.
+ ***********************************************************/
+class StringId
+{
+public:
+	constexpr StringId() : m_hash(0) {}
+	constexpr StringId(const char* name) : m_hash(Hash(name)) {}
+
+	// hash a run time name, recording it for the debug checks
+	static StringId Register(const char* name);
+	static StringId Register(const std::string& name);
+
+	constexpr uint32_t GetHash() const { return m_hash; }
+	constexpr bool IsEmpty() const { return m_hash == 0; }
+	constexpr bool operator==(const StringId& other) const { return m_hash == other.m_hash; }
+	constexpr bool operator!=(const StringId& other) const { return m_hash != other.m_hash; }
+
+	// registered name of the ID, "<unknown>" when it was never
+	// registered or in release builds
+	const char* GetString() const;
+
+private:
+	uint32_t m_hash;
+
+	static constexpr uint32_t FNV_OFFSET_BASIS = 2166136261u;
+	static constexpr uint32_t FNV_PRIME = 16777619u;
+
+	static constexpr uint32_t Hash(const char* name)
+	{
+		if ((name == NULL) || (name[0] == '\0'))
+		{
+			return(0);
+		}
+
+		uint32_t hash = FNV_OFFSET_BASIS;
+		for (size_t i = 0; name[i] != '\0'; i++)
+		{
+			hash = (hash ^ (uint8_t)name[i]) * FNV_PRIME;
+		}
+
+		// keep 0 for the empty name
+		return((hash != 0) ? hash : 1);
+	}
+};
+
+// "darkwood"_id, for places that need the ID as a constant
+constexpr StringId operator"" _id(const char* name, size_t)
+{
+	return(StringId(name));
+}
@@ -0,0 +1,799 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.cpp
+// ============
+// keep only the mip levels of the scene textures that their on-screen size
+// needs in GPU memory, loading and evicting the finer levels in the
+// background to stay under a memory budget
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureStreamer.h"
+#include "ResourceTracker.h"
+#include "ViewManager.h"
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// declaration of global variables
+namespace
+{
+	// largest size in texels of the levels uploaded up front
+	const int g_PinnedMipSize = 64;
+	// Update() calls without a request after which a texture only
+	// needs its pinned levels
+	const unsigned int g_UnusedUpdates = 120;
+
+	// size of a level of a texture, never below 1 texel
+	int GetLevelSize(int size, int level)
+	{
+		return(std::max(1, size >> level));
+	}
+}
+
+/***********************************************************
+ *  TextureStreamer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureStreamer::TextureStreamer(size_t budgetBytes)
+{
+	m_textureCount = 0;
+	m_budgetBytes = budgetBytes;
+	m_residentBytes = 0;
+	m_loadingBytes = 0;
+	m_updateCount = 0;
+	m_bStopRequested = false;
+
+	for (int i = 0; i < MAX_TEXTURES; i++)
+	{
+		m_textures[i].ID = 0;
+		m_textures[i].requestedLevel = 0;
+		m_textures[i].bLoading = false;
+		m_textures[i].loadingBytes = 0;
+		m_textures[i].generation = 0;
+	}
+
+	m_loaderThread = std::thread(&TextureStreamer::LoaderThreadMain, this);
+}
+
+/***********************************************************
+ *  ~TextureStreamer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureStreamer::~TextureStreamer()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopRequested = true;
+	}
+	m_condition.notify_all();
+
+	if (m_loaderThread.joinable())
+	{
+		m_loaderThread.join();
+	}
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used for creating a streamed texture from
+ *  its decoded full size image.  Only the levels up to 64
+ *  texels across are uploaded, and the file name is kept to
+ *  read the finer levels again when they are needed.
+ ***********************************************************/
+GLuint TextureStreamer::AddTexture(const char* filename, const uint8_t* pPixels, int width, int height, int channels)
+{
+	GLuint textureID = 0;
+
+	if ((m_textureCount >= MAX_TEXTURES) || (NULL == pPixels) ||
+		(width <= 0) || (height <= 0) || ((channels != 3) && (channels != 4)))
+	{
+		return(0);
+	}
+
+	int textureIndex = m_textureCount;
+	STREAMED_TEXTURE& texture = m_textures[textureIndex];
+	texture.filename = filename;
+	texture.bLoading = false;
+	texture.loadingBytes = 0;
+
+	glGenTextures(1, &textureID);
+	texture.ID = textureID;
+	m_textureCount++;
+	ResourceTracker::Allocate(ResourceCategory::Texture, textureID, 0, filename);
+
+	glActiveTexture(GL_TEXTURE0 + textureIndex);
+	glBindTexture(GL_TEXTURE_2D, textureID);
+
+	// set the texture wrapping parameters
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// set texture filtering parameters, the minification filter
+	// turns to the mipmapped one once levels are resident
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+	DefineLevels(textureIndex, pPixels, width, height, channels);
+
+	return(textureID);
+}
+
+/***********************************************************
+ *  ReloadTexture()
+ *
+ *  This method is used for replacing the image of a texture
+ *  whose file was edited.  Every old level is freed, a load
+ *  still reading the old file is dropped, and the texture
+ *  starts over from the pinned levels of the new image, so
+ *  Update() streams its finer levels back in as they are
+ *  asked for.
+ ***********************************************************/
+bool TextureStreamer::ReloadTexture(int textureIndex, const uint8_t* pPixels, int width, int height, int channels)
+{
+	if ((textureIndex < 0) || (textureIndex >= m_textureCount) || (NULL == pPixels) ||
+		(width <= 0) || (height <= 0) || ((channels != 3) && (channels != 4)))
+	{
+		return(false);
+	}
+
+	STREAMED_TEXTURE& texture = m_textures[textureIndex];
+	if (texture.bLoading)
+	{
+		m_loadingBytes -= texture.loadingBytes;
+		texture.loadingBytes = 0;
+		texture.bLoading = false;
+	}
+	texture.generation++;
+
+	EvictLevels(textureIndex, texture.levelCount);
+	DefineLevels(textureIndex, pPixels, width, height, channels);
+
+	return(true);
+}
+
+/***********************************************************
+ *  DefineLevels()
+ *
+ *  This method is used for working out the levels of a
+ *  texture from the size of its image and uploading the
+ *  ones up to 64 texels across.
+ ***********************************************************/
+void TextureStreamer::DefineLevels(int textureIndex, const uint8_t* pPixels, int width, int height, int channels)
+{
+	std::vector<MIP_LEVEL> levels;
+	STREAMED_TEXTURE& texture = m_textures[textureIndex];
+
+	texture.width = width;
+	texture.height = height;
+	texture.channels = channels;
+	texture.levelCount = 1;
+	while (((width | height) >> texture.levelCount) > 0)
+	{
+		texture.levelCount++;
+	}
+	texture.pinnedLevel = 0;
+	while ((std::max(width, height) >> texture.pinnedLevel) > g_PinnedMipSize)
+	{
+		texture.pinnedLevel++;
+	}
+	// nothing is resident until the pinned levels are uploaded
+	texture.residentLevel = texture.levelCount;
+	texture.requestedLevel = texture.levelCount;
+	texture.targetLevel = texture.pinnedLevel;
+	texture.lastUsedUpdate = m_updateCount;
+
+	BuildLevels(pPixels, width, height, channels, texture.pinnedLevel, texture.levelCount - 1, levels);
+	UploadLevels(textureIndex, texture.pinnedLevel, levels);
+}
+
+/***********************************************************
+ *  DestroyTextures()
+ *
+ *  This method is used for deleting every texture.  Loads
+ *  still running are dropped when they finish.
+ ***********************************************************/
+void TextureStreamer::DestroyTextures()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_requests.clear();
+	}
+
+	for (int i = 0; i < m_textureCount; i++)
+	{
+		glDeleteTextures(1, &m_textures[i].ID);
+		ResourceTracker::Release(ResourceCategory::Texture, m_textures[i].ID);
+		m_textures[i].ID = 0;
+		m_textures[i].bLoading = false;
+		m_textures[i].loadingBytes = 0;
+		m_textures[i].generation++;
+	}
+
+	m_textureCount = 0;
+	m_residentBytes = 0;
+	m_loadingBytes = 0;
+}
+
+/***********************************************************
+ *  RequestSize()
+ *
+ *  This method is used for asking for the coarsest level of
+ *  a texture that still has a texel for each pixel when it
+ *  is drawn texelsAcross texels wide.  The finest level asked
+ *  for between two updates wins.
+ ***********************************************************/
+void TextureStreamer::RequestSize(int textureIndex, float texelsAcross)
+{
+	if ((textureIndex < 0) || (textureIndex >= m_textureCount))
+	{
+		return;
+	}
+
+	STREAMED_TEXTURE& texture = m_textures[textureIndex];
+	int level = texture.levelCount - 1;
+	if (texelsAcross > 0.0f)
+	{
+		float ratio = (float)std::max(texture.width, texture.height) / texelsAcross;
+		level = (ratio > 1.0f) ? std::min((int)std::log2(ratio), texture.levelCount - 1) : 0;
+	}
+
+	int requested = texture.requestedLevel.load(std::memory_order_relaxed);
+	while ((level < requested) &&
+		!texture.requestedLevel.compare_exchange_weak(requested, level, std::memory_order_relaxed))
+	{
+	}
+}
+
+/***********************************************************
+ *  Update()
+ *
+ *  This method is used for uploading the levels the loader
+ *  thread finished, taking the requests made since the last
+ *  call, and starting a load for each texture whose resident
+ *  levels are coarser than requested, within the budget.
+ *  A texture not asked for in a while drops its target back
+ *  to the pinned levels, which makes its finer levels the
+ *  first to be evicted once memory runs short.
+ ***********************************************************/
+void TextureStreamer::Update()
+{
+	std::vector<LOAD_RESULT> results;
+
+	m_updateCount++;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		results.swap(m_results);
+	}
+
+	for (const LOAD_RESULT& result : results)
+	{
+		STREAMED_TEXTURE& texture = m_textures[result.texture];
+
+		// a load of a destroyed or reloaded texture is dropped
+		if ((result.texture >= m_textureCount) || (texture.bLoading == false) ||
+			(result.generation != texture.generation))
+		{
+			continue;
+		}
+
+		m_loadingBytes -= texture.loadingBytes;
+		texture.loadingBytes = 0;
+		texture.bLoading = false;
+
+		if (result.levels.size() == 0)
+		{
+			std::cerr << "ERROR: Could not stream image:" << texture.filename << std::endl;
+			continue;
+		}
+		UploadLevels(result.texture, result.firstLevel, result.levels);
+	}
+
+	// follow the requests made while building the frames
+	for (int i = 0; i < m_textureCount; i++)
+	{
+		STREAMED_TEXTURE& texture = m_textures[i];
+		int requested = texture.requestedLevel.exchange(texture.levelCount, std::memory_order_relaxed);
+
+		if (requested < texture.levelCount)
+		{
+			texture.targetLevel = std::min(requested, texture.pinnedLevel);
+			texture.lastUsedUpdate = m_updateCount;
+		}
+		else if ((m_updateCount - texture.lastUsedUpdate) > g_UnusedUpdates)
+		{
+			texture.targetLevel = texture.pinnedLevel;
+		}
+	}
+
+	// a lowered budget is met right away, by every texture if needed
+	MakeRoom(-1, 0);
+
+	for (int i = 0; i < m_textureCount; i++)
+	{
+		STREAMED_TEXTURE& texture = m_textures[i];
+		if (texture.bLoading || (texture.targetLevel >= texture.residentLevel))
+		{
+			continue;
+		}
+
+		// evict for the levels asked for, then settle for the
+		// finest ones that fit
+		int firstLevel = texture.targetLevel;
+		MakeRoom(i, GetLevelBytes(texture, firstLevel, texture.residentLevel));
+		while ((firstLevel < texture.residentLevel) &&
+			((m_residentBytes + m_loadingBytes + GetLevelBytes(texture, firstLevel, texture.residentLevel)) > m_budgetBytes))
+		{
+			firstLevel++;
+		}
+		if (firstLevel == texture.residentLevel)
+		{
+			continue;
+		}
+
+		LOAD_REQUEST request;
+		request.texture = i;
+		request.filename = texture.filename;
+		request.width = texture.width;
+		request.height = texture.height;
+		request.channels = texture.channels;
+		request.firstLevel = firstLevel;
+		request.lastLevel = texture.residentLevel - 1;
+		request.generation = texture.generation;
+
+		texture.bLoading = true;
+		texture.loadingBytes = GetLevelBytes(texture, firstLevel, texture.residentLevel);
+		m_loadingBytes += texture.loadingBytes;
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_requests.push_back(request);
+		}
+		m_condition.notify_all();
+	}
+}
+
+/***********************************************************
+ *  MakeRoom()
+ *
+ *  This method is used for evicting levels of the textures
+ *  other than textureIndex until bytes more fit in the
+ *  budget.  Levels finer than their texture's target go
+ *  first, then every streamed level of the textures unused
+ *  the longest.  Textures asked for in this update keep the
+ *  levels they need, even if bytes does not fit then, unless
+ *  textureIndex is -1 to bring the usage under the budget.
+ ***********************************************************/
+void TextureStreamer::MakeRoom(int textureIndex, size_t bytes)
+{
+	auto fits = [&]()
+	{
+		return((m_residentBytes + m_loadingBytes + bytes) <= m_budgetBytes);
+	};
+
+	for (int i = 0; (i < m_textureCount) && !fits(); i++)
+	{
+		const STREAMED_TEXTURE& texture = m_textures[i];
+		if ((i != textureIndex) && !texture.bLoading && (texture.residentLevel < texture.targetLevel))
+		{
+			EvictLevels(i, texture.targetLevel);
+		}
+	}
+
+	while (!fits())
+	{
+		int oldest = -1;
+		for (int i = 0; i < m_textureCount; i++)
+		{
+			const STREAMED_TEXTURE& texture = m_textures[i];
+			if ((i == textureIndex) || texture.bLoading ||
+				(texture.lastUsedUpdate == m_updateCount) ||
+				(texture.residentLevel >= texture.pinnedLevel))
+			{
+				continue;
+			}
+			if ((oldest < 0) || (texture.lastUsedUpdate < m_textures[oldest].lastUsedUpdate))
+			{
+				oldest = i;
+			}
+		}
+
+		if (oldest < 0)
+		{
+			break;
+		}
+		EvictLevels(oldest, m_textures[oldest].pinnedLevel);
+	}
+
+	// a budget below what the textures in use need is met by
+	// dropping the finest resident level one at a time
+	while ((textureIndex < 0) && !fits())
+	{
+		int finest = -1;
+		for (int i = 0; i < m_textureCount; i++)
+		{
+			const STREAMED_TEXTURE& texture = m_textures[i];
+			if (!texture.bLoading && (texture.residentLevel < texture.pinnedLevel) &&
+				((finest < 0) || (texture.residentLevel < m_textures[finest].residentLevel)))
+			{
+				finest = i;
+			}
+		}
+
+		if (finest < 0)
+		{
+			break;
+		}
+		EvictLevels(finest, m_textures[finest].residentLevel + 1);
+	}
+}
+
+/***********************************************************
+ *  UploadLevels()
+ *
+ *  This method is used for uploading a run of levels that
+ *  ends right above the resident ones, then setting the
+ *  level range of the texture to the resident levels and
+ *  sampling them with trilinear filtering.
+ ***********************************************************/
+void TextureStreamer::UploadLevels(int textureIndex, int firstLevel, const std::vector<MIP_LEVEL>& levels)
+{
+	STREAMED_TEXTURE& texture = m_textures[textureIndex];
+	GLint internalFormat = (texture.channels == 4) ? GL_RGBA8 : GL_RGB8;
+	GLenum format = (texture.channels == 4) ? GL_RGBA : GL_RGB;
+
+	if ((firstLevel + (int)levels.size()) != texture.residentLevel)
+	{
+		return;
+	}
+
+	glActiveTexture(GL_TEXTURE0 + textureIndex);
+	glBindTexture(GL_TEXTURE_2D, texture.ID);
+
+	// rows of the small RGB levels are not 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		glTexImage2D(GL_TEXTURE_2D, firstLevel + (GLint)i, internalFormat,
+			levels[i].width, levels[i].height, 0, format, GL_UNSIGNED_BYTE, levels[i].pixels.data());
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+
+	// the coarsest level stays the last one whatever is resident
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, firstLevel);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, texture.levelCount - 1);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+
+	m_residentBytes += GetLevelBytes(texture, firstLevel, texture.residentLevel);
+	texture.residentLevel = firstLevel;
+	ResourceTracker::Resize(ResourceCategory::Texture, texture.ID, GetLevelBytes(texture, firstLevel, texture.levelCount));
+}
+
+/***********************************************************
+ *  EvictLevels()
+ *
+ *  This method is used for moving the base level of a
+ *  texture up to residentLevel, then giving the finer levels
+ *  an empty image so the driver can free their memory.
+ ***********************************************************/
+void TextureStreamer::EvictLevels(int textureIndex, int residentLevel)
+{
+	STREAMED_TEXTURE& texture = m_textures[textureIndex];
+	GLint internalFormat = (texture.channels == 4) ? GL_RGBA8 : GL_RGB8;
+	GLenum format = (texture.channels == 4) ? GL_RGBA : GL_RGB;
+
+	if (residentLevel <= texture.residentLevel)
+	{
+		return;
+	}
+
+	glActiveTexture(GL_TEXTURE0 + textureIndex);
+	glBindTexture(GL_TEXTURE_2D, texture.ID);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, residentLevel);
+	for (int level = texture.residentLevel; level < residentLevel; level++)
+	{
+		glTexImage2D(GL_TEXTURE_2D, level, internalFormat, 0, 0, 0, format, GL_UNSIGNED_BYTE, NULL);
+	}
+
+	m_residentBytes -= GetLevelBytes(texture, texture.residentLevel, residentLevel);
+	texture.residentLevel = residentLevel;
+	ResourceTracker::Resize(ResourceCategory::Texture, texture.ID, GetLevelBytes(texture, residentLevel, texture.levelCount));
+}
+
+/***********************************************************
+ *  LoaderThreadMain()
+ *
+ *  This method is the body of the loader thread.  It reads
+ *  the requested levels of one texture at a time, queues
+ *  them for the next Update() and asks for that frame.
+ ***********************************************************/
+void TextureStreamer::LoaderThreadMain()
+{
+	while (true)
+	{
+		LOAD_REQUEST request;
+		LOAD_RESULT result;
+
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this] { return (m_requests.size() > 0) || m_bStopRequested; });
+			if (m_bStopRequested)
+			{
+				break;
+			}
+			request = m_requests.front();
+			m_requests.erase(m_requests.begin());
+		}
+
+		result.texture = request.texture;
+		result.firstLevel = request.firstLevel;
+		result.generation = request.generation;
+		if (ReadLevels(request, result.levels) == false)
+		{
+			result.levels.clear();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_results.push_back(std::move(result));
+		}
+
+		// wake the on-demand render loop so the next frame uploads them
+		ViewManager::PostRedrawFromThread();
+	}
+}
+
+/***********************************************************
+ *  ReadLevels()
+ *
+ *  This method is used for decoding the image file of a
+ *  texture again and downsampling it to the requested levels.
+ *  The vertical flip set by the scene for its first load
+ *  stays on for the loads here.
+ ***********************************************************/
+bool TextureStreamer::ReadLevels(const LOAD_REQUEST& request, std::vector<MIP_LEVEL>& levels)
+{
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
+
+	unsigned char* image = stbi_load(
+		request.filename.c_str(),
+		&width,
+		&height,
+		&colorChannels,
+		0);
+	if (NULL == image)
+	{
+		return(false);
+	}
+
+	// the file no longer matches the levels already uploaded
+	if ((width != request.width) || (height != request.height) || (colorChannels != request.channels))
+	{
+		stbi_image_free(image);
+		return(false);
+	}
+
+	BuildLevels(image, width, height, colorChannels, request.firstLevel, request.lastLevel, levels);
+	stbi_image_free(image);
+
+	return(true);
+}
+
+/***********************************************************
+ *  BuildLevels()
+ *
+ *  This method is used for downsampling a full size image
+ *  level by level and keeping the levels from firstLevel to
+ *  lastLevel.
+ ***********************************************************/
+void TextureStreamer::BuildLevels(
+	const uint8_t* pPixels,
+	int width,
+	int height,
+	int channels,
+	int firstLevel,
+	int lastLevel,
+	std::vector<MIP_LEVEL>& levels)
+{
+	MIP_LEVEL current;
+
+	levels.clear();
+	levels.reserve(lastLevel - firstLevel + 1);
+
+	// level 0 is the image itself, copied only when it is kept
+	if (firstLevel == 0)
+	{
+		current.width = width;
+		current.height = height;
+		current.pixels.assign(pPixels, pPixels + ((size_t)width * height * channels));
+		levels.push_back(current);
+	}
+
+	const uint8_t* pSource = pPixels;
+	int sourceWidth = width;
+	int sourceHeight = height;
+	for (int level = 1; level <= lastLevel; level++)
+	{
+		MIP_LEVEL next;
+		DownsampleLevel(pSource, sourceWidth, sourceHeight, channels, next);
+		current = std::move(next);
+		if (level >= firstLevel)
+		{
+			levels.push_back(current);
+		}
+
+		pSource = current.pixels.data();
+		sourceWidth = current.width;
+		sourceHeight = current.height;
+	}
+}
+
+/***********************************************************
+ *  DownsampleLevel()
+ *
+ *  This method is used for averaging each 2x2 block of texels
+ *  into one texel of the next level.  An odd last row or
+ *  column is folded into the block before it.
+ ***********************************************************/
+void TextureStreamer::DownsampleLevel(const uint8_t* pPixels, int width, int height, int channels, MIP_LEVEL& level)
+{
+	level.width = GetLevelSize(width, 1);
+	level.height = GetLevelSize(height, 1);
+	level.pixels.resize((size_t)level.width * level.height * channels);
+
+	for (int y = 0; y < level.height; y++)
+	{
+		int y0 = std::min(y * 2, height - 1);
+		int y1 = std::min((y * 2) + 1, height - 1);
+		for (int x = 0; x < level.width; x++)
+		{
+			int x0 = std::min(x * 2, width - 1);
+			int x1 = std::min((x * 2) + 1, width - 1);
+			for (int c = 0; c < channels; c++)
+			{
+				int sum =
+					pPixels[(((size_t)y0 * width) + x0) * channels + c] +
+					pPixels[(((size_t)y0 * width) + x1) * channels + c] +
+					pPixels[(((size_t)y1 * width) + x0) * channels + c] +
+					pPixels[(((size_t)y1 * width) + x1) * channels + c];
+				level.pixels[(((size_t)y * level.width) + x) * channels + c] = (uint8_t)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  GetLevelBytes()
+ *
+ *  This method is used for getting the GPU memory of the
+ *  levels from firstLevel up to endLevel, counting 4 bytes a
+ *  texel since drivers pad RGB texels to RGBA.
+ ***********************************************************/
+size_t TextureStreamer::GetLevelBytes(const STREAMED_TEXTURE& texture, int firstLevel, int endLevel)
+{
+	size_t bytes = 0;
+
+	for (int level = firstLevel; level < endLevel; level++)
+	{
+		bytes += (size_t)GetLevelSize(texture.width, level) * GetLevelSize(texture.height, level) * 4;
+	}
+
+	return(bytes);
+}
+
+/***********************************************************
+ *  SetBudget()
+ *
+ *  This method is used for setting the GPU memory the
+ *  textures may use, met from the next Update() on.
+ ***********************************************************/
+void TextureStreamer::SetBudget(size_t budgetBytes)
+{
+	m_budgetBytes = budgetBytes;
+}
+
+/***********************************************************
+ *  GetBudgetBytes()
+ *
+ *  This method is used for getting the GPU memory budget.
+ ***********************************************************/
+size_t TextureStreamer::GetBudgetBytes() const
+{
+	return(m_budgetBytes);
+}
+
+/***********************************************************
+ *  GetResidentBytes()
+ *
+ *  This method is used for getting the GPU memory used by
+ *  the resident levels.
+ ***********************************************************/
+size_t TextureStreamer::GetResidentBytes() const
+{
+	return(m_residentBytes);
+}
+
+/***********************************************************
+ *  GetResidentLevel()
+ *
+ *  This method is used for getting the finest resident level
+ *  of a texture, or -1 for an unknown texture.
+ ***********************************************************/
+int TextureStreamer::GetResidentLevel(int textureIndex) const
+{
+	if ((textureIndex < 0) || (textureIndex >= m_textureCount))
+	{
+		return(-1);
+	}
+
+	return(m_textures[textureIndex].residentLevel);
+}
+
+/***********************************************************
+ *  IsLoading()
+ *
+ *  This method is used for telling whether any texture is
+ *  waiting for the loader thread.
+ ***********************************************************/
+bool TextureStreamer::IsLoading() const
+{
+	for (int i = 0; i < m_textureCount; i++)
+	{
+		if (m_textures[i].bLoading)
+		{
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  FindTexture()
+ *
+ *  This method is used for finding the texture loaded from
+ *  an image file.
+ ***********************************************************/
+int TextureStreamer::FindTexture(const char* filename) const
+{
+	for (int i = 0; i < m_textureCount; i++)
+	{
+		if (m_textures[i].filename == filename)
+		{
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  GetTextureCount()
+ *
+ *  This method is used for getting the number of textures.
+ ***********************************************************/
+int TextureStreamer::GetTextureCount() const
+{
+	return(m_textureCount);
+}
+
+/***********************************************************
+ *  GetFilename()
+ *
+ *  This method is used for getting the image file a texture
+ *  was loaded from.
+ ***********************************************************/
+const char* TextureStreamer::GetFilename(int textureIndex) const
+{
+	if ((textureIndex < 0) || (textureIndex >= m_textureCount))
+	{
+		return("");
+	}
+
+	return(m_textures[textureIndex].filename.c_str());
+}
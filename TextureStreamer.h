@@ -0,0 +1,189 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturestreamer.h
+// ============
+// keep only the mip levels of the scene textures that their on-screen size
+// needs in GPU memory, loading and evicting the finer levels in the
+// background to stay under a memory budget
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureStreamer
+ *
+ *  This class contains the streamed scene textures.  A new
+ *  texture only gets its coarse levels, up to 64 texels
+ *  across, which always stay resident.  While drawing, the
+ *  draw list building asks for the level each textured
+ *  object needs for its projected size, and once per frame
+ *  Update() reads the finest level asked for per texture.
+ *
+ *  Finer levels are decoded and downsampled from the image
+ *  file by a loader thread, then uploaded on the GL thread,
+ *  where the base level of the texture moves to the finest
+ *  level uploaded.  A load that does not fit in the budget
+ *  first evicts the levels other textures no longer need,
+ *  then those of the textures unused the longest, and then
+ *  settles for a coarser level.  The texture object keeps
+ *  its ID through all of it, so its slot binding holds.
+ *  That also goes for a texture reloaded after its file was
+ *  edited, which starts over from its new pinned levels.
+ ***********************************************************/
+class TextureStreamer
+{
+public:
+	// constructor
+	TextureStreamer(size_t budgetBytes);
+	// destructor
+	~TextureStreamer();
+
+	// most streamed textures, one per scene texture slot
+	static const int MAX_TEXTURES = 16;
+
+private:
+	// pixels of one mip level
+	struct MIP_LEVEL
+	{
+		int width;
+		int height;
+		std::vector<uint8_t> pixels;
+	};
+
+	// levels the loader thread is asked to read for one texture,
+	// with a copy of what it needs to know about the texture
+	struct LOAD_REQUEST
+	{
+		int texture;
+		std::string filename;
+		int width;
+		int height;
+		int channels;
+		int firstLevel;
+		int lastLevel;
+		unsigned int generation;
+	};
+
+	// levels read by the loader thread, empty when reading failed
+	struct LOAD_RESULT
+	{
+		int texture;
+		int firstLevel;
+		unsigned int generation;
+		std::vector<MIP_LEVEL> levels;
+	};
+
+	// one streamed texture
+	struct STREAMED_TEXTURE
+	{
+		std::string filename;
+		GLuint ID;
+		int width;
+		int height;
+		int channels;
+		int levelCount;
+		// coarsest levels uploaded up front and never evicted
+		int pinnedLevel;
+		// finest level uploaded, every coarser one is resident too
+		int residentLevel;
+		// finest level asked for since the last Update(), or
+		// levelCount when none was
+		std::atomic<int> requestedLevel;
+		// finest level the streamer is working toward
+		int targetLevel;
+		// true while the loader thread reads levels, which are
+		// counted against the budget from the request on
+		bool bLoading;
+		size_t loadingBytes;
+		// Update() call in which the texture was last asked for
+		unsigned int lastUsedUpdate;
+		// number of reloads, so loads of the old image are dropped
+		unsigned int generation;
+	};
+
+	STREAMED_TEXTURE m_textures[MAX_TEXTURES];
+	int m_textureCount;
+	// GPU memory allowed, used by the resident levels, and held
+	// for the levels being loaded
+	size_t m_budgetBytes;
+	size_t m_residentBytes;
+	size_t m_loadingBytes;
+	// number of Update() calls
+	unsigned int m_updateCount;
+
+	// loader thread and the queues guarded by the mutex
+	std::thread m_loaderThread;
+	std::mutex m_mutex;
+	std::condition_variable m_condition;
+	std::vector<LOAD_REQUEST> m_requests;
+	std::vector<LOAD_RESULT> m_results;
+	bool m_bStopRequested;
+
+	// body of the loader thread
+	void LoaderThreadMain();
+	// read the image file and downsample it to the requested levels
+	static bool ReadLevels(const LOAD_REQUEST& request, std::vector<MIP_LEVEL>& levels);
+	// downsample a full size image to a run of levels
+	static void BuildLevels(
+		const uint8_t* pPixels,
+		int width,
+		int height,
+		int channels,
+		int firstLevel,
+		int lastLevel,
+		std::vector<MIP_LEVEL>& levels);
+	// average 2x2 blocks of a level into the next coarser one
+	static void DownsampleLevel(const uint8_t* pPixels, int width, int height, int channels, MIP_LEVEL& level);
+	// GPU memory of a run of levels
+	static size_t GetLevelBytes(const STREAMED_TEXTURE& texture, int firstLevel, int endLevel);
+
+	// set the size of a texture from its full size image and
+	// upload its pinned levels
+	void DefineLevels(int textureIndex, const uint8_t* pPixels, int width, int height, int channels);
+
+	// upload levels ending at the resident one and make them resident
+	void UploadLevels(int textureIndex, int firstLevel, const std::vector<MIP_LEVEL>& levels);
+	// drop the levels finer than residentLevel
+	void EvictLevels(int textureIndex, int residentLevel);
+	// evict levels of the other textures until bytes fit in the budget
+	void MakeRoom(int textureIndex, size_t bytes);
+
+public:
+	// add a texture from its decoded full size image, uploading the
+	// pinned levels - returns the texture ID, or 0 on failure
+	GLuint AddTexture(const char* filename, const uint8_t* pPixels, int width, int height, int channels);
+	// replace the image of a texture after its file changed, keeping
+	// its ID - the size may change, returns false on a bad image
+	bool ReloadTexture(int textureIndex, const uint8_t* pPixels, int width, int height, int channels);
+	// delete every texture
+	void DestroyTextures();
+
+	// find the texture loaded from a file, or -1
+	int FindTexture(const char* filename) const;
+	int GetTextureCount() const;
+	const char* GetFilename(int textureIndex) const;
+
+	// ask for the level that draws a texture about texelsAcross
+	// texels wide - safe to call from any thread
+	void RequestSize(int textureIndex, float texelsAcross);
+	// upload the finished loads, then evict and start loads to
+	// follow the requests - call once per frame on the GL thread
+	void Update();
+
+	void SetBudget(size_t budgetBytes);
+	size_t GetBudgetBytes() const;
+	size_t GetResidentBytes() const;
+	int GetResidentLevel(int textureIndex) const;
+	// true while the loader thread reads levels
+	bool IsLoading() const;
+};
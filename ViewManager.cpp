@@ -14,6 +14,8 @@
 #include <glm/gtx/transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <atomic>
+
 
 
 
@@ -24,11 +26,48 @@ namespace
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
-
-
-
+	constexpr StringId g_ViewName = "view"_id;
+	constexpr StringId g_ProjectionName = "projection"_id;
+
+	// uniforms set once per frame, their locations are looked up
+	// the first time a view is applied
+	const char* const g_ViewUniformNames[] = {
+		"view",
+		"projection",
+		"viewPosition",
+		"light.position",
+		"light.direction",
+		"light.cutOff",
+		"light.outerCutOff",
+		"light.ambient",
+		"light.diffuse",
+		"light.specular",
+		"light.constant",
+		"light.linear",
+		"light.quadratic",
+		"pointLights[0].position",
+		"pointLights[0].ambient",
+		"pointLights[0].diffuse",
+		"pointLights[0].specular",
+		"pointLights[0].constant",
+		"pointLights[0].linear",
+		"pointLights[0].quadratic"
+	};
+
+
+
+
+	// fixed point light of the scene
+	const POINT_LIGHT g_ScenePointLight =
+	{
+		glm::vec3(2.0f, 2.0f, 2.0f),
+		glm::vec3(0.2f, 0.0f, 0.2f), // Dim purple
+		glm::vec3(0.5f, 0.0f, 0.5f), // Stronger purple
+		glm::vec3(0.8f, 0.0f, 0.8f),
+		1.0f,
+		0.09f,
+		0.032f
+	};
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -46,6 +85,29 @@ namespace
 	// the following variable is false when orthographic projection
 	// is off and true when it is on
 	bool bOrthographicProjection = false;
+
+	// true when the window is split into four views
+	bool bQuadViews = false;
+	// point the top and side views look at, and the half height of
+	// the scene area they show
+	const glm::vec3 g_OverviewTarget = glm::vec3(0.5f, 0.5f, 1.0f);
+	const float g_OverviewHalfSize = 3.0f;
+	// distance of the top and side cameras from the target
+	const float g_OverviewDistance = 20.0f;
+
+	// set when something changed that needs a new frame drawn
+	std::atomic<bool> gRedrawRequested(true);
+
+	// current size of the display framebuffer in pixels
+	int gFramebufferWidth = WINDOW_WIDTH;
+	int gFramebufferHeight = WINDOW_HEIGHT;
+
+	// set by a left click until the render loop picks the object
+	// under the cursor, at the clicked point in normalized device
+	// coordinates
+	bool gPickRequested = false;
+	float gPickNdcX = 0.0f;
+	float gPickNdcY = 0.0f;
 }
 
 /***********************************************************
@@ -117,6 +179,16 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 
 	glfwSetScrollCallback(m_pWindow, &ViewManager::Mouse_Scroll_Callback);
 
+	// these callbacks are used to wake the on-demand render loop
+	glfwSetKeyCallback(m_pWindow, &ViewManager::Key_Callback);
+	glfwSetFramebufferSizeCallback(m_pWindow, &ViewManager::Framebuffer_Size_Callback);
+
+	// this callback is used to pick the object under the cursor
+	glfwSetMouseButtonCallback(m_pWindow, &ViewManager::Mouse_Button_Callback);
+
+	// the framebuffer can differ from the window size on high-DPI displays
+	glfwGetFramebufferSize(m_pWindow, &gFramebufferWidth, &gFramebufferHeight);
+
 	// enable blending for supporting tranparent rendering
 	glEnable(GL_BLEND);
 	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
@@ -134,8 +206,19 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
  ***********************************************************/
 void ViewManager::Mouse_Position_Callback(GLFWwindow* window, double xMousePos, double yMousePos)
 {
+	UpdateCameraFromMouse(xMousePos, yMousePos);
 
+	RequestRedraw();
+}
 
+/***********************************************************
+ *  UpdateCameraFromMouse()
+ *
+ *  This method is used for turning the camera by how far
+ *  the mouse moved since the last call.
+ ***********************************************************/
+void ViewManager::UpdateCameraFromMouse(double xMousePos, double yMousePos)
+{
 	//ChrisK Code here
 
 	static bool firstMouse = true; //initializing a mouse tracking state on first movement
@@ -189,6 +272,135 @@ void ViewManager::Mouse_Scroll_Callback(GLFWwindow* window, double xoffset, doub
 		movementSpeed = 0.01f;
 	if (movementSpeed > 1.0f)
 		movementSpeed = 1.0f;
+
+	RequestRedraw();
+}
+
+/***********************************************************
+ *  Key_Callback()
+ *
+ *  This method is automatically called from GLFW whenever a
+ *  key is pressed, repeated or released.  The key states are
+ *  read in ProcessKeyboardEvents(), so this only wakes the
+ *  render loop.
+ ***********************************************************/
+void ViewManager::Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods)
+{
+	RequestRedraw();
+}
+
+/***********************************************************
+ *  Framebuffer_Size_Callback()
+ *
+ *  This method is automatically called from GLFW whenever
+ *  the framebuffer of the display window is resized.
+ ***********************************************************/
+void ViewManager::Framebuffer_Size_Callback(GLFWwindow* window, int width, int height)
+{
+	gFramebufferWidth = width;
+	gFramebufferHeight = height;
+	RequestRedraw();
+}
+
+/***********************************************************
+ *  Mouse_Button_Callback()
+ *
+ *  This method is automatically called from GLFW whenever a
+ *  mouse button is pressed or released.  A left click records
+ *  the cursor in normalized device coordinates, which are the
+ *  same for the window and the framebuffer on high-DPI displays.
+ ***********************************************************/
+void ViewManager::Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods)
+{
+	double xCursorPos = 0.0;
+	double yCursorPos = 0.0;
+	int windowWidth = 0;
+	int windowHeight = 0;
+
+	if ((button != GLFW_MOUSE_BUTTON_LEFT) || (action != GLFW_PRESS))
+	{
+		return;
+	}
+
+	glfwGetCursorPos(window, &xCursorPos, &yCursorPos);
+	glfwGetWindowSize(window, &windowWidth, &windowHeight);
+	if ((windowWidth <= 0) || (windowHeight <= 0))
+	{
+		return;
+	}
+
+	// window coordinates start at the top left corner
+	gPickNdcX = (float)((2.0 * xCursorPos / windowWidth) - 1.0);
+	gPickNdcY = (float)(1.0 - (2.0 * yCursorPos / windowHeight));
+	gPickRequested = true;
+	RequestRedraw();
+}
+
+/***********************************************************
+ *  GetFramebufferSize()
+ *
+ *  This method is used for getting the current size of the
+ *  display framebuffer in pixels.
+ ***********************************************************/
+void ViewManager::GetFramebufferSize(int& width, int& height)
+{
+	width = gFramebufferWidth;
+	height = gFramebufferHeight;
+}
+
+/***********************************************************
+ *  RequestRedraw()
+ *
+ *  This method is used for asking the render loop for a new
+ *  frame from the GL thread.  The input callbacks run inside
+ *  glfwWaitEvents() or glfwPollEvents(), and the loop looks
+ *  at the request once they return, so no event is posted.
+ ***********************************************************/
+void ViewManager::RequestRedraw()
+{
+	gRedrawRequested = true;
+}
+
+/***********************************************************
+ *  PostRedrawFromThread()
+ *
+ *  This method is used for asking the render loop for a new
+ *  frame from another thread, posting an empty event to wake
+ *  it if it is blocked in glfwWaitEvents().
+ ***********************************************************/
+void ViewManager::PostRedrawFromThread()
+{
+	gRedrawRequested = true;
+	glfwPostEmptyEvent();
+}
+
+/***********************************************************
+ *  ConsumeRedrawRequest()
+ *
+ *  This method is used for taking the pending redraw request.
+ ***********************************************************/
+bool ViewManager::ConsumeRedrawRequest()
+{
+	return(gRedrawRequested.exchange(false));
+}
+
+/***********************************************************
+ *  ConsumePickRequest()
+ *
+ *  This method is used for taking the pending pick request
+ *  made by a left click.
+ ***********************************************************/
+bool ViewManager::ConsumePickRequest(float& ndcX, float& ndcY)
+{
+	if (gPickRequested == false)
+	{
+		return(false);
+	}
+
+	ndcX = gPickNdcX;
+	ndcY = gPickNdcY;
+	gPickRequested = false;
+	return(true);
 }
 
 /***********************************************************
@@ -222,12 +434,29 @@ void ViewManager::ProcessKeyboardEvents()
 	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
 		g_pCamera->Position.y -= velocity;
 
+	// keep drawing while a movement key is held down
+	if ((glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS) ||
+		(glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS) ||
+		(glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS) ||
+		(glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS) ||
+		(glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS) ||
+		(glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS))
+	{
+		RequestRedraw();
+	}
+
 	// Projection toggle
 	if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS) //if key pressed is p, perspective view
 		bOrthographicProjection = false;
 	if (glfwGetKey(m_pWindow, GLFW_KEY_O) == GLFW_PRESS) //if key pressed is o, orthographic view
 		bOrthographicProjection = true;
 
+	// view layout toggle
+	if (glfwGetKey(m_pWindow, GLFW_KEY_1) == GLFW_PRESS) //if key pressed is 1, the main view alone
+		bQuadViews = false;
+	if (glfwGetKey(m_pWindow, GLFW_KEY_4) == GLFW_PRESS) //if key pressed is 4, four views
+		bQuadViews = true;
+
 }
 
 /***********************************************************
@@ -239,23 +468,40 @@ void ViewManager::ProcessKeyboardEvents()
  ***********************************************************/
 void ViewManager::PrepareSceneView()
 {
-	glm::mat4 view;
-	glm::mat4 projection;
+	VIEW_STATE viewState;
+
+	UpdateViewState(viewState);
+	ApplyViewState(viewState);
+}
+
+/***********************************************************
+ *  UpdateViewState()
+ *
+ *  This method is used for processing the waiting input and
+ *  capturing the camera matrices for the next frame.  It only
+ *  touches the camera and GLFW, so it must be called from the
+ *  thread that owns the display window.
+ ***********************************************************/
+void ViewManager::UpdateViewState(VIEW_STATE& viewState)
+{
+	// a minimized window reports a zero height, keep the last aspect
+	static float aspectRatio = (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT;
+	if ((gFramebufferWidth > 0) && (gFramebufferHeight > 0))
+	{
+		aspectRatio = (float)gFramebufferWidth / (float)gFramebufferHeight;
+	}
 
 	if (bOrthographicProjection)
 	{
 		float scale = 2.0f; //Defining an orthographic projection box
-		projection = glm::ortho(-scale, scale, -scale, scale, 0.1f, 100.0f); //used for a 2D style flat projection
+		viewState.projection = glm::ortho(-scale * aspectRatio, scale * aspectRatio, -scale, scale, 0.1f, 100.0f); //used for a 2D style flat projection
 	}
 	else
 	{
-		projection = glm::perspective(glm::radians(g_pCamera->Zoom), 800.0f / 600.0f, 0.1f, 100.0f); //Defines a perspective projection matrix
+		viewState.projection = glm::perspective(glm::radians(g_pCamera->Zoom), aspectRatio, 0.1f, 100.0f); //Defines a perspective projection matrix
 		//Used for a realistic 3D perspective
 	}
 
-	//view = glm::lookAt(g_pCamera->Position, g_pCamera->Position + g_pCamera->Front, g_pCamera->Up);
-
-
 	// per-frame timing
 	float currentFrame = glfwGetTime();
 	gDeltaTime = currentFrame - gLastFrame;
@@ -266,46 +512,206 @@ void ViewManager::PrepareSceneView()
 	ProcessKeyboardEvents();
 
 	// get the current view matrix from the camera
-	view = g_pCamera->GetViewMatrix();
+	viewState.view = g_pCamera->GetViewMatrix();
+	viewState.cameraPosition = g_pCamera->Position;
+	viewState.cameraFront = g_pCamera->Front;
+	viewState.inputTime = currentFrame;
+	viewState.viewportHeight = gFramebufferHeight;
+}
+
+/***********************************************************
+ *  UpdateViewSet()
+ *
+ *  This method is used for capturing the views of the next
+ *  frame.  In the quad layout the main camera keeps the top
+ *  left quarter, and the other quarters show it with the
+ *  other projection and the scene from above and from the
+ *  side.  Each quarter has the aspect ratio of the window,
+ *  so the main projection is reused, and every view keeps
+ *  the main camera's position and direction for the lights
+ *  that follow it.
+ ***********************************************************/
+void ViewManager::UpdateViewSet(VIEW_SET& viewSet)
+{
+	UpdateViewState(viewSet.views[0]);
+	viewSet.viewports[0] = glm::vec4(0.0f, 0.0f, 1.0f, 1.0f);
+	viewSet.viewCount = 1;
+
+	if (bQuadViews == false)
+	{
+		return;
+	}
+
+	VIEW_STATE& mainView = viewSet.views[0];
+	mainView.viewportHeight = gFramebufferHeight / 2;
+
+	float aspectRatio = mainView.projection[1][1] / mainView.projection[0][0];
+	glm::mat4 overviewProjection = glm::ortho(
+		-g_OverviewHalfSize * aspectRatio, g_OverviewHalfSize * aspectRatio,
+		-g_OverviewHalfSize, g_OverviewHalfSize,
+		0.1f, g_OverviewDistance * 2.0f);
+
+	for (int i = 1; i < VIEW_SET::MAX_VIEWS; i++)
+	{
+		viewSet.views[i] = mainView;
+	}
+
+	// the main camera with the projection it is not using
+	if (bOrthographicProjection)
+	{
+		viewSet.views[1].projection = glm::perspective(glm::radians(g_pCamera->Zoom), aspectRatio, 0.1f, 100.0f);
+	}
+	else
+	{
+		float scale = 2.0f;
+		viewSet.views[1].projection = glm::ortho(-scale * aspectRatio, scale * aspectRatio, -scale, scale, 0.1f, 100.0f);
+	}
 
+	// looking down with -Z up, and along -X from the right side
+	viewSet.views[2].view = glm::lookAt(
+		g_OverviewTarget + glm::vec3(0.0f, g_OverviewDistance, 0.0f),
+		g_OverviewTarget,
+		glm::vec3(0.0f, 0.0f, -1.0f));
+	viewSet.views[2].projection = overviewProjection;
+	viewSet.views[3].view = glm::lookAt(
+		g_OverviewTarget + glm::vec3(g_OverviewDistance, 0.0f, 0.0f),
+		g_OverviewTarget,
+		glm::vec3(0.0f, 1.0f, 0.0f));
+	viewSet.views[3].projection = overviewProjection;
+
+	viewSet.viewports[0] = glm::vec4(0.0f, 0.5f, 0.5f, 0.5f);
+	viewSet.viewports[1] = glm::vec4(0.5f, 0.5f, 0.5f, 0.5f);
+	viewSet.viewports[2] = glm::vec4(0.0f, 0.0f, 0.5f, 0.5f);
+	viewSet.viewports[3] = glm::vec4(0.5f, 0.0f, 0.5f, 0.5f);
+	viewSet.viewCount = VIEW_SET::MAX_VIEWS;
+}
+
+/***********************************************************
+ *  SetQuadViews()
+ *
+ *  This method is used for choosing between the main view
+ *  alone and the four view layout.
+ ***********************************************************/
+void ViewManager::SetQuadViews(bool bQuad)
+{
+	bQuadViews = bQuad;
+	RequestRedraw();
+}
+
+/***********************************************************
+ *  ApplyViewState()
+ *
+ *  This method is used for setting a captured camera state
+ *  into the shader for rendering the matching frame.
+ ***********************************************************/
+void ViewManager::ApplyViewState(const VIEW_STATE& viewState)
+{
 	// if the shader manager object is valid
 	if (NULL != m_pShaderManager)
 	{
+		// the shader is active by the first frame
+		if (m_uniforms.IsLoaded() == false)
+		{
+			m_uniforms.Load(g_ViewUniformNames, sizeof(g_ViewUniformNames) / sizeof(g_ViewUniformNames[0]));
+		}
+
 		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
+		m_uniforms.SetMat4(g_ViewName, viewState.view);
 		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
+		m_uniforms.SetMat4(g_ProjectionName, viewState.projection);
 		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
-		SetupSceneLights(g_pCamera->Position);
+		m_uniforms.SetVec3("viewPosition"_id, viewState.cameraPosition);
+		SetupSceneLights(viewState.cameraPosition, viewState.cameraFront);
 	}
 }
-void ViewManager::SetupSceneLights(const glm::vec3& camPosition) //Chris K Extraneous Light setup Code here
+void ViewManager::SetupSceneLights(const glm::vec3& camPosition, const glm::vec3& camFront) //Chris K Extraneous Light setup Code here
 {
 	if (!m_pShaderManager)
 		return;
 
 	
-	m_pShaderManager->setVec3Value("light.position", g_pCamera->Position); //Spotlight properties (coming from camera)
-	m_pShaderManager->setVec3Value("light.direction", g_pCamera->Front);
-	m_pShaderManager->setFloatValue("light.cutOff", glm::cos(glm::radians(12.5f)));
-	m_pShaderManager->setFloatValue("light.outerCutOff", glm::cos(glm::radians(15.0f)));
+	m_uniforms.SetVec3("light.position"_id, camPosition); //Spotlight properties (coming from camera)
+	m_uniforms.SetVec3("light.direction"_id, camFront);
+	m_uniforms.SetFloat("light.cutOff"_id, glm::cos(glm::radians(12.5f)));
+	m_uniforms.SetFloat("light.outerCutOff"_id, glm::cos(glm::radians(15.0f)));
 
 	
-	m_pShaderManager->setVec3Value("light.ambient", glm::vec3(0.1f)); //Spotlight color
-	m_pShaderManager->setVec3Value("light.diffuse", glm::vec3(0.8f));
-	m_pShaderManager->setVec3Value("light.specular", glm::vec3(1.0f));
+	m_uniforms.SetVec3("light.ambient"_id, glm::vec3(0.1f)); //Spotlight color
+	m_uniforms.SetVec3("light.diffuse"_id, glm::vec3(0.8f));
+	m_uniforms.SetVec3("light.specular"_id, glm::vec3(1.0f));
 
 	
-	m_pShaderManager->setFloatValue("light.constant", 1.0f); //Attenuation
-	m_pShaderManager->setFloatValue("light.linear", 0.09f);
-	m_pShaderManager->setFloatValue("light.quadratic", 0.032f);
-
-	m_pShaderManager->setVec3Value("pointLights[0].position", glm::vec3(2.0f, 2.0f, 2.0f));
-	m_pShaderManager->setVec3Value("pointLights[0].ambient", glm::vec3(0.2f, 0.0f, 0.2f)); // Dim purple
-	m_pShaderManager->setVec3Value("pointLights[0].diffuse", glm::vec3(0.5f, 0.0f, 0.5f)); // Stronger purple
-	m_pShaderManager->setVec3Value("pointLights[0].specular", glm::vec3(0.8f, 0.0f, 0.8f));
-	m_pShaderManager->setFloatValue("pointLights[0].constant", 1.0f);
-	m_pShaderManager->setFloatValue("pointLights[0].linear", 0.09f);
-	m_pShaderManager->setFloatValue("pointLights[0].quadratic", 0.032f);
-}
\ No newline at end of file
+	m_uniforms.SetFloat("light.constant"_id, 1.0f); //Attenuation
+	m_uniforms.SetFloat("light.linear"_id, 0.09f);
+	m_uniforms.SetFloat("light.quadratic"_id, 0.032f);
+
+	m_uniforms.SetVec3("pointLights[0].position"_id, g_ScenePointLight.position);
+	m_uniforms.SetVec3("pointLights[0].ambient"_id, g_ScenePointLight.ambient);
+	m_uniforms.SetVec3("pointLights[0].diffuse"_id, g_ScenePointLight.diffuse);
+	m_uniforms.SetVec3("pointLights[0].specular"_id, g_ScenePointLight.specular);
+	m_uniforms.SetFloat("pointLights[0].constant"_id, g_ScenePointLight.constant);
+	m_uniforms.SetFloat("pointLights[0].linear"_id, g_ScenePointLight.linear);
+	m_uniforms.SetFloat("pointLights[0].quadratic"_id, g_ScenePointLight.quadratic);
+}
+
+/***********************************************************
+ *  ReloadShaderInputs()
+ *
+ *  This method is used for looking up the locations of the
+ *  camera and light uniforms in a relinked shader program.
+ ***********************************************************/
+void ViewManager::ReloadShaderInputs()
+{
+	m_uniforms.Load(g_ViewUniformNames, sizeof(g_ViewUniformNames) / sizeof(g_ViewUniformNames[0]));
+}
+
+/***********************************************************
+ *  GetScenePointLight()
+ *
+ *  This method is used for getting the fixed point light,
+ *  so the static lighting can be baked with the same values
+ *  the shader is given.
+ ***********************************************************/
+const POINT_LIGHT& ViewManager::GetScenePointLight()
+{
+	return(g_ScenePointLight);
+}
+
+/***********************************************************
+ *  RunMicroBenchmarks()
+ *
+ *  This method is used for timing the light setup done for
+ *  every frame and the camera math run for every mouse
+ *  move, without the redraw request of the callback.  The
+ *  camera moves with each call, and is put back the way it
+ *  was afterwards.
+ ***********************************************************/
+void ViewManager::RunMicroBenchmarks(MicroBenchmark& benchmark)
+{
+	if (m_uniforms.IsLoaded() == false)
+	{
+		m_uniforms.Load(g_ViewUniformNames, sizeof(g_ViewUniformNames) / sizeof(g_ViewUniformNames[0]));
+	}
+
+	benchmark.Run("ViewManager::SetupSceneLights", [&](size_t i)
+	{
+		float angle = glm::radians((float)(i % 360));
+		SetupSceneLights(
+			glm::vec3(cos(angle) * 10.0f, 2.0f, sin(angle) * 10.0f),
+			glm::vec3(-cos(angle), 0.0f, -sin(angle)));
+	});
+
+	// the mouse circles the middle of the window
+	float yaw = g_pCamera->Yaw;
+	float pitch = g_pCamera->Pitch;
+	glm::vec3 front = g_pCamera->Front;
+	benchmark.Run("ViewManager::UpdateCameraFromMouse", [&](size_t i)
+	{
+		float angle = glm::radians((float)(i % 360));
+		UpdateCameraFromMouse(400.0 + cos(angle) * 50.0, 300.0 + sin(angle) * 50.0);
+		benchmark.Consume(g_pCamera->Front.x);
+	});
+	g_pCamera->Yaw = yaw;
+	g_pCamera->Pitch = pitch;
+	g_pCamera->Front = front;
+}
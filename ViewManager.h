@@ -10,8 +10,12 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "ShaderUniforms.h"
+#include "MicroBenchmark.h"
 #include "camera.h"
 
+#include <glm/glm.hpp>
+
 // GLFW library
 #include "GLFW/glfw3.h" 
 
@@ -20,6 +24,60 @@ enum class ProjectionMode { //enum declaration for perspective toggling
 	Orthographic
 };
 
+/***********************************************************
+ *  VIEW_STATE
+ *
+ *  Snapshot of the camera for one frame, captured on the
+ *  GL thread and handed to the scene update thread.
+ ***********************************************************/
+struct VIEW_STATE
+{
+	glm::mat4 view;
+	glm::mat4 projection;
+	glm::vec3 cameraPosition;
+	glm::vec3 cameraFront;
+	// glfwGetTime() when the input behind this view was polled
+	double inputTime;
+	// height in pixels of the framebuffer the view is drawn into,
+	// used to estimate the projected size of the objects
+	int viewportHeight;
+};
+
+/***********************************************************
+ *  VIEW_SET
+ *
+ *  Views drawn together in one frame, each with its own
+ *  camera and its own rectangle of the framebuffer.
+ ***********************************************************/
+struct VIEW_SET
+{
+	static const int MAX_VIEWS = 4;
+
+	VIEW_STATE views[MAX_VIEWS];
+	// rectangle of each view as x, y, width and height in fractions
+	// of the framebuffer, starting from the bottom left corner
+	glm::vec4 viewports[MAX_VIEWS];
+	int viewCount;
+};
+
+/***********************************************************
+ *  POINT_LIGHT
+ *
+ *  Fixed point light of the scene, set into the shader every
+ *  frame for the dynamic objects and baked into the static
+ *  ones.
+ ***********************************************************/
+struct POINT_LIGHT
+{
+	glm::vec3 position;
+	glm::vec3 ambient;
+	glm::vec3 diffuse;
+	glm::vec3 specular;
+	float constant;
+	float linear;
+	float quadratic;
+};
+
 class ViewManager
 {
 public:
@@ -34,10 +92,32 @@ public:
 
 	//Chris K edit here
 	static void Mouse_Scroll_Callback(GLFWwindow* window, double xoffset, double yoffset); //Callback function to increase/decrease movement of camera movement speed based on mouse scrolling
-	void SetupSceneLights(const glm::vec3& camPosition);
+	// key and framebuffer size callbacks, used to wake the on-demand render loop
+	static void Key_Callback(GLFWwindow* window, int key, int scancode, int action, int mods);
+	static void Framebuffer_Size_Callback(GLFWwindow* window, int width, int height);
+	// mouse button callback, a left click asks for the object under the cursor
+	static void Mouse_Button_Callback(GLFWwindow* window, int button, int action, int mods);
+	// size of the display framebuffer in pixels, as last reported
+	static void GetFramebufferSize(int& width, int& height);
 
-private:
+	// ask the on-demand render loop for a new frame - call on the GL
+	// thread, e.g. from the input callbacks or while an animation plays
+	static void RequestRedraw();
+	// ask for a new frame from another thread, e.g. when an asset
+	// finishes loading, and wake the render loop if it is blocked
+	static void PostRedrawFromThread();
+	// take the pending redraw request, true when there was one
+	static bool ConsumeRedrawRequest();
+	// take the pending pick request, true when there was one, with
+	// the clicked point in normalized device coordinates
+	static bool ConsumePickRequest(float& ndcX, float& ndcY);
+	void SetupSceneLights(const glm::vec3& camPosition, const glm::vec3& camFront);
+	// the fixed point light of the scene
+	static const POINT_LIGHT& GetScenePointLight();
 
+private:
+	// turn the camera by the mouse movement since the last call
+	static void UpdateCameraFromMouse(double xMousePos, double yMousePos);
 
 	//Chris K Code here
 	float lastX = 400.0f;
@@ -49,6 +129,8 @@ private:
 	ProjectionMode m_projectionMode = ProjectionMode::Perspective; //private var for handling projection mode
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// locations of the view and light uniforms
+	ShaderUniforms m_uniforms;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
 
@@ -63,4 +145,21 @@ public:
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+	// process input and capture the camera matrices for this frame
+	void UpdateViewState(VIEW_STATE& viewState);
+	// process input and capture the cameras of every view drawn
+	// this frame, the first one being UpdateViewState()'s
+	void UpdateViewSet(VIEW_SET& viewSet);
+	// set the captured camera matrices and lights into the shader
+	void ApplyViewState(const VIEW_STATE& viewState);
+	// draw the main view alone, or split the window into the main
+	// view, the main camera with the other projection, and top and
+	// side views - also toggled with the 1 and 4 keys
+	void SetQuadViews(bool bQuad);
+	// look up the camera and light uniforms again after the active
+	// shader program was relinked
+	void ReloadShaderInputs();
+	// time the per-frame light setup and the mouse look camera math -
+	// needs the shader program active and the display window
+	void RunMicroBenchmarks(MicroBenchmark& benchmark);
 };
\ No newline at end of file